@@ -5,10 +5,17 @@
 #include <sys/types.h>  // ssize_t
 #include <algorithm>
 #include <limits>
+#include <numeric>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
 namespace common::utils {
 
 template <typename T>
@@ -16,6 +23,40 @@ static constexpr T infinity() {
     return std::numeric_limits<T>::max();
 }
 
+// number of features of the kernels that are only known at runtime
+inline constexpr std::size_t dynamic_n_features = 0;
+
+template <std::size_t NFeatures>
+using NFeaturesConstant = std::integral_constant<std::size_t, NFeatures>;
+
+/**
+ * @brief Calls function with NFeaturesConstant<n_features> if n_features is one of the common dimensions that have
+ * kernels specialized at compile time (fixed trip counts that the compiler fully unrolls and keeps in registers), or
+ * with NFeaturesConstant<dynamic_n_features> otherwise.
+ *
+ * @tparam Function callable with a NFeaturesConstant
+ * @param n_features
+ * @param function
+ * @return decltype(auto) the result of function
+ */
+template <typename Function>
+decltype(auto) dispatch_n_features(std::size_t n_features, Function&& function) {
+    switch (n_features) {
+        case 2:
+            return function(NFeaturesConstant<2>{});
+        case 3:
+            return function(NFeaturesConstant<3>{});
+        case 4:
+            return function(NFeaturesConstant<4>{});
+        case 8:
+            return function(NFeaturesConstant<8>{});
+        case 16:
+            return function(NFeaturesConstant<16>{});
+        default:
+            return function(NFeaturesConstant<dynamic_n_features>{});
+    }
+}
+
 inline void xor_swap(std::size_t* lhs, std::size_t* rhs) {
     // no swap if both variables share same memory
     if (lhs != rhs) {
@@ -408,6 +449,184 @@ void min_container_inplace_left(Container& lhs, const Container& rhs) {
         lhs.begin(), lhs.end(), rhs.begin(), lhs.begin(), [](const auto& x, const auto& y) { return x < y ? x : y; });
 }
 
+/**
+ * @brief Whether a decreasing loss trajectory cannot reasonably end below best_loss. Assumes that the loss improvements
+ * decay geometrically, which bounds what remains to be gained by improvement * ratio / (1 - ratio). The ratio is the
+ * slowest decay of the last 3 improvements and the bound is doubled to stay on the safe side of noisy trajectories.
+ * Needs at least 4 losses and decaying improvements to conclude, or a last step that left the loss unchanged.
+ *
+ * @tparam Iterator
+ * @param losses_first the losses of each step, in order
+ * @param losses_last
+ * @param best_loss
+ * @return true if the extrapolated final loss is still above best_loss
+ */
+template <typename Iterator>
+bool is_loss_trajectory_dominated(const Iterator&                      losses_first,
+                                  const Iterator&                      losses_last,
+                                  const typename Iterator::value_type& best_loss) {
+    using DataType = typename Iterator::value_type;
+
+    if (std::distance(losses_first, losses_last) < 4) {
+        return false;
+    }
+    const DataType loss                 = *(losses_last - 1);
+    const DataType last_improvement     = *(losses_last - 2) - loss;
+    const DataType previous_improvement = *(losses_last - 3) - *(losses_last - 2);
+    const DataType older_improvement    = *(losses_last - 4) - *(losses_last - 3);
+
+    if (last_improvement < 0) {
+        // the loss went up so the trajectory can't be extrapolated
+        return false;
+    }
+    if (last_improvement == 0) {
+        // the candidate has converged
+        return loss > best_loss;
+    }
+    if (previous_improvement <= last_improvement || older_improvement <= previous_improvement) {
+        // the improvements are not decaying (yet)
+        return false;
+    }
+    const DataType ratio =
+        std::max(last_improvement / previous_improvement, previous_improvement / older_improvement);
+
+    return loss - 2 * last_improvement * ratio / (1 - ratio) > best_loss;
+}
+
+// whether the algorithm pointed to by AlgorithmPtr reports how much its candidate moved during the last step
+template <typename AlgorithmPtr, typename = void>
+struct has_max_centroid_shift : std::false_type {};
+
+template <typename AlgorithmPtr>
+struct has_max_centroid_shift<AlgorithmPtr, std::void_t<decltype(std::declval<AlgorithmPtr&>()->max_centroid_shift())>>
+  : std::true_type {};
+
+// whether the algorithm pointed to by AlgorithmPtr can recompute an exact loss when total_deviation() is only an
+// estimate
+template <typename AlgorithmPtr, typename = void>
+struct has_exact_total_deviation : std::false_type {};
+
+template <typename AlgorithmPtr>
+struct has_exact_total_deviation<AlgorithmPtr,
+                                 std::void_t<decltype(std::declval<AlgorithmPtr&>()->exact_total_deviation())>>
+  : std::true_type {};
+
+/**
+ * @brief Runs the candidates algorithms in lockstep: each round steps all the remaining candidates in parallel, then
+ * stops the candidates that converged and the ones whose loss trajectory is dominated by the lowest loss so far. The
+ * threads of the stopped candidates go to the next rounds so that a single remaining candidate runs with all of them.
+ *
+ * @tparam AlgorithmPtr pointer to an algorithm with step() and total_deviation() member functions. The candidates are
+ * compared with exact_total_deviation() instead if the algorithm provides it
+ * @tparam Candidate container returned by step()
+ * @param algorithms
+ * @param candidates the initial candidates, updated with the last step of each candidate once it stops
+ * @param max_iter
+ * @param early_stopping stop a candidate once it doesnt move by more than tolerance for more than patience steps. The
+ * move is max_centroid_shift() if the algorithm provides it, the difference between two consecutive step() results
+ * otherwise
+ * @param patience
+ * @param tolerance
+ * @return the loss of each candidate when it was stopped
+ */
+template <typename AlgorithmPtr, typename Candidate>
+auto race_candidates(std::vector<AlgorithmPtr>&             algorithms,
+                     std::vector<Candidate>&                candidates,
+                     std::size_t                            max_iter,
+                     bool                                   early_stopping,
+                     std::size_t                            patience,
+                     const typename Candidate::value_type& tolerance = 0) {
+    using LossType = decltype(algorithms.front()->total_deviation());
+
+    const std::size_t n_candidates = candidates.size();
+
+    // the last step() result of the algorithms that return a reference to the candidate they own. It is only copied
+    // once the candidate stops
+    auto candidates_steps = std::vector<const Candidate*>(n_candidates);
+    auto patience_iters   = std::vector<std::size_t>(n_candidates);
+    auto has_converged    = std::vector<char>(n_candidates);
+
+    const auto candidate_loss = [&algorithms](std::size_t k) -> LossType {
+        if constexpr (has_exact_total_deviation<AlgorithmPtr>::value) {
+            return algorithms[k]->exact_total_deviation();
+        } else {
+            return algorithms[k]->total_deviation();
+        }
+    };
+    // the loss of each candidate after each step, starting with the initial loss
+    auto candidates_losses = std::vector<std::vector<LossType>>(n_candidates);
+
+    for (std::size_t k = 0; k < n_candidates; ++k) {
+        candidates_losses[k].emplace_back(candidate_loss(k));
+    }
+    auto active_candidates = std::vector<std::size_t>(n_candidates);
+    std::iota(active_candidates.begin(), active_candidates.end(), static_cast<std::size_t>(0));
+
+    const auto copy_candidates_steps = [&](auto active_candidates_first, auto active_candidates_last) {
+        for (; active_candidates_first != active_candidates_last; ++active_candidates_first) {
+            const std::size_t k = *active_candidates_first;
+
+            if (candidates_steps[k]) {
+                std::copy(candidates_steps[k]->begin(), candidates_steps[k]->end(), candidates[k].begin());
+            }
+        }
+    };
+
+    for (std::size_t iter = 0; iter < max_iter && !active_candidates.empty(); ++iter) {
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for schedule(dynamic) if (active_candidates.size() > 1)
+#endif
+        for (std::size_t active_index = 0; active_index < active_candidates.size(); ++active_index) {
+            const std::size_t k = active_candidates[active_index];
+
+            bool is_stalled = false;
+
+            if constexpr (has_max_centroid_shift<AlgorithmPtr>::value) {
+                candidates_steps[k] = &algorithms[k]->step();
+                is_stalled          = algorithms[k]->max_centroid_shift() <= tolerance;
+
+            } else {
+                auto candidate = algorithms[k]->step();
+                is_stalled     = are_containers_equal(candidate, candidates[k], tolerance);
+                candidates[k]  = std::move(candidate);
+            }
+            candidates_losses[k].emplace_back(candidate_loss(k));
+
+            if (early_stopping && is_stalled) {
+                has_converged[k] = patience_iters[k] == patience;
+                ++patience_iters[k];
+
+            } else {
+                patience_iters[k] = 0;
+            }
+        }
+        auto best_loss = infinity<LossType>();
+
+        for (const auto& losses : candidates_losses) {
+            best_loss = std::min(best_loss, losses.back());
+        }
+        // keep the candidates that can still end up with the lowest loss
+        const auto stopped_candidates_first =
+            std::stable_partition(active_candidates.begin(), active_candidates.end(), [&](const auto& k) {
+                return !has_converged[k] && !is_loss_trajectory_dominated(
+                                                candidates_losses[k].begin(), candidates_losses[k].end(), best_loss);
+            });
+
+        copy_candidates_steps(stopped_candidates_first, active_candidates.end());
+
+        active_candidates.erase(stopped_candidates_first, active_candidates.end());
+    }
+    // the candidates that reached max_iter
+    copy_candidates_steps(active_candidates.begin(), active_candidates.end());
+
+    auto final_losses = std::vector<LossType>(n_candidates);
+
+    for (std::size_t k = 0; k < n_candidates; ++k) {
+        final_losses[k] = candidates_losses[k].back();
+    }
+    return final_losses;
+}
+
 template <typename Iterator>
 typename Iterator::value_type argmin(const Iterator& data_first, const Iterator& data_last) {
     auto min_it = std::min_element(data_first, data_last);
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/containers/DatasetHandle.hpp"
+#include "cpp_clustering/heuristics/SimdDistances.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace cpp_clustering::containers {
+
+// alignment in bytes of the rows of a Dataset: a cache line and the width of an AVX-512 register
+inline constexpr std::size_t dataset_alignment = 64;
+
+template <typename T, std::size_t Alignment = dataset_alignment>
+class AlignedAllocator {
+    static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0,
+                  "The alignment should be a power of 2 at least as large as the alignment of T.");
+
+  public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n_elements) {
+        return static_cast<T*>(::operator new(n_elements * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* elements, std::size_t) noexcept {
+        ::operator delete(elements, std::align_val_t{Alignment});
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return false;
+    }
+};
+
+/**
+ * @brief Number of elements between the starts of two consecutive rows of a Dataset. Rows of at least
+ * dataset_alignment bytes are padded to a multiple of dataset_alignment bytes so that each of them starts on its own
+ * cache line and no vector load straddles two cache lines. Shorter rows are left packed: padding them would cost more
+ * extra arithmetic than the cache line splits it avoids.
+ *
+ * @tparam T
+ * @param n_features
+ * @return std::size_t
+ */
+template <typename T>
+std::size_t padded_n_features(std::size_t n_features) {
+    constexpr std::size_t alignment_n_elements = dataset_alignment / sizeof(T);
+
+    if (n_features < alignment_n_elements) {
+        return n_features;
+    }
+    return (n_features + alignment_n_elements - 1) / alignment_n_elements * alignment_n_elements;
+}
+
+/**
+ * @brief Owning n_samples x n_features row-major dataset whose rows are aligned and padded to
+ * padded_n_features(n_features) elements. The padding is zero-filled so that the distances, dot products and norms
+ * computed over the padded rows are the same as over the original ones, and the means of padded rows (e.g. the
+ * centroids) have a null padding as well. The views are DatasetHandle over the padded rows (their n_features is the
+ * padded number of features) and dont copy the samples.
+ *
+ * @tparam T
+ */
+template <typename T>
+class Dataset {
+    static_assert(std::is_floating_point_v<T>, "Dataset only allows floating point types.");
+
+  public:
+    using StorageType   = std::vector<T, AlignedAllocator<T>>;
+    using ConstIterator = typename StorageType::const_iterator;
+    using ViewType      = DatasetHandle<ConstIterator>;
+
+    template <typename Iterator>
+    Dataset(const Iterator& samples_first, const Iterator& samples_last, std::size_t n_features);
+
+    std::size_t n_samples() const {
+        return n_samples_;
+    }
+
+    std::size_t n_features() const {
+        return n_features_;
+    }
+
+    std::size_t padded_n_features() const {
+        return padded_n_features_;
+    }
+
+    const T* row(std::size_t sample_index) const {
+        return data_.data() + sample_index * padded_n_features_;
+    }
+
+    ConstIterator begin() const {
+        return data_.cbegin();
+    }
+
+    ConstIterator end() const {
+        return data_.cend();
+    }
+
+    ViewType view() const;
+
+    ViewType view(std::size_t sample_index_begin, std::size_t sample_index_end) const;
+
+    std::vector<T> pad_rows(const std::vector<T>& rows) const;
+
+    std::vector<T> remove_padding(const std::vector<T>& padded_rows) const;
+
+  private:
+    std::size_t n_samples_;
+    std::size_t n_features_;
+    std::size_t padded_n_features_;
+    // n_samples_ x padded_n_features_ vectorized matrix
+    StorageType data_;
+};
+
+template <typename T>
+template <typename Iterator>
+Dataset<T>::Dataset(const Iterator& samples_first, const Iterator& samples_last, std::size_t n_features)
+  : n_samples_{common::utils::get_n_samples(samples_first, samples_last, n_features)}
+  , n_features_{n_features}
+  , padded_n_features_{containers::padded_n_features<T>(n_features)}
+  , data_{StorageType(n_samples_ * padded_n_features_)} {
+    for (std::size_t sample_index = 0; sample_index < n_samples_; ++sample_index) {
+        std::copy(samples_first + sample_index * n_features_,
+                  samples_first + sample_index * n_features_ + n_features_,
+                  data_.begin() + sample_index * padded_n_features_);
+    }
+}
+
+template <typename T>
+typename Dataset<T>::ViewType Dataset<T>::view() const {
+    return view(0, n_samples_);
+}
+
+template <typename T>
+typename Dataset<T>::ViewType Dataset<T>::view(std::size_t sample_index_begin, std::size_t sample_index_end) const {
+    if (sample_index_begin > sample_index_end || sample_index_end > n_samples_) {
+        throw std::invalid_argument("The range of samples of the view should be within the dataset.");
+    }
+    return ViewType(data_.cbegin() + sample_index_begin * padded_n_features_,
+                    data_.cbegin() + sample_index_end * padded_n_features_,
+                    padded_n_features_);
+}
+
+/**
+ * @brief Copies n_features wide rows (e.g. centroids) to padded_n_features wide rows with a null padding so that they
+ * can be compared to the rows of the dataset.
+ */
+template <typename T>
+std::vector<T> Dataset<T>::pad_rows(const std::vector<T>& rows) const {
+    const std::size_t n_rows = rows.size() / n_features_;
+
+    auto padded_rows = std::vector<T>(n_rows * padded_n_features_);
+
+    for (std::size_t row_index = 0; row_index < n_rows; ++row_index) {
+        std::copy(rows.begin() + row_index * n_features_,
+                  rows.begin() + row_index * n_features_ + n_features_,
+                  padded_rows.begin() + row_index * padded_n_features_);
+    }
+    return padded_rows;
+}
+
+template <typename T>
+std::vector<T> Dataset<T>::remove_padding(const std::vector<T>& padded_rows) const {
+    const std::size_t n_rows = padded_rows.size() / padded_n_features_;
+
+    auto rows = std::vector<T>(n_rows * n_features_);
+
+    for (std::size_t row_index = 0; row_index < n_rows; ++row_index) {
+        std::copy(padded_rows.begin() + row_index * padded_n_features_,
+                  padded_rows.begin() + row_index * padded_n_features_ + n_features_,
+                  rows.begin() + row_index * n_features_);
+    }
+    return rows;
+}
+
+}  // namespace cpp_clustering::containers
+
+namespace cpp_clustering::heuristic::simd {
+
+// the rows of a Dataset can be passed to the SIMD kernels as pointers
+template <>
+struct is_contiguous_iterator<containers::Dataset<float>::ConstIterator> : std::true_type {};
+
+template <>
+struct is_contiguous_iterator<containers::Dataset<double>::ConstIterator> : std::true_type {};
+
+}  // namespace cpp_clustering::heuristic::simd
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "cpp_clustering/common/Utils.hpp"
+
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
+namespace cpp_clustering::containers {
+
+/**
+ * @brief Non owning handle over a n_samples x n_features vectorized dataset. Keeps the values that only depend on the
+ * samples so that they are computed once and shared by every algorithm, step and n_init candidate that uses the same
+ * dataset: the squared norms of the samples (computed on the first call of squared_norms()) and optional per sample
+ * labels.
+ *
+ * @tparam Iterator
+ */
+template <typename Iterator>
+class DatasetHandle {
+  public:
+    using DataType = typename Iterator::value_type;
+
+    // {samples_first_, samples_last_, n_features_}
+    using DatasetDescriptorType = std::tuple<Iterator, Iterator, std::size_t>;
+
+    explicit DatasetHandle(const Iterator& samples_first, const Iterator& samples_last, std::size_t n_features);
+
+    explicit DatasetHandle(const DatasetDescriptorType& dataset_descriptor);
+
+    const Iterator& samples_first() const {
+        return std::get<0>(dataset_descriptor_);
+    }
+
+    const Iterator& samples_last() const {
+        return std::get<1>(dataset_descriptor_);
+    }
+
+    std::size_t n_features() const {
+        return std::get<2>(dataset_descriptor_);
+    }
+
+    std::size_t n_samples() const {
+        return n_samples_;
+    }
+
+    const DatasetDescriptorType& dataset_descriptor() const {
+        return dataset_descriptor_;
+    }
+
+    // the first call isnt thread safe. It should be made before sharing the handle between threads
+    const std::vector<DataType>& squared_norms() const;
+
+    DatasetHandle<Iterator>& set_labels(const std::vector<std::size_t>& labels);
+
+    bool has_labels() const {
+        return !labels_.empty();
+    }
+
+    const std::vector<std::size_t>& labels() const {
+        return labels_;
+    }
+
+  private:
+    DatasetDescriptorType dataset_descriptor_;
+    std::size_t           n_samples_;
+    // n_samples_ vector of the squared euclidean norms of the samples, empty until requested
+    mutable std::vector<DataType> squared_norms_;
+    mutable bool                  has_squared_norms_ = false;
+    // n_samples_ vector of per sample metadata (e.g. the cluster labels used by the silhouette method)
+    std::vector<std::size_t> labels_;
+};
+
+template <typename Iterator>
+DatasetHandle<Iterator>::DatasetHandle(const Iterator& samples_first,
+                                       const Iterator& samples_last,
+                                       std::size_t     n_features)
+  : DatasetHandle<Iterator>::DatasetHandle(std::make_tuple(samples_first, samples_last, n_features)) {}
+
+template <typename Iterator>
+DatasetHandle<Iterator>::DatasetHandle(const DatasetDescriptorType& dataset_descriptor)
+  : dataset_descriptor_{dataset_descriptor}
+  , n_samples_{common::utils::get_n_samples(std::get<0>(dataset_descriptor_),
+                                            std::get<1>(dataset_descriptor_),
+                                            std::get<2>(dataset_descriptor_))} {}
+
+template <typename Iterator>
+const std::vector<typename DatasetHandle<Iterator>::DataType>& DatasetHandle<Iterator>::squared_norms() const {
+    if (has_squared_norms_) {
+        return squared_norms_;
+    }
+    const auto [samples_first, samples_last, n_features] = dataset_descriptor_;
+
+    squared_norms_.resize(n_samples_);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for schedule(static)
+#endif
+    for (std::size_t sample_index = 0; sample_index < n_samples_; ++sample_index) {
+        const auto sample_first = samples_first + sample_index * n_features;
+
+        squared_norms_[sample_index] =
+            std::transform_reduce(sample_first, sample_first + n_features, sample_first, static_cast<DataType>(0));
+    }
+    has_squared_norms_ = true;
+
+    return squared_norms_;
+}
+
+template <typename Iterator>
+DatasetHandle<Iterator>& DatasetHandle<Iterator>::set_labels(const std::vector<std::size_t>& labels) {
+    if (labels.size() != n_samples_) {
+        throw std::invalid_argument("The number of labels should be equal to the number of samples.");
+    }
+    labels_ = labels;
+    return *this;
+}
+
+}  // namespace cpp_clustering::containers
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/containers/DatasetHandle.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace cpp_clustering::containers {
+
+/**
+ * @brief Random access iterator over a feature-major (column-major) n_samples x n_features matrix that visits the
+ * elements in the sample-major order expected by the algorithms: samples_first + sample_index * n_features +
+ * feature_index points to the feature feature_index of the sample sample_index. The algorithms can then run on a
+ * feature-major dataset without any change, while the kernels that know about this iterator access the columns
+ * directly and vectorize across samples.
+ *
+ * @tparam T
+ */
+template <typename T>
+class FeatureMajorIterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = T;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const T*;
+    using reference         = const T&;
+
+    FeatureMajorIterator() = default;
+
+    FeatureMajorIterator(const T*    columns,
+                         std::size_t n_samples,
+                         std::size_t n_features,
+                         std::size_t sample_index,
+                         std::size_t feature_index)
+      : columns_{columns}
+      , n_samples_{n_samples}
+      , n_features_{n_features}
+      , sample_index_{sample_index}
+      , feature_index_{feature_index} {}
+
+    // pointer to the first feature of the first sample. The feature feature_index of the sample sample_index is at
+    // columns()[feature_index * n_samples() + sample_index]
+    const T* columns() const {
+        return columns_;
+    }
+
+    std::size_t n_samples() const {
+        return n_samples_;
+    }
+
+    std::size_t sample_index() const {
+        return sample_index_;
+    }
+
+    std::size_t feature_index() const {
+        return feature_index_;
+    }
+
+    reference operator*() const {
+        return columns_[feature_index_ * n_samples_ + sample_index_];
+    }
+
+    pointer operator->() const {
+        return &**this;
+    }
+
+    reference operator[](difference_type offset) const {
+        return *(*this + offset);
+    }
+
+    FeatureMajorIterator& operator++() {
+        if (++feature_index_ == n_features_) {
+            feature_index_ = 0;
+            ++sample_index_;
+        }
+        return *this;
+    }
+
+    FeatureMajorIterator operator++(int) {
+        auto previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    FeatureMajorIterator& operator--() {
+        if (feature_index_ == 0) {
+            feature_index_ = n_features_;
+            --sample_index_;
+        }
+        --feature_index_;
+        return *this;
+    }
+
+    FeatureMajorIterator operator--(int) {
+        auto previous = *this;
+        --*this;
+        return previous;
+    }
+
+    FeatureMajorIterator& operator+=(difference_type offset) {
+        const auto feature_index = static_cast<difference_type>(feature_index_) + offset;
+
+        // moves within the same sample dont need a division
+        if (feature_index >= 0 && feature_index < static_cast<difference_type>(n_features_)) {
+            feature_index_ = static_cast<std::size_t>(feature_index);
+        } else {
+            const auto position = static_cast<std::size_t>(linear_index() + offset);
+
+            sample_index_  = position / n_features_;
+            feature_index_ = position % n_features_;
+        }
+        return *this;
+    }
+
+    FeatureMajorIterator& operator-=(difference_type offset) {
+        return *this += -offset;
+    }
+
+    friend FeatureMajorIterator operator+(FeatureMajorIterator iterator, difference_type offset) {
+        return iterator += offset;
+    }
+
+    friend FeatureMajorIterator operator+(difference_type offset, FeatureMajorIterator iterator) {
+        return iterator += offset;
+    }
+
+    friend FeatureMajorIterator operator-(FeatureMajorIterator iterator, difference_type offset) {
+        return iterator -= offset;
+    }
+
+    friend difference_type operator-(const FeatureMajorIterator& lhs, const FeatureMajorIterator& rhs) {
+        return lhs.linear_index() - rhs.linear_index();
+    }
+
+    friend bool operator==(const FeatureMajorIterator& lhs, const FeatureMajorIterator& rhs) {
+        return lhs.sample_index_ == rhs.sample_index_ && lhs.feature_index_ == rhs.feature_index_;
+    }
+
+    friend bool operator!=(const FeatureMajorIterator& lhs, const FeatureMajorIterator& rhs) {
+        return !(lhs == rhs);
+    }
+
+    friend bool operator<(const FeatureMajorIterator& lhs, const FeatureMajorIterator& rhs) {
+        return lhs.linear_index() < rhs.linear_index();
+    }
+
+    friend bool operator>(const FeatureMajorIterator& lhs, const FeatureMajorIterator& rhs) {
+        return rhs < lhs;
+    }
+
+    friend bool operator<=(const FeatureMajorIterator& lhs, const FeatureMajorIterator& rhs) {
+        return !(rhs < lhs);
+    }
+
+    friend bool operator>=(const FeatureMajorIterator& lhs, const FeatureMajorIterator& rhs) {
+        return !(lhs < rhs);
+    }
+
+  private:
+    difference_type linear_index() const {
+        return static_cast<difference_type>(sample_index_ * n_features_ + feature_index_);
+    }
+
+    const T*    columns_       = nullptr;
+    std::size_t n_samples_     = 0;
+    std::size_t n_features_    = 1;
+    std::size_t sample_index_  = 0;
+    std::size_t feature_index_ = 0;
+};
+
+template <typename Iterator>
+struct is_feature_major_iterator : std::false_type {};
+
+template <typename T>
+struct is_feature_major_iterator<FeatureMajorIterator<T>> : std::true_type {};
+
+template <typename Iterator>
+inline constexpr bool is_feature_major_iterator_v = is_feature_major_iterator<Iterator>::value;
+
+/**
+ * @brief Copies a sample-major n_samples x n_features matrix to a feature-major one: the n_samples values of the
+ * first feature, then the n_samples values of the second feature, etc.
+ *
+ * @tparam Iterator
+ * @param samples_first
+ * @param samples_last
+ * @param n_features
+ * @return std::vector<typename Iterator::value_type>
+ */
+template <typename Iterator>
+std::vector<typename Iterator::value_type> to_feature_major(const Iterator& samples_first,
+                                                            const Iterator& samples_last,
+                                                            std::size_t     n_features) {
+    const std::size_t n_samples = common::utils::get_n_samples(samples_first, samples_last, n_features);
+
+    auto columns = std::vector<typename Iterator::value_type>(n_samples * n_features);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+            columns[feature_index * n_samples + sample_index] = *(samples_first + sample_index * n_features +
+                                                                  feature_index);
+        }
+    }
+    return columns;
+}
+
+/**
+ * @brief Zero-copy view of a feature-major n_samples x n_features matrix (e.g. made by to_feature_major) that can be
+ * given to the algorithms like any other dataset.
+ *
+ * @tparam T
+ * @param columns_first pointer to the first feature of the first sample
+ * @param n_samples
+ * @param n_features
+ * @return DatasetHandle<FeatureMajorIterator<T>>
+ */
+template <typename T>
+DatasetHandle<FeatureMajorIterator<T>> make_feature_major_view(const T*    columns_first,
+                                                              std::size_t n_samples,
+                                                              std::size_t n_features) {
+    return DatasetHandle<FeatureMajorIterator<T>>(
+        FeatureMajorIterator<T>(columns_first, n_samples, n_features, 0, 0),
+        FeatureMajorIterator<T>(columns_first, n_samples, n_features, n_samples, 0),
+        n_features);
+}
+
+}  // namespace cpp_clustering::containers
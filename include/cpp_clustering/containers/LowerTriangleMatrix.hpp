@@ -1,5 +1,6 @@
 #pragma once
 
+#include "cpp_clustering/containers/DatasetHandle.hpp"
 #include "cpp_clustering/heuristics/Heuristics.hpp"
 
 #include <algorithm>
@@ -31,12 +32,13 @@ std::vector<std::vector<typename Iterator::value_type>> make_pairwise_low_triang
         // conditions during the access of the elements. The values are not computed (= zero)
         std::vector<ValueType> temp_row(i + 1);
 
-        for (std::size_t j = 0; j < i; ++j) {
-            temp_row[j] = cpp_clustering::heuristic::heuristic(
-                /*first sample begin=*/samples_first + i * n_features,
-                /*first sample end=*/samples_first + i * n_features + n_features,
-                /*second sample begin=*/samples_first + j * n_features);
-        }
+        // distances from the i-th sample to the samples before it
+        cpp_clustering::heuristic::heuristic_one_to_many(
+            /*sample begin=*/samples_first + i * n_features,
+            /*sample end=*/samples_first + i * n_features + n_features,
+            /*other samples begin=*/samples_first,
+            /*other samples end=*/samples_first + i * n_features,
+            /*distances begin=*/temp_row.begin());
 #if defined(_OPENMP) && THREADS_ENABLED == true
 #pragma omp critical
 #endif
@@ -62,6 +64,10 @@ class LowerTriangleMatrix {
 
     LowerTriangleMatrix(const DatasetDescriptorType& dataset_descriptor);
 
+    // a named factory rather than a constructor so that LowerTriangleMatrix<Iterator>{{first, last, n_features}} still
+    // resolves to the DatasetDescriptorType constructor
+    static LowerTriangleMatrix from_handle(const DatasetHandle<Iterator>& dataset);
+
     ValueType& operator()(std::size_t sample_index, std::size_t feature_index);
 
     const ValueType& operator()(std::size_t sample_index, std::size_t feature_index) const;
@@ -84,6 +90,11 @@ template <typename Iterator>
 LowerTriangleMatrix<Iterator>::LowerTriangleMatrix(const DatasetDescriptorType& dataset_descriptor)
   : data_{make_pairwise_low_triangle_distance_matrix(dataset_descriptor)} {}
 
+template <typename Iterator>
+LowerTriangleMatrix<Iterator> LowerTriangleMatrix<Iterator>::from_handle(const DatasetHandle<Iterator>& dataset) {
+    return LowerTriangleMatrix<Iterator>(dataset.dataset_descriptor());
+}
+
 template <typename Iterator>
 typename LowerTriangleMatrix<Iterator>::ValueType& LowerTriangleMatrix<Iterator>::operator()(
     std::size_t sample_index,
@@ -2,12 +2,10 @@
 
 #include "cpp_clustering/common/Utils.hpp"
 #include "cpp_clustering/containers/kdtree/KDTreeUtils.hpp"
-#include "cpp_clustering/math/random/Distributions.hpp"
 
 #include <sys/types.h>  // ssize_t
-#include <algorithm>
-#include <array>
-#include <memory>
+#include <cstdint>
+#include <vector>
 
 namespace cpp_clustering::containers {
 
@@ -23,57 +21,32 @@ using BoundingBox1DType = std::pair<DataType<Iterator>, DataType<Iterator>>;
 template <typename Iterator>
 using BoundingBoxKDType = std::vector<BoundingBox1DType<Iterator>>;
 
-template <typename Iterator>
+/**
+ * @brief Node of a KDTree. The nodes are stored contiguously in depth first order so the left child of a node is the
+ * next node and only the index of the right child is kept. The nodes dont store their samples: the samples of the
+ * subtree of a node are the contiguous range [first, last) that its parent gives to it, starting from the whole
+ * dataset at the root. A leaf owns its whole range while a cut owns the median sample first + n_samples / 2, its left
+ * subtree the samples before and its right subtree the samples after. The cells are recomputed from the cuts during
+ * the traversals.
+ *
+ * @tparam T the type of the samples features
+ */
+template <typename T>
 struct KDNode {
-    KDNode(Iterator                           samples_first,
-           Iterator                           samples_last,
-           std::size_t                        n_features,
-           const BoundingBoxKDType<Iterator>& kd_bounding_box);
-
-    KDNode(Iterator                           samples_first,
-           Iterator                           samples_last,
-           std::size_t                        n_features,
-           ssize_t                            cut_feature_index,
-           const BoundingBoxKDType<Iterator>& kd_bounding_box);
-
-    KDNode(const KDNode&) = delete;
-
-    bool is_empty() const;
-
-    SamplesRangeType<Iterator> samples_;
-    std::size_t                n_features_;
-    ssize_t                    cut_feature_index_;
-    // bounding box w.r.t. the chosen feature index. No bounding box for leaf nodes
-    // BoundingBox1DType                 bounding_box_1d_;
-    BoundingBoxKDType<Iterator>       kd_bounding_box_;
-    std::shared_ptr<KDNode<Iterator>> left_;
-    std::shared_ptr<KDNode<Iterator>> right_;
+    bool is_leaf() const;
+
+    // value of the median sample at cut_feature_index_. The samples of the left (right) subtree are lower (greater) or
+    // equal
+    T cut_value_;
+    // -1 for the leaves
+    std::int32_t cut_feature_index_;
+    // the left child is the next node
+    std::uint32_t right_index_;
 };
 
-template <typename Iterator>
-KDNode<Iterator>::KDNode(Iterator                           samples_first,
-                         Iterator                           samples_last,
-                         std::size_t                        n_features,
-                         const BoundingBoxKDType<Iterator>& kd_bounding_box)
-  : samples_{std::make_pair(samples_first, samples_last)}
-  , n_features_{n_features}
-  , cut_feature_index_{-1}
-  , kd_bounding_box_{kd_bounding_box} {}
-
-template <typename Iterator>
-KDNode<Iterator>::KDNode(Iterator                           samples_first,
-                         Iterator                           samples_last,
-                         std::size_t                        n_features,
-                         ssize_t                            cut_feature_index,
-                         const BoundingBoxKDType<Iterator>& kd_bounding_box)
-  : samples_{kdtree::utils::quickselect_median_range(samples_first, samples_last, n_features, cut_feature_index)}
-  , n_features_{n_features}
-  , cut_feature_index_{cut_feature_index}
-  , kd_bounding_box_{kd_bounding_box} {}
-
-template <typename Iterator>
-bool KDNode<Iterator>::is_empty() const {
-    return samples_.first == samples_.second;
+template <typename T>
+bool KDNode<T>::is_leaf() const {
+    return cut_feature_index_ == -1;
 }
 
-}  // namespace cpp_clustering::containers
\ No newline at end of file
+}  // namespace cpp_clustering::containers
@@ -3,18 +3,25 @@
 #include "cpp_clustering/common/Utils.hpp"
 #include "cpp_clustering/containers/kdtree/KDNode.hpp"
 #include "cpp_clustering/containers/kdtree/KDTreeUtils.hpp"
+#include "cpp_clustering/heuristics/Heuristics.hpp"
 #include "cpp_clustering/math/random/Distributions.hpp"
 
 #include <sys/types.h>  // ssize_t
 #include <algorithm>
 #include <array>
-#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
 
 namespace cpp_clustering::containers {
 
 template <typename Iterator>
 class KDTree {
   public:
+    using KDNodeType = KDNode<DataType<Iterator>>;
+
     struct Options {
         Options& bucket_size(std::size_t bucket_size) {
             bucket_size_ = bucket_size;
@@ -34,77 +41,434 @@ class KDTree {
 
     KDTree(const KDTree&) = delete;
 
-    void print_kdtree(const std::shared_ptr<KDNode<Iterator>>& kdnode) const;
+    std::size_t n_features() const {
+        return n_features_;
+    }
+
+    Iterator samples_first() const {
+        return samples_first_;
+    }
+
+    Iterator samples_last() const {
+        return samples_last_;
+    }
+
+    const BoundingBoxKDType<Iterator>& kd_bounding_box() const {
+        return kd_bounding_box_;
+    }
+
+    // the nodes in depth first order, the root first
+    const std::vector<KDNodeType>& nodes() const {
+        return nodes_;
+    }
+
+    template <typename QueryIterator>
+    std::pair<std::vector<std::size_t>, std::vector<DataType<Iterator>>> knn(QueryIterator query_first,
+                                                                             std::size_t   n_neighbors) const;
+
+    template <typename QueryIterator>
+    std::pair<std::vector<std::size_t>, std::vector<DataType<Iterator>>> knn(QueryIterator queries_first,
+                                                                             QueryIterator queries_last,
+                                                                             std::size_t   n_neighbors) const;
+
+    void print_kdtree(std::size_t node_index, Iterator samples_first, Iterator samples_last) const;
     void print() const;
 
   private:
-    std::shared_ptr<KDNode<Iterator>> cycle_through_depth_build(Iterator                     samples_first,
-                                                                Iterator                     samples_last,
-                                                                ssize_t                      cut_feature_index,
-                                                                std::size_t                  depth,
-                                                                BoundingBoxKDType<Iterator>& kd_bounding_box);
+    // {squared distance, sample index} of the neighbors found so far, the furthest on top
+    using NeighborsHeapType = std::vector<std::pair<DataType<Iterator>, std::size_t>>;
+
+    template <typename QueryIterator, typename IndicesIterator, typename DistancesIterator>
+    void knn_query(QueryIterator                    query_first,
+                   std::size_t                      n_neighbors,
+                   NeighborsHeapType&               neighbors_heap,
+                   std::vector<DataType<Iterator>>& cell_offsets,
+                   IndicesIterator                  indices_first,
+                   DistancesIterator                distances_first) const;
+
+    template <typename QueryIterator>
+    void knn_search(std::size_t                      node_index,
+                    Iterator                         samples_first,
+                    Iterator                         samples_last,
+                    QueryIterator                    query_first,
+                    std::size_t                      n_neighbors,
+                    DataType<Iterator>               cell_distance,
+                    std::vector<DataType<Iterator>>& cell_offsets,
+                    NeighborsHeapType&               neighbors_heap) const;
+
+    void add_neighbor(Iterator           sample_first,
+                      DataType<Iterator> distance,
+                      std::size_t        n_neighbors,
+                      NeighborsHeapType& neighbors_heap) const;
+
+    std::vector<KDNodeType> build();
+
+    void cycle_through_depth_build(Iterator                 samples_first,
+                                   Iterator                 samples_last,
+                                   std::size_t              node_index,
+                                   std::size_t              depth,
+                                   std::vector<KDNodeType>& nodes) const;
+
+    std::pair<std::size_t, std::size_t> n_subtree_nodes(std::size_t n_samples) const;
 
     std::size_t n_features_;
+    Iterator    samples_first_;
+    Iterator    samples_last_;
     // bounding box hyper rectangle (w.r.t. each dimension)
     BoundingBoxKDType<Iterator> kd_bounding_box_;
 
     Options options_;
 
-    std::shared_ptr<KDNode<Iterator>> root_;
+    std::vector<KDNodeType> nodes_;
 };
 
 template <typename Iterator>
 KDTree<Iterator>::KDTree(Iterator samples_first, Iterator samples_last, std::size_t n_features)
   : n_features_{n_features}
+  , samples_first_{samples_first}
+  , samples_last_{samples_last}
   , kd_bounding_box_{kdtree::utils::make_kd_bounding_box(samples_first, samples_last, n_features_)}
-  , root_{cycle_through_depth_build(samples_first, samples_last, 0, 0, kd_bounding_box_)} {}
+  , nodes_{build()} {}
+
+/**
+ * @brief Builds the tree from the root. The number of nodes of a subtree only depends on its number of samples so the
+ * nodes are allocated beforehand and each subtree is written at its final position. The subtrees are built in OpenMP
+ * tasks so that the threads of the team share the recursion.
+ */
+template <typename Iterator>
+std::vector<typename KDTree<Iterator>::KDNodeType> KDTree<Iterator>::build() {
+    const std::size_t n_samples = common::utils::get_n_samples(samples_first_, samples_last_, n_features_);
+    const std::size_t n_nodes   = n_subtree_nodes(n_samples).first;
+
+    if (n_nodes > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("The number of nodes of the KDTree exceeds the range of its 32 bits indices.");
+    }
+    auto nodes = std::vector<KDNodeType>(n_nodes);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel if (n_samples > kdtree::utils::kdtree_parallel_build_min_samples)
+#pragma omp single
+#endif
+    cycle_through_depth_build(samples_first_, samples_last_, 0, 0, nodes);
+
+    return nodes;
+}
 
 template <typename Iterator>
-std::shared_ptr<KDNode<Iterator>> KDTree<Iterator>::cycle_through_depth_build(
-    Iterator                     samples_first,
-    Iterator                     samples_last,
-    ssize_t                      cut_feature_index,
-    std::size_t                  depth,
-    BoundingBoxKDType<Iterator>& kd_bounding_box) {
+void KDTree<Iterator>::cycle_through_depth_build(Iterator                 samples_first,
+                                                 Iterator                 samples_last,
+                                                 std::size_t              node_index,
+                                                 std::size_t              depth,
+                                                 std::vector<KDNodeType>& nodes) const {
     const std::size_t n_samples = common::utils::get_n_samples(samples_first, samples_last, n_features_);
 
-    std::shared_ptr<KDNode<Iterator>> node;
+    auto& node = nodes[node_index];
 
     // the current node is not leaf
     if (n_samples > options_.bucket_size_) {
-        // cycle through the cut_feature_index (dimension) according to the current depth & post-increment depth
-        cut_feature_index = (depth++) % n_features_;
+        // cycle through the cut_feature_index (dimension) according to the current depth
+        const std::size_t cut_feature_index = depth % n_features_;
+
+        kdtree::utils::quickselect_median_range(samples_first, samples_last, n_features_, cut_feature_index);
 
-        node = std::make_shared<KDNode<Iterator>>(
-            samples_first, samples_last, n_features_, cut_feature_index, kd_bounding_box);
+        const std::size_t median_index = n_samples / 2;
 
-        const std::size_t        median_index = n_samples / 2;
-        const DataType<Iterator> median_value = *(samples_first + median_index * n_features_ + cut_feature_index);
+        node.cut_value_         = *(samples_first + median_index * n_features_ + cut_feature_index);
+        node.cut_feature_index_ = static_cast<std::int32_t>(cut_feature_index);
+        // the left subtree is stored right after the node, followed by the right subtree
+        node.right_index_ = static_cast<std::uint32_t>(node_index + 1 + n_subtree_nodes(median_index).first);
 
         auto left_samples_first = samples_first;
         auto left_samples_last  = samples_first + median_index * n_features_;
-        // get the value of the median value right after the cut (new right bound according to the current cut axis)
-        kd_bounding_box[cut_feature_index].second = median_value;
 
-        node->left_ =
-            cycle_through_depth_build(left_samples_first, left_samples_last, cut_feature_index, depth, kd_bounding_box);
-        // restore the bounding box that was cut at the median value to the previous one
-        kd_bounding_box[cut_feature_index].second = node->kd_bounding_box_[cut_feature_index].second;
+        if (n_samples > kdtree::utils::kdtree_parallel_build_min_samples) {
+            // the left subtree is built by any thread of the team while the current thread builds the right subtree.
+            // Both ranges of samples and both ranges of nodes are disjoint so the tree is the same as the serial one
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp task default(shared)
+#endif
+            cycle_through_depth_build(left_samples_first, left_samples_last, node_index + 1, depth + 1, nodes);
 
+        } else {
+            cycle_through_depth_build(left_samples_first, left_samples_last, node_index + 1, depth + 1, nodes);
+        }
         auto right_samples_first = samples_first + median_index * n_features_ + n_features_;
         auto right_samples_last  = samples_last;
-        // get the value of the median value right before the cut (new right bound according to the current cut axis)
-        kd_bounding_box[cut_feature_index].first = median_value;
 
-        node->right_ = cycle_through_depth_build(
-            right_samples_first, right_samples_last, cut_feature_index, depth, kd_bounding_box);
-        // restore the bounding box that was cut at the median value to the previous one
-        kd_bounding_box[cut_feature_index].first = node->kd_bounding_box_[cut_feature_index].first;
+        cycle_through_depth_build(right_samples_first, right_samples_last, node.right_index_, depth + 1, nodes);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+        // the task reads the local variables of this call
+#pragma omp taskwait
+#endif
+    } else {
+        node.cut_value_         = 0;
+        node.cut_feature_index_ = -1;
+        node.right_index_       = 0;
+    }
+}
+
+/**
+ * @brief Number of nodes of the subtrees of n_samples and n_samples + 1 samples. The halves of both are made of
+ * (n_samples - 1) / 2 or (n_samples + 1) / 2 samples so a single recursion computes both in O(log(n_samples)).
+ *
+ * @return std::pair<std::size_t, std::size_t> {n_nodes(n_samples), n_nodes(n_samples + 1)}
+ */
+template <typename Iterator>
+std::pair<std::size_t, std::size_t> KDTree<Iterator>::n_subtree_nodes(std::size_t n_samples) const {
+    const std::size_t bucket_size = options_.bucket_size_;
+
+    if (n_samples + 1 <= bucket_size) {
+        return {1, 1};
+    }
+    if (!n_samples) {
+        // a single sample is cut in two empty leaves when the bucket size is 0
+        return {1, 3};
+    }
+    const bool is_odd = n_samples % 2;
+    // number of nodes of the subtrees of (n_samples - 1) / 2 and (n_samples + 1) / 2 samples
+    const auto [n_nodes_half, n_nodes_half_next] = n_subtree_nodes((n_samples - 1) / 2);
+
+    // the halves of n_samples: n_samples / 2 and (n_samples - 1) / 2
+    const std::size_t n_nodes =
+        n_samples <= bucket_size ? 1 : 1 + n_nodes_half + (is_odd ? n_nodes_half : n_nodes_half_next);
+    // the halves of n_samples + 1: (n_samples + 1) / 2 and n_samples / 2
+    const std::size_t n_nodes_next = 1 + n_nodes_half_next + (is_odd ? n_nodes_half : n_nodes_half_next);
+
+    return {n_nodes, n_nodes_next};
+}
+
+/**
+ * @brief The n_neighbors nearest samples of a query.
+ *
+ * @tparam QueryIterator
+ * @param query_first first feature of the query
+ * @param n_neighbors
+ * @return std::pair<std::vector<std::size_t>, std::vector<DataType<Iterator>>> the indices of the neighbors in the
+ * samples range of the tree (reordered by the build) and their euclidean distances to the query, nearest first
+ */
+template <typename Iterator>
+template <typename QueryIterator>
+std::pair<std::vector<std::size_t>, std::vector<DataType<Iterator>>> KDTree<Iterator>::knn(
+    QueryIterator query_first,
+    std::size_t   n_neighbors) const {
+    return knn(query_first, query_first + n_features_, n_neighbors);
+}
+
+/**
+ * @brief The n_neighbors nearest samples of each query. The queries are processed in parallel.
+ *
+ * @tparam QueryIterator
+ * @param queries_first
+ * @param queries_last
+ * @param n_neighbors
+ * @return std::pair<std::vector<std::size_t>, std::vector<DataType<Iterator>>> the indices of the neighbors in the
+ * samples range of the tree (reordered by the build) and their euclidean distances to the query, nearest first. Both
+ * are n_queries x n_neighbors
+ */
+template <typename Iterator>
+template <typename QueryIterator>
+std::pair<std::vector<std::size_t>, std::vector<DataType<Iterator>>> KDTree<Iterator>::knn(
+    QueryIterator queries_first,
+    QueryIterator queries_last,
+    std::size_t   n_neighbors) const {
+    const std::size_t n_samples = common::utils::get_n_samples(samples_first_, samples_last_, n_features_);
+    const std::size_t n_queries = common::utils::get_n_samples(queries_first, queries_last, n_features_);
+
+    if (n_neighbors > n_samples) {
+        throw std::invalid_argument("The number of neighbors (" + std::to_string(n_neighbors) +
+                                    ") cant be greater than the number of samples (" + std::to_string(n_samples) +
+                                    ").");
+    }
+    auto indices   = std::vector<std::size_t>(n_queries * n_neighbors);
+    auto distances = std::vector<DataType<Iterator>>(n_queries * n_neighbors);
+
+    if (!n_neighbors) {
+        return {std::move(indices), std::move(distances)};
+    }
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel if (n_queries > 1)
+#endif
+    {
+        auto neighbors_heap = NeighborsHeapType();
+        auto cell_offsets   = std::vector<DataType<Iterator>>(n_features_);
+
+        neighbors_heap.reserve(n_neighbors);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp for schedule(dynamic, 16)
+#endif
+        for (std::size_t query_index = 0; query_index < n_queries; ++query_index) {
+            knn_query(queries_first + query_index * n_features_,
+                      n_neighbors,
+                      neighbors_heap,
+                      cell_offsets,
+                      indices.begin() + query_index * n_neighbors,
+                      distances.begin() + query_index * n_neighbors);
+        }
+    }
+    return {std::move(indices), std::move(distances)};
+}
+
+template <typename Iterator>
+template <typename QueryIterator, typename IndicesIterator, typename DistancesIterator>
+void KDTree<Iterator>::knn_query(QueryIterator                    query_first,
+                                 std::size_t                      n_neighbors,
+                                 NeighborsHeapType&               neighbors_heap,
+                                 std::vector<DataType<Iterator>>& cell_offsets,
+                                 IndicesIterator                  indices_first,
+                                 DistancesIterator                distances_first) const {
+    using DataType = DataType<Iterator>;
+
+    neighbors_heap.clear();
+
+    // offsets from the query to the root cell along each feature. Zero when the query is inside the cell
+    DataType cell_distance = 0;
+
+    for (std::size_t feature_index = 0; feature_index < n_features_; ++feature_index) {
+        const DataType feature = *(query_first + feature_index);
+
+        cell_offsets[feature_index] =
+            std::max({kd_bounding_box_[feature_index].first - feature,
+                      feature - kd_bounding_box_[feature_index].second,
+                      static_cast<DataType>(0)});
+
+        cell_distance += cell_offsets[feature_index] * cell_offsets[feature_index];
+    }
+    knn_search(0, samples_first_, samples_last_, query_first, n_neighbors, cell_distance, cell_offsets, neighbors_heap);
+
+    // nearest neighbor first
+    std::sort_heap(neighbors_heap.begin(), neighbors_heap.end());
+
+    for (std::size_t neighbor_index = 0; neighbor_index < n_neighbors; ++neighbor_index) {
+        *(indices_first + neighbor_index)   = neighbors_heap[neighbor_index].second;
+        *(distances_first + neighbor_index) = std::sqrt(neighbors_heap[neighbor_index].first);
+    }
+}
+
+/**
+ * @brief Depth first search of the nearest neighbors that visits the child on the side of the query first. The cell of
+ * the far child is only visited if it is closer than the furthest neighbor found so far. The squared distance from
+ * the query to a cell is updated incrementally from the one of its parent: only the offset along the cut feature
+ * changes (https://www.cs.umd.edu/~mount/Papers/DistanceErrorAnalysis.pdf).
+ *
+ * @param node_index
+ * @param samples_first first sample of the subtree of the node
+ * @param samples_last
+ * @param query_first
+ * @param n_neighbors
+ * @param cell_distance squared distance from the query to the cell of the node
+ * @param cell_offsets offsets from the query to the cell of the node along each feature
+ * @param neighbors_heap
+ */
+template <typename Iterator>
+template <typename QueryIterator>
+void KDTree<Iterator>::knn_search(std::size_t                      node_index,
+                                  Iterator                         samples_first,
+                                  Iterator                         samples_last,
+                                  QueryIterator                    query_first,
+                                  std::size_t                      n_neighbors,
+                                  DataType<Iterator>               cell_distance,
+                                  std::vector<DataType<Iterator>>& cell_offsets,
+                                  NeighborsHeapType&               neighbors_heap) const {
+    const auto& node = nodes_[node_index];
+
+    if (node.is_leaf()) {
+        for (auto sample_first = samples_first; sample_first != samples_last; sample_first += n_features_) {
+            add_neighbor(sample_first,
+                         heuristic::squared_euclidean_distance(sample_first, sample_first + n_features_, query_first),
+                         n_neighbors,
+                         neighbors_heap);
+        }
+        return;
+    }
+    const std::size_t median_index = common::utils::get_n_samples(samples_first, samples_last, n_features_) / 2;
 
+    const auto median_first = samples_first + median_index * n_features_;
+
+    const auto cut_offset = *(query_first + node.cut_feature_index_) - node.cut_value_;
+
+    const bool is_query_left = cut_offset <= 0;
+
+    // the child on the side of the query has the same cell distance as its parent
+    if (is_query_left) {
+        knn_search(node_index + 1,
+                   samples_first,
+                   median_first,
+                   query_first,
+                   n_neighbors,
+                   cell_distance,
+                   cell_offsets,
+                   neighbors_heap);
+    } else {
+        knn_search(node.right_index_,
+                   median_first + n_features_,
+                   samples_last,
+                   query_first,
+                   n_neighbors,
+                   cell_distance,
+                   cell_offsets,
+                   neighbors_heap);
+    }
+    add_neighbor(median_first,
+                 heuristic::squared_euclidean_distance(median_first, median_first + n_features_, query_first),
+                 n_neighbors,
+                 neighbors_heap);
+
+    auto& cut_feature_offset = cell_offsets[node.cut_feature_index_];
+
+    const auto far_cell_distance = cell_distance - cut_feature_offset * cut_feature_offset + cut_offset * cut_offset;
+
+    // the ties are still visited since they can replace a neighbor with a greater sample index
+    if (neighbors_heap.size() == n_neighbors && far_cell_distance > neighbors_heap.front().first) {
+        return;
+    }
+    const auto previous_cut_feature_offset = cut_feature_offset;
+
+    cut_feature_offset = cut_offset;
+
+    if (is_query_left) {
+        knn_search(node.right_index_,
+                   median_first + n_features_,
+                   samples_last,
+                   query_first,
+                   n_neighbors,
+                   far_cell_distance,
+                   cell_offsets,
+                   neighbors_heap);
     } else {
-        node = std::make_shared<KDNode<Iterator>>(samples_first, samples_last, n_features_, kd_bounding_box);
+        knn_search(node_index + 1,
+                   samples_first,
+                   median_first,
+                   query_first,
+                   n_neighbors,
+                   far_cell_distance,
+                   cell_offsets,
+                   neighbors_heap);
+    }
+    cut_feature_offset = previous_cut_feature_offset;
+}
+
+template <typename Iterator>
+void KDTree<Iterator>::add_neighbor(Iterator           sample_first,
+                                    DataType<Iterator> distance,
+                                    std::size_t        n_neighbors,
+                                    NeighborsHeapType& neighbors_heap) const {
+    if (neighbors_heap.size() == n_neighbors && distance > neighbors_heap.front().first) {
+        return;
+    }
+    const std::size_t sample_index = std::distance(samples_first_, sample_first) / n_features_;
+
+    if (neighbors_heap.size() < n_neighbors) {
+        neighbors_heap.emplace_back(distance, sample_index);
+        std::push_heap(neighbors_heap.begin(), neighbors_heap.end());
+
+    } else if (std::make_pair(distance, sample_index) < neighbors_heap.front()) {
+        // replace the furthest neighbor
+        std::pop_heap(neighbors_heap.begin(), neighbors_heap.end());
+        neighbors_heap.back() = {distance, sample_index};
+        std::push_heap(neighbors_heap.begin(), neighbors_heap.end());
     }
-    return node;
 }
 
 #include <iostream>
@@ -125,35 +489,33 @@ void print_ranges(Iterator first, Iterator last, std::size_t n_features) {
 }
 
 template <typename Iterator>
-void KDTree<Iterator>::print_kdtree(const std::shared_ptr<KDNode<Iterator>>& kdnode) const {
-    // static std::size_t counter = 0;
-
-    const bool is_leaf = kdnode->cut_feature_index_ == -1 ? true : false;
+void KDTree<Iterator>::print_kdtree(std::size_t node_index, Iterator samples_first, Iterator samples_last) const {
+    const auto& node = nodes_[node_index];
 
-    if (is_leaf) {
-        if (kdnode->is_empty()) {
+    if (node.is_leaf()) {
+        if (samples_first == samples_last) {
             std::cout << "Leaf(empty):\n";
 
         } else {
             std::cout << "Leaf:\n";
         }
-        // counter += common::utils::get_n_samples(kdnode->samples_.first, kdnode->samples_.second, n_features_);
-        print_ranges<Iterator>(kdnode->samples_.first, kdnode->samples_.second, n_features_);
+        print_ranges<Iterator>(samples_first, samples_last, n_features_);
     } else {
-        std::cout << "Node:\n";
-        print_range<Iterator>(kdnode->samples_.first, kdnode->samples_.second);
+        const std::size_t median_index = common::utils::get_n_samples(samples_first, samples_last, n_features_) / 2;
 
-        // counter += common::utils::get_n_samples(kdnode->samples_.first, kdnode->samples_.second, n_features_);
+        const auto median_first = samples_first + median_index * n_features_;
+
+        std::cout << "Node:\n";
+        print_range<Iterator>(median_first, median_first + n_features_);
 
-        print_kdtree(kdnode->left_);
-        print_kdtree(kdnode->right_);
+        print_kdtree(node_index + 1, samples_first, median_first);
+        print_kdtree(node.right_index_, median_first + n_features_, samples_last);
     }
-    // std::cout << counter << "\n";
 }
 
 template <typename Iterator>
 void KDTree<Iterator>::print() const {
-    print_kdtree(root_);
+    print_kdtree(0, samples_first_, samples_last_);
 }
 
-}  // namespace cpp_clustering::containers
\ No newline at end of file
+}  // namespace cpp_clustering::containers
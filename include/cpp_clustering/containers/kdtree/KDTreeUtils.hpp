@@ -3,6 +3,7 @@
 #include "cpp_clustering/common/Utils.hpp"
 
 #include <sys/types.h>  // ssize_t
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <vector>
@@ -18,6 +19,9 @@ using BoundingBox1DType = std::pair<DataType<Iterator>, DataType<Iterator>>;
 template <typename Iterator>
 using BoundingBoxKDType = std::vector<BoundingBox1DType<Iterator>>;
 
+// number of samples above which the subtrees of a node are built in parallel
+inline constexpr std::size_t kdtree_parallel_build_min_samples = 1 << 14;
+
 template <typename Iterator>
 BoundingBoxKDType<Iterator> make_1d_bounding_box(const Iterator& samples_first,
                                                  const Iterator& samples_last,
@@ -51,21 +55,46 @@ BoundingBoxKDType<Iterator> make_kd_bounding_box(const Iterator& samples_first,
 
     const std::size_t n_samples = common::utils::get_n_samples(samples_first, samples_last, n_features);
 
-    auto kd_bounding_box = BoundingBoxKDType<Iterator>(
+    // the empty box that each thread starts from. The threads dont read kd_bounding_box since the ones that are done
+    // with their samples are already merging into it
+    const auto initial_kd_bounding_box = BoundingBoxKDType<Iterator>(
         n_features,
         BoundingBox1DType<Iterator>({std::numeric_limits<DataType>::max(), std::numeric_limits<DataType>::lowest()}));
 
-    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
-        for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
-            const auto min_max_feature_candidate = *(samples_first + sample_index * n_features + feature_index);
-
-            if (min_max_feature_candidate < kd_bounding_box[feature_index].first) {
-                kd_bounding_box[feature_index].first = min_max_feature_candidate;
-            }
-            if (min_max_feature_candidate > kd_bounding_box[feature_index].second) {
-                kd_bounding_box[feature_index].second = min_max_feature_candidate;
+    auto kd_bounding_box = initial_kd_bounding_box;
+
+    // each thread bounds its share of the samples and the boxes are merged. The min and max dont depend on the order
+    // of the merge so the box is the same as the serial one
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel if (n_samples > kdtree_parallel_build_min_samples)
+#endif
+    {
+        auto thread_kd_bounding_box = initial_kd_bounding_box;
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp for schedule(static) nowait
+#endif
+        for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+            for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+                const auto min_max_feature_candidate = *(samples_first + sample_index * n_features + feature_index);
+
+                if (min_max_feature_candidate < thread_kd_bounding_box[feature_index].first) {
+                    thread_kd_bounding_box[feature_index].first = min_max_feature_candidate;
+                }
+                if (min_max_feature_candidate > thread_kd_bounding_box[feature_index].second) {
+                    thread_kd_bounding_box[feature_index].second = min_max_feature_candidate;
+                }
             }
         }
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp critical
+#endif
+        for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+            kd_bounding_box[feature_index].first =
+                std::min(kd_bounding_box[feature_index].first, thread_kd_bounding_box[feature_index].first);
+            kd_bounding_box[feature_index].second =
+                std::max(kd_bounding_box[feature_index].second, thread_kd_bounding_box[feature_index].second);
+        }
     }
     return kd_bounding_box;
 }
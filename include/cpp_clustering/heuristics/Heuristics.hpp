@@ -1,15 +1,62 @@
 #pragma once
 
 #include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/heuristics/SimdDistances.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
 #include <vector>
 
 namespace cpp_clustering::heuristic {
 
+/**
+ * @brief Squared euclidean distance for a number of features known at compile time. The loops have fixed trip counts
+ * that the compiler fully unrolls, and they accumulate in 4 independent sums so that the unrolled code isnt a single
+ * dependency chain.
+ *
+ * @tparam NFeatures
+ * @tparam IteratorFloat1
+ * @tparam IteratorFloat2
+ * @param feature_first
+ * @param other_feature_first
+ * @return std::iterator_traits<IteratorFloat1>::value_type
+ */
+template <std::size_t NFeatures, typename IteratorFloat1, typename IteratorFloat2>
+typename std::iterator_traits<IteratorFloat1>::value_type squared_euclidean_distance(
+    const IteratorFloat1& feature_first,
+    const IteratorFloat2& other_feature_first) {
+    static_assert(NFeatures != common::utils::dynamic_n_features, "The number of features should be known.");
+
+    using FloatType = typename std::iterator_traits<IteratorFloat1>::value_type;
+
+    FloatType sum_0 = 0, sum_1 = 0, sum_2 = 0, sum_3 = 0;
+
+    for (std::size_t feature_index = 0; feature_index + 4 <= NFeatures; feature_index += 4) {
+        const FloatType difference_0 = *(feature_first + feature_index) - *(other_feature_first + feature_index);
+        const FloatType difference_1 =
+            *(feature_first + feature_index + 1) - *(other_feature_first + feature_index + 1);
+        const FloatType difference_2 =
+            *(feature_first + feature_index + 2) - *(other_feature_first + feature_index + 2);
+        const FloatType difference_3 =
+            *(feature_first + feature_index + 3) - *(other_feature_first + feature_index + 3);
+
+        sum_0 += difference_0 * difference_0;
+        sum_1 += difference_1 * difference_1;
+        sum_2 += difference_2 * difference_2;
+        sum_3 += difference_3 * difference_3;
+    }
+    for (std::size_t feature_index = NFeatures / 4 * 4; feature_index < NFeatures; ++feature_index) {
+        const FloatType difference = *(feature_first + feature_index) - *(other_feature_first + feature_index);
+
+        sum_0 += difference * difference;
+    }
+    return (sum_0 + sum_1) + (sum_2 + sum_3);
+}
+
 template <typename IteratorFloat1, typename IteratorFloat2>
 typename IteratorFloat1::value_type squared_euclidean_distance(const IteratorFloat1& feature_first,
                                                                const IteratorFloat1& feature_last,
@@ -22,15 +69,32 @@ typename IteratorFloat1::value_type squared_euclidean_distance(const IteratorFlo
 
     using FloatType = typename IteratorFloat1::value_type;
 
-    return std::transform_reduce(feature_first,
-                                 feature_last,
-                                 other_feature_first,
-                                 static_cast<FloatType>(0),
-                                 std::plus<>(),
-                                 [](const auto& lhs, const auto& rhs) {
-                                     const auto tmp = lhs - rhs;
-                                     return tmp * tmp;
-                                 });
+    // contiguous ranges with enough features go to the kernels of the instruction set of the host
+    if constexpr (simd::is_dispatchable_v<IteratorFloat1, IteratorFloat2>) {
+        const std::size_t n_features = std::distance(feature_first, feature_last);
+
+        if (n_features >= simd::min_dispatch_n_features) {
+            return simd::squared_euclidean_distance(&*feature_first, &*other_feature_first, n_features);
+        }
+        // short loop kept small enough to be inlined in the callers
+        FloatType result = 0;
+        for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+            const FloatType difference = *(feature_first + feature_index) - *(other_feature_first + feature_index);
+            result += difference * difference;
+        }
+        return result;
+
+    } else {
+        return std::transform_reduce(feature_first,
+                                     feature_last,
+                                     other_feature_first,
+                                     static_cast<FloatType>(0),
+                                     std::plus<>(),
+                                     [](const auto& lhs, const auto& rhs) {
+                                         const auto tmp = lhs - rhs;
+                                         return tmp * tmp;
+                                     });
+    }
 }
 
 template <typename IteratorFloat1, typename IteratorFloat2>
@@ -46,6 +110,13 @@ typename Iterator1::value_type manhattan_distance(const Iterator1& feature_first
                                                   const Iterator2& other_feature_first) {
     using DataType = typename Iterator1::value_type;
 
+    if constexpr (simd::is_dispatchable_v<Iterator1, Iterator2>) {
+        const std::size_t n_features = std::distance(feature_first, feature_last);
+
+        if (n_features >= simd::min_dispatch_n_features) {
+            return simd::manhattan_distance(&*feature_first, &*other_feature_first, n_features);
+        }
+    }
     return std::transform_reduce(feature_first,
                                  feature_last,
                                  other_feature_first,
@@ -88,6 +159,11 @@ typename IteratorFloat1::value_type cosine_similarity(const IteratorFloat1& feat
 
     const std::size_t n_features = std::distance(feature_first, feature_last);
 
+    if constexpr (simd::is_dispatchable_v<IteratorFloat1, IteratorFloat2>) {
+        if (n_features >= simd::min_dispatch_n_features) {
+            return simd::cosine_similarity(&*feature_first, &*other_feature_first, n_features);
+        }
+    }
     const FloatType dot_product =
         std::inner_product(feature_first, feature_last, other_feature_first, static_cast<FloatType>(0));
 
@@ -122,4 +198,127 @@ auto heuristic(const Iterator1& feature_first, const Iterator1& feature_last, co
     return euclidean_distance(feature_first, feature_last, other_feature_first);
 }
 
+/**
+ * @brief heuristic with a number of features known at compile time. Meant to be called from a loop that was
+ * dispatched once with common::utils::dispatch_n_features so that the distance is inlined with fixed trip counts.
+ * Falls back to the runtime heuristic for common::utils::dynamic_n_features and non floating point types.
+ *
+ * @tparam NFeatures std::distance(feature_first, feature_last) or common::utils::dynamic_n_features
+ * @tparam Iterator1
+ * @tparam Iterator2
+ * @param feature_first
+ * @param feature_last
+ * @param other_feature_first
+ * @return auto
+ */
+template <std::size_t NFeatures, typename Iterator1, typename Iterator2>
+auto heuristic(const Iterator1& feature_first, const Iterator1& feature_last, const Iterator2& other_feature_first) {
+    using ValueType = typename Iterator1::value_type;
+
+    if constexpr (NFeatures != common::utils::dynamic_n_features && std::is_floating_point_v<ValueType>) {
+        return std::sqrt(squared_euclidean_distance<NFeatures>(feature_first, other_feature_first));
+
+    } else {
+        return heuristic(feature_first, feature_last, other_feature_first);
+    }
+}
+
+/**
+ * @brief Distances from one sample to a block of contiguous samples, written in a buffer provided by the caller. For
+ * floating point types, the kernel is chosen once for the whole block: the features of the sample are kept in
+ * registers when n_features is one of the dimensions specialized at compile time, and the rows with enough features
+ * go to the SIMD kernels of the host. Other types use heuristic for each row.
+ *
+ * @tparam Iterator1
+ * @tparam Iterator2
+ * @tparam OutputIterator random access iterator to at least n_other_samples values
+ * @param feature_first
+ * @param feature_last
+ * @param other_samples_first
+ * @param other_samples_last
+ * @param distances_first the distance to the i-th other sample is written at distances_first + i
+ */
+template <typename Iterator1, typename Iterator2, typename OutputIterator>
+void heuristic_one_to_many(const Iterator1& feature_first,
+                           const Iterator1& feature_last,
+                           const Iterator2& other_samples_first,
+                           const Iterator2& other_samples_last,
+                           OutputIterator   distances_first) {
+    using ValueType = typename Iterator1::value_type;
+
+    const std::size_t n_features = std::distance(feature_first, feature_last);
+    const std::size_t n_other_samples =
+        common::utils::get_n_samples(other_samples_first, other_samples_last, n_features);
+
+    if constexpr (std::is_floating_point_v<ValueType>) {
+        common::utils::dispatch_n_features(n_features, [&](auto n_features_constant) {
+            constexpr std::size_t NFeatures = decltype(n_features_constant)::value;
+
+            if constexpr (NFeatures != common::utils::dynamic_n_features) {
+                std::array<ValueType, NFeatures> features;
+                std::copy(feature_first, feature_last, features.begin());
+
+                for (std::size_t other_sample_index = 0; other_sample_index < n_other_samples; ++other_sample_index) {
+                    *(distances_first + other_sample_index) = std::sqrt(squared_euclidean_distance<NFeatures>(
+                        features.cbegin(), other_samples_first + other_sample_index * NFeatures));
+                }
+            } else {
+                for (std::size_t other_sample_index = 0; other_sample_index < n_other_samples; ++other_sample_index) {
+                    *(distances_first + other_sample_index) = euclidean_distance(
+                        feature_first, feature_last, other_samples_first + other_sample_index * n_features);
+                }
+            }
+        });
+    } else {
+        for (std::size_t other_sample_index = 0; other_sample_index < n_other_samples; ++other_sample_index) {
+            *(distances_first + other_sample_index) =
+                heuristic(feature_first, feature_last, other_samples_first + other_sample_index * n_features);
+        }
+    }
+}
+
+/**
+ * @brief Distances between each pair of samples of 2 blocks of contiguous samples, written row major in a buffer
+ * provided by the caller. The other samples are processed in tiles that stay in the L1 cache while all the samples of
+ * the first block are compared to them with heuristic_one_to_many.
+ *
+ * @tparam Iterator1
+ * @tparam Iterator2
+ * @tparam OutputIterator random access iterator to at least n_samples * n_other_samples values
+ * @param samples_first
+ * @param samples_last
+ * @param other_samples_first
+ * @param other_samples_last
+ * @param n_features
+ * @param distances_first the distance between the i-th sample and the j-th other sample is written at
+ * distances_first + i * n_other_samples + j
+ */
+template <typename Iterator1, typename Iterator2, typename OutputIterator>
+void heuristic_many_to_many(const Iterator1& samples_first,
+                            const Iterator1& samples_last,
+                            const Iterator2& other_samples_first,
+                            const Iterator2& other_samples_last,
+                            std::size_t      n_features,
+                            OutputIterator   distances_first) {
+    using ValueType = typename Iterator2::value_type;
+
+    const std::size_t n_samples       = common::utils::get_n_samples(samples_first, samples_last, n_features);
+    const std::size_t n_other_samples =
+        common::utils::get_n_samples(other_samples_first, other_samples_last, n_features);
+
+    const std::size_t tile_size = std::max<std::size_t>(16, (1 << 14) / (n_features * sizeof(ValueType)));
+
+    for (std::size_t tile_begin = 0; tile_begin < n_other_samples; tile_begin += tile_size) {
+        const std::size_t tile_end = std::min(tile_begin + tile_size, n_other_samples);
+
+        for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+            heuristic_one_to_many(samples_first + sample_index * n_features,
+                                  samples_first + sample_index * n_features + n_features,
+                                  other_samples_first + tile_begin * n_features,
+                                  other_samples_first + tile_end * n_features,
+                                  distances_first + sample_index * n_other_samples + tile_begin);
+        }
+    }
+}
+
 }  // namespace cpp_clustering::heuristic
\ No newline at end of file
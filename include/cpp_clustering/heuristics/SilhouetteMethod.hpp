@@ -1,12 +1,16 @@
 #pragma once
 
 #include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/containers/DatasetHandle.hpp"
 #include "cpp_clustering/heuristics/Heuristics.hpp"
 
 #include <algorithm>
 #include <cmath>
 #include <iterator>
 #include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace cpp_clustering::silhouette_method {
@@ -39,6 +43,46 @@ std::vector<std::size_t> get_cluster_sizes(IteratorInt sample_to_closest_centroi
     }
     return labels_histogram;
 }
+/**
+ * @brief Copies the samples grouped by cluster so that the samples of a cluster are contiguous and can be compared to
+ * another sample in one batch with heuristic::heuristic_one_to_many. The samples keep their relative order within a
+ * cluster. The samples of the cluster c are in the range [offsets[c], offsets[c + 1]) of the sorted samples
+ *
+ * @tparam IteratorFloat
+ * @tparam IteratorInt
+ * @param sample_first
+ * @param sample_to_closest_centroid_index_first
+ * @param cluster_sizes the result of get_cluster_sizes
+ * @param n_features
+ * @return std::pair<std::vector<typename IteratorFloat::value_type>, std::vector<std::size_t>> {the sorted samples,
+ * the offsets of each cluster (cluster_sizes.size() + 1 values)}
+ */
+template <typename IteratorFloat, typename IteratorInt>
+std::pair<std::vector<typename IteratorFloat::value_type>, std::vector<std::size_t>> group_samples_by_cluster(
+    const IteratorFloat&            sample_first,
+    const IteratorInt&              sample_to_closest_centroid_index_first,
+    const std::vector<std::size_t>& cluster_sizes,
+    std::size_t                     n_features) {
+    using FloatType = typename IteratorFloat::value_type;
+
+    auto clusters_offsets = std::vector<std::size_t>(cluster_sizes.size() + 1);
+    std::partial_sum(cluster_sizes.begin(), cluster_sizes.end(), clusters_offsets.begin() + 1);
+
+    const std::size_t n_samples = clusters_offsets.back();
+
+    auto clusters_samples = std::vector<FloatType>(n_samples * n_features);
+    // the next free position in each cluster
+    auto clusters_positions = std::vector<std::size_t>(clusters_offsets.begin(), clusters_offsets.end() - 1);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        const std::size_t centroid_index = *(sample_to_closest_centroid_index_first + sample_index);
+
+        std::copy(sample_first + sample_index * n_features,
+                  sample_first + sample_index * n_features + n_features,
+                  clusters_samples.begin() + clusters_positions[centroid_index]++ * n_features);
+    }
+    return {std::move(clusters_samples), std::move(clusters_offsets)};
+}
 /**
  * @brief The cohesion can be interpreted as a measure of how well each data samples are assigned to a cluster.
  * FORMULA:
@@ -74,26 +118,31 @@ std::vector<typename IteratorFloat::value_type> cohesion(const IteratorFloat& sa
     const auto cluster_sizes =
         get_cluster_sizes(sample_to_closest_centroid_index_first, sample_to_closest_centroid_index_last);
 
+    const auto [clusters_samples, clusters_offsets] =
+        group_samples_by_cluster(sample_first, sample_to_closest_centroid_index_first, cluster_sizes, n_features);
+
     auto samples_cohesion_values = std::vector<FloatType>(n_samples);
+    // the distances from the current sample to the samples of its cluster
+    auto sample_to_cluster_samples_distances =
+        std::vector<FloatType>(*std::max_element(cluster_sizes.begin(), cluster_sizes.end()));
 
     for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
         // get the centroid associated to the current sample
         const std::size_t centroid_index = *(sample_to_closest_centroid_index_first + sample_index);
-        // iterate over all the other data samples by skipping when i == j or C_I != C_J
-        for (std::size_t other_sample_index = 0; other_sample_index < n_samples; ++other_sample_index) {
-            // get the centroid associated to the other sample
-            const std::size_t other_centroid_index = *(sample_to_closest_centroid_index_first + other_sample_index);
-            // compute distance only when sample is not itself and belongs to the same cluster
-            if ((centroid_index == other_centroid_index) && (sample_index != other_sample_index)) {
-                // accumulate the squared distances
-                samples_cohesion_values[sample_index] +=
-                    cpp_clustering::heuristic::heuristic(sample_first + sample_index * n_features,
-                                                         sample_first + sample_index * n_features + n_features,
-                                                         sample_first + other_sample_index * n_features);
-            }
-        }
         // number of samples in the current centroid
         const auto cluster_size = cluster_sizes[centroid_index];
+        // the samples of the same cluster are contiguous. The sample itself is included but its distance is 0
+        cpp_clustering::heuristic::heuristic_one_to_many(
+            sample_first + sample_index * n_features,
+            sample_first + sample_index * n_features + n_features,
+            clusters_samples.begin() + clusters_offsets[centroid_index] * n_features,
+            clusters_samples.begin() + clusters_offsets[centroid_index + 1] * n_features,
+            sample_to_cluster_samples_distances.begin());
+        // accumulate the distances
+        samples_cohesion_values[sample_index] =
+            std::accumulate(sample_to_cluster_samples_distances.begin(),
+                            sample_to_cluster_samples_distances.begin() + cluster_size,
+                            static_cast<FloatType>(0));
         // normalise the sum of the distances from the current sample to all the other samples in the same centroid
         // divide by one if the cluster contains 0 or 1 sample
         if (cluster_size > 1) {
@@ -139,24 +188,40 @@ std::vector<typename IteratorFloat::value_type> separation(const IteratorFloat&
     const auto cluster_sizes =
         get_cluster_sizes(sample_to_closest_centroid_index_first, sample_to_closest_centroid_index_last);
 
+    const auto [clusters_samples, clusters_offsets] =
+        group_samples_by_cluster(sample_first, sample_to_closest_centroid_index_first, cluster_sizes, n_features);
+
     auto samples_separation_values = std::vector<FloatType>(n_samples);
+    // the distances from the current sample to the samples grouped by cluster
+    auto sample_to_clusters_samples_distances = std::vector<FloatType>(n_samples);
 
     for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
         // get the centroid associated to the current sample
         const std::size_t centroid_index = *(sample_to_closest_centroid_index_first + sample_index);
         // the sum of distances from the current sample to other samples from different centroids
         auto sample_to_other_cluster_samples_distance_mean = std::vector<FloatType>(cluster_sizes.size());
-        // iterate over all the other data samples (j) that dont belong to the same cluster
-        for (std::size_t other_sample_index = 0; other_sample_index < n_samples; ++other_sample_index) {
-            // get the centroid associated to the other sample
-            const std::size_t other_centroid_index = *(sample_to_closest_centroid_index_first + other_sample_index);
-            // compute distance only when sample belongs to a different cluster
-            if (centroid_index != other_centroid_index) {
-                // accumulate the squared distances for the correct centroid index
-                sample_to_other_cluster_samples_distance_mean[other_centroid_index] +=
-                    cpp_clustering::heuristic::heuristic(sample_first + sample_index * n_features,
-                                                         sample_first + sample_index * n_features + n_features,
-                                                         sample_first + other_sample_index * n_features);
+        // the distances to the samples of the clusters before and after the one of the current sample
+        cpp_clustering::heuristic::heuristic_one_to_many(
+            sample_first + sample_index * n_features,
+            sample_first + sample_index * n_features + n_features,
+            clusters_samples.begin(),
+            clusters_samples.begin() + clusters_offsets[centroid_index] * n_features,
+            sample_to_clusters_samples_distances.begin());
+
+        cpp_clustering::heuristic::heuristic_one_to_many(
+            sample_first + sample_index * n_features,
+            sample_first + sample_index * n_features + n_features,
+            clusters_samples.begin() + clusters_offsets[centroid_index + 1] * n_features,
+            clusters_samples.end(),
+            sample_to_clusters_samples_distances.begin() + clusters_offsets[centroid_index + 1]);
+        // accumulate the distances for each other cluster
+        for (std::size_t other_centroid_index = 0; other_centroid_index < cluster_sizes.size();
+             ++other_centroid_index) {
+            if (other_centroid_index != centroid_index) {
+                sample_to_other_cluster_samples_distance_mean[other_centroid_index] = std::accumulate(
+                    sample_to_clusters_samples_distances.begin() + clusters_offsets[other_centroid_index],
+                    sample_to_clusters_samples_distances.begin() + clusters_offsets[other_centroid_index + 1],
+                    static_cast<FloatType>(0));
             }
         }
         // normalize each cluster mean distance sum by each cluster's number of samples
@@ -242,6 +307,26 @@ std::vector<typename IteratorFloat::value_type> silhouette(const IteratorFloat&
     return silhouette_values;
 }
 
+/**
+ * @brief Silhouette of the samples of a dataset handle w.r.t. the labels attached to it.
+ *
+ * @tparam IteratorFloat
+ * @param dataset a dataset handle with labels
+ * @return std::vector<typename IteratorFloat::value_type>
+ */
+template <typename IteratorFloat>
+std::vector<typename IteratorFloat::value_type> silhouette(
+    const cpp_clustering::containers::DatasetHandle<IteratorFloat>& dataset) {
+    if (!dataset.has_labels()) {
+        throw std::invalid_argument("The dataset should have labels to compute its silhouette.");
+    }
+    return silhouette(dataset.samples_first(),
+                      dataset.samples_last(),
+                      dataset.labels().begin(),
+                      dataset.labels().end(),
+                      dataset.n_features());
+}
+
 template <typename IteratorFloat>
 typename IteratorFloat::value_type get_mean_silhouette_coefficient(const IteratorFloat& samples_silhouette_first,
                                                                    const IteratorFloat& samples_silhouette_last) {
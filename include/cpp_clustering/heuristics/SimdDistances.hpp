@@ -0,0 +1,571 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CPP_CLUSTERING_SIMD_X86 true
+#include <immintrin.h>
+#define CPP_CLUSTERING_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define CPP_CLUSTERING_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#else
+#define CPP_CLUSTERING_SIMD_X86 false
+#endif
+
+namespace cpp_clustering::heuristic::simd {
+
+/**
+ * @brief The instruction sets that have distance kernels. The best one supported by the host cpu is chosen once at
+ * runtime so that a single portable build (without -march=native) still uses the full vector width of the host.
+ */
+enum class InstructionSet { scalar, avx2, avx512 };
+
+inline InstructionSet detect_instruction_set() {
+#if CPP_CLUSTERING_SIMD_X86 == true
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f")) {
+        return InstructionSet::avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return InstructionSet::avx2;
+    }
+#endif
+    return InstructionSet::scalar;
+}
+
+inline InstructionSet instruction_set() {
+    static const InstructionSet host_instruction_set = detect_instruction_set();
+    return host_instruction_set;
+}
+
+namespace scalar {
+
+template <typename FloatType>
+FloatType squared_euclidean_distance(const FloatType* feature_first,
+                                     const FloatType* other_feature_first,
+                                     std::size_t      n_features) {
+    FloatType result = 0;
+    for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+        const FloatType difference = feature_first[feature_index] - other_feature_first[feature_index];
+        result += difference * difference;
+    }
+    return result;
+}
+
+template <typename FloatType>
+FloatType manhattan_distance(const FloatType* feature_first,
+                             const FloatType* other_feature_first,
+                             std::size_t      n_features) {
+    FloatType result = 0;
+    for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+        result += std::abs(feature_first[feature_index] - other_feature_first[feature_index]);
+    }
+    return result;
+}
+
+template <typename FloatType>
+FloatType cosine_similarity(const FloatType* feature_first,
+                            const FloatType* other_feature_first,
+                            std::size_t      n_features) {
+    FloatType dot_product = 0, magnitude_1 = 0, magnitude_2 = 0;
+    for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+        dot_product += feature_first[feature_index] * other_feature_first[feature_index];
+        magnitude_1 += feature_first[feature_index] * feature_first[feature_index];
+        magnitude_2 += other_feature_first[feature_index] * other_feature_first[feature_index];
+    }
+    if (!magnitude_1 || !magnitude_2) {
+        return 0;
+    }
+    return dot_product / std::sqrt(magnitude_1 * magnitude_2);
+}
+
+}  // namespace scalar
+
+#if CPP_CLUSTERING_SIMD_X86 == true
+
+namespace avx2 {
+
+// 2 accumulators per kernel over chunks of 2 registers so that consecutive fmadd dont wait on each other. The
+// remaining features (less than a register) are accumulated in scalar.
+
+CPP_CLUSTERING_TARGET_AVX2 inline float horizontal_sum(const __m256& vector) {
+    __m128 sums = _mm_add_ps(_mm256_castps256_ps128(vector), _mm256_extractf128_ps(vector, 1));
+    sums        = _mm_add_ps(sums, _mm_movehl_ps(sums, sums));
+    sums        = _mm_add_ss(sums, _mm_movehdup_ps(sums));
+    return _mm_cvtss_f32(sums);
+}
+
+CPP_CLUSTERING_TARGET_AVX2 inline double horizontal_sum(const __m256d& vector) {
+    const __m128d sums = _mm_add_pd(_mm256_castpd256_pd128(vector), _mm256_extractf128_pd(vector, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(sums, _mm_unpackhi_pd(sums, sums)));
+}
+
+CPP_CLUSTERING_TARGET_AVX2 inline float squared_euclidean_distance(const float* feature_first,
+                                                                   const float* other_feature_first,
+                                                                   std::size_t  n_features) {
+    __m256      sum_0 = _mm256_setzero_ps(), sum_1 = _mm256_setzero_ps();
+    std::size_t feature_index = 0;
+
+    for (; feature_index + 16 <= n_features; feature_index += 16) {
+        const __m256 difference_0 = _mm256_sub_ps(_mm256_loadu_ps(feature_first + feature_index),
+                                                  _mm256_loadu_ps(other_feature_first + feature_index));
+        const __m256 difference_1 = _mm256_sub_ps(_mm256_loadu_ps(feature_first + feature_index + 8),
+                                                  _mm256_loadu_ps(other_feature_first + feature_index + 8));
+        sum_0 = _mm256_fmadd_ps(difference_0, difference_0, sum_0);
+        sum_1 = _mm256_fmadd_ps(difference_1, difference_1, sum_1);
+    }
+    for (; feature_index + 8 <= n_features; feature_index += 8) {
+        const __m256 difference = _mm256_sub_ps(_mm256_loadu_ps(feature_first + feature_index),
+                                                _mm256_loadu_ps(other_feature_first + feature_index));
+        sum_0 = _mm256_fmadd_ps(difference, difference, sum_0);
+    }
+    float result = horizontal_sum(_mm256_add_ps(sum_0, sum_1));
+    for (; feature_index < n_features; ++feature_index) {
+        const float difference = feature_first[feature_index] - other_feature_first[feature_index];
+        result += difference * difference;
+    }
+    return result;
+}
+
+CPP_CLUSTERING_TARGET_AVX2 inline double squared_euclidean_distance(const double* feature_first,
+                                                                    const double* other_feature_first,
+                                                                    std::size_t   n_features) {
+    __m256d     sum_0 = _mm256_setzero_pd(), sum_1 = _mm256_setzero_pd();
+    std::size_t feature_index = 0;
+
+    for (; feature_index + 8 <= n_features; feature_index += 8) {
+        const __m256d difference_0 = _mm256_sub_pd(_mm256_loadu_pd(feature_first + feature_index),
+                                                   _mm256_loadu_pd(other_feature_first + feature_index));
+        const __m256d difference_1 = _mm256_sub_pd(_mm256_loadu_pd(feature_first + feature_index + 4),
+                                                   _mm256_loadu_pd(other_feature_first + feature_index + 4));
+        sum_0 = _mm256_fmadd_pd(difference_0, difference_0, sum_0);
+        sum_1 = _mm256_fmadd_pd(difference_1, difference_1, sum_1);
+    }
+    for (; feature_index + 4 <= n_features; feature_index += 4) {
+        const __m256d difference = _mm256_sub_pd(_mm256_loadu_pd(feature_first + feature_index),
+                                                 _mm256_loadu_pd(other_feature_first + feature_index));
+        sum_0 = _mm256_fmadd_pd(difference, difference, sum_0);
+    }
+    double result = horizontal_sum(_mm256_add_pd(sum_0, sum_1));
+    for (; feature_index < n_features; ++feature_index) {
+        const double difference = feature_first[feature_index] - other_feature_first[feature_index];
+        result += difference * difference;
+    }
+    return result;
+}
+
+CPP_CLUSTERING_TARGET_AVX2 inline float manhattan_distance(const float* feature_first,
+                                                           const float* other_feature_first,
+                                                           std::size_t  n_features) {
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    __m256       sum_0 = _mm256_setzero_ps(), sum_1 = _mm256_setzero_ps();
+    std::size_t  feature_index = 0;
+
+    for (; feature_index + 16 <= n_features; feature_index += 16) {
+        const __m256 difference_0 = _mm256_sub_ps(_mm256_loadu_ps(feature_first + feature_index),
+                                                  _mm256_loadu_ps(other_feature_first + feature_index));
+        const __m256 difference_1 = _mm256_sub_ps(_mm256_loadu_ps(feature_first + feature_index + 8),
+                                                  _mm256_loadu_ps(other_feature_first + feature_index + 8));
+        sum_0 = _mm256_add_ps(sum_0, _mm256_andnot_ps(sign_mask, difference_0));
+        sum_1 = _mm256_add_ps(sum_1, _mm256_andnot_ps(sign_mask, difference_1));
+    }
+    for (; feature_index + 8 <= n_features; feature_index += 8) {
+        const __m256 difference = _mm256_sub_ps(_mm256_loadu_ps(feature_first + feature_index),
+                                                _mm256_loadu_ps(other_feature_first + feature_index));
+        sum_0 = _mm256_add_ps(sum_0, _mm256_andnot_ps(sign_mask, difference));
+    }
+    float result = horizontal_sum(_mm256_add_ps(sum_0, sum_1));
+    for (; feature_index < n_features; ++feature_index) {
+        result += std::abs(feature_first[feature_index] - other_feature_first[feature_index]);
+    }
+    return result;
+}
+
+CPP_CLUSTERING_TARGET_AVX2 inline double manhattan_distance(const double* feature_first,
+                                                            const double* other_feature_first,
+                                                            std::size_t   n_features) {
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    __m256d       sum_0 = _mm256_setzero_pd(), sum_1 = _mm256_setzero_pd();
+    std::size_t   feature_index = 0;
+
+    for (; feature_index + 8 <= n_features; feature_index += 8) {
+        const __m256d difference_0 = _mm256_sub_pd(_mm256_loadu_pd(feature_first + feature_index),
+                                                   _mm256_loadu_pd(other_feature_first + feature_index));
+        const __m256d difference_1 = _mm256_sub_pd(_mm256_loadu_pd(feature_first + feature_index + 4),
+                                                   _mm256_loadu_pd(other_feature_first + feature_index + 4));
+        sum_0 = _mm256_add_pd(sum_0, _mm256_andnot_pd(sign_mask, difference_0));
+        sum_1 = _mm256_add_pd(sum_1, _mm256_andnot_pd(sign_mask, difference_1));
+    }
+    for (; feature_index + 4 <= n_features; feature_index += 4) {
+        const __m256d difference = _mm256_sub_pd(_mm256_loadu_pd(feature_first + feature_index),
+                                                 _mm256_loadu_pd(other_feature_first + feature_index));
+        sum_0 = _mm256_add_pd(sum_0, _mm256_andnot_pd(sign_mask, difference));
+    }
+    double result = horizontal_sum(_mm256_add_pd(sum_0, sum_1));
+    for (; feature_index < n_features; ++feature_index) {
+        result += std::abs(feature_first[feature_index] - other_feature_first[feature_index]);
+    }
+    return result;
+}
+
+CPP_CLUSTERING_TARGET_AVX2 inline float cosine_similarity(const float* feature_first,
+                                                          const float* other_feature_first,
+                                                          std::size_t  n_features) {
+    __m256      dot_products = _mm256_setzero_ps(), magnitudes_1 = _mm256_setzero_ps();
+    __m256      magnitudes_2  = _mm256_setzero_ps();
+    std::size_t feature_index = 0;
+
+    for (; feature_index + 8 <= n_features; feature_index += 8) {
+        const __m256 features       = _mm256_loadu_ps(feature_first + feature_index);
+        const __m256 other_features = _mm256_loadu_ps(other_feature_first + feature_index);
+        dot_products                = _mm256_fmadd_ps(features, other_features, dot_products);
+        magnitudes_1                = _mm256_fmadd_ps(features, features, magnitudes_1);
+        magnitudes_2                = _mm256_fmadd_ps(other_features, other_features, magnitudes_2);
+    }
+    float dot_product = horizontal_sum(dot_products);
+    float magnitude_1 = horizontal_sum(magnitudes_1);
+    float magnitude_2 = horizontal_sum(magnitudes_2);
+    for (; feature_index < n_features; ++feature_index) {
+        dot_product += feature_first[feature_index] * other_feature_first[feature_index];
+        magnitude_1 += feature_first[feature_index] * feature_first[feature_index];
+        magnitude_2 += other_feature_first[feature_index] * other_feature_first[feature_index];
+    }
+    if (!magnitude_1 || !magnitude_2) {
+        return 0;
+    }
+    return dot_product / std::sqrt(magnitude_1 * magnitude_2);
+}
+
+CPP_CLUSTERING_TARGET_AVX2 inline double cosine_similarity(const double* feature_first,
+                                                           const double* other_feature_first,
+                                                           std::size_t   n_features) {
+    __m256d     dot_products = _mm256_setzero_pd(), magnitudes_1 = _mm256_setzero_pd();
+    __m256d     magnitudes_2  = _mm256_setzero_pd();
+    std::size_t feature_index = 0;
+
+    for (; feature_index + 4 <= n_features; feature_index += 4) {
+        const __m256d features       = _mm256_loadu_pd(feature_first + feature_index);
+        const __m256d other_features = _mm256_loadu_pd(other_feature_first + feature_index);
+        dot_products                 = _mm256_fmadd_pd(features, other_features, dot_products);
+        magnitudes_1                 = _mm256_fmadd_pd(features, features, magnitudes_1);
+        magnitudes_2                 = _mm256_fmadd_pd(other_features, other_features, magnitudes_2);
+    }
+    double dot_product = horizontal_sum(dot_products);
+    double magnitude_1 = horizontal_sum(magnitudes_1);
+    double magnitude_2 = horizontal_sum(magnitudes_2);
+    for (; feature_index < n_features; ++feature_index) {
+        dot_product += feature_first[feature_index] * other_feature_first[feature_index];
+        magnitude_1 += feature_first[feature_index] * feature_first[feature_index];
+        magnitude_2 += other_feature_first[feature_index] * other_feature_first[feature_index];
+    }
+    if (!magnitude_1 || !magnitude_2) {
+        return 0;
+    }
+    return dot_product / std::sqrt(magnitude_1 * magnitude_2);
+}
+
+}  // namespace avx2
+
+namespace avx512 {
+
+// The remaining features (less than a register) are loaded with a mask instead of being accumulated in scalar.
+
+// Sums the 2 halves with masked extracts because _mm512_reduce_add_* and _mm512_cast*512_*256 trigger -Wuninitialized
+// false positives with gcc 12.
+CPP_CLUSTERING_TARGET_AVX512 inline double horizontal_sum(const __m512d& vector) {
+    const __mmask8 half_mask = static_cast<__mmask8>(0x0F);
+    return avx2::horizontal_sum(_mm256_add_pd(_mm512_maskz_extractf64x4_pd(half_mask, vector, 0),
+                                              _mm512_maskz_extractf64x4_pd(half_mask, vector, 1)));
+}
+
+CPP_CLUSTERING_TARGET_AVX512 inline float horizontal_sum(const __m512& vector) {
+    const __mmask8 half_mask = static_cast<__mmask8>(0x0F);
+    return avx2::horizontal_sum(
+        _mm256_add_ps(_mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(half_mask, _mm512_castps_pd(vector), 0)),
+                      _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(half_mask, _mm512_castps_pd(vector), 1))));
+}
+
+CPP_CLUSTERING_TARGET_AVX512 inline __mmask16 tail_mask_ps(std::size_t n_remaining_features) {
+    return static_cast<__mmask16>((1u << n_remaining_features) - 1u);
+}
+
+CPP_CLUSTERING_TARGET_AVX512 inline __mmask8 tail_mask_pd(std::size_t n_remaining_features) {
+    return static_cast<__mmask8>((1u << n_remaining_features) - 1u);
+}
+
+CPP_CLUSTERING_TARGET_AVX512 inline float squared_euclidean_distance(const float* feature_first,
+                                                                     const float* other_feature_first,
+                                                                     std::size_t  n_features) {
+    __m512      sum_0 = _mm512_setzero_ps(), sum_1 = _mm512_setzero_ps();
+    std::size_t feature_index = 0;
+
+    for (; feature_index + 32 <= n_features; feature_index += 32) {
+        const __m512 difference_0 = _mm512_sub_ps(_mm512_loadu_ps(feature_first + feature_index),
+                                                  _mm512_loadu_ps(other_feature_first + feature_index));
+        const __m512 difference_1 = _mm512_sub_ps(_mm512_loadu_ps(feature_first + feature_index + 16),
+                                                  _mm512_loadu_ps(other_feature_first + feature_index + 16));
+        sum_0 = _mm512_fmadd_ps(difference_0, difference_0, sum_0);
+        sum_1 = _mm512_fmadd_ps(difference_1, difference_1, sum_1);
+    }
+    for (; feature_index + 16 <= n_features; feature_index += 16) {
+        const __m512 difference = _mm512_sub_ps(_mm512_loadu_ps(feature_first + feature_index),
+                                                _mm512_loadu_ps(other_feature_first + feature_index));
+        sum_0 = _mm512_fmadd_ps(difference, difference, sum_0);
+    }
+    if (feature_index < n_features) {
+        const __mmask16 mask       = tail_mask_ps(n_features - feature_index);
+        const __m512    difference = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, feature_first + feature_index),
+                                                _mm512_maskz_loadu_ps(mask, other_feature_first + feature_index));
+        sum_1 = _mm512_fmadd_ps(difference, difference, sum_1);
+    }
+    return horizontal_sum(_mm512_add_ps(sum_0, sum_1));
+}
+
+CPP_CLUSTERING_TARGET_AVX512 inline double squared_euclidean_distance(const double* feature_first,
+                                                                      const double* other_feature_first,
+                                                                      std::size_t   n_features) {
+    __m512d     sum_0 = _mm512_setzero_pd(), sum_1 = _mm512_setzero_pd();
+    std::size_t feature_index = 0;
+
+    for (; feature_index + 16 <= n_features; feature_index += 16) {
+        const __m512d difference_0 = _mm512_sub_pd(_mm512_loadu_pd(feature_first + feature_index),
+                                                   _mm512_loadu_pd(other_feature_first + feature_index));
+        const __m512d difference_1 = _mm512_sub_pd(_mm512_loadu_pd(feature_first + feature_index + 8),
+                                                   _mm512_loadu_pd(other_feature_first + feature_index + 8));
+        sum_0 = _mm512_fmadd_pd(difference_0, difference_0, sum_0);
+        sum_1 = _mm512_fmadd_pd(difference_1, difference_1, sum_1);
+    }
+    for (; feature_index + 8 <= n_features; feature_index += 8) {
+        const __m512d difference = _mm512_sub_pd(_mm512_loadu_pd(feature_first + feature_index),
+                                                 _mm512_loadu_pd(other_feature_first + feature_index));
+        sum_0 = _mm512_fmadd_pd(difference, difference, sum_0);
+    }
+    if (feature_index < n_features) {
+        const __mmask8 mask       = tail_mask_pd(n_features - feature_index);
+        const __m512d  difference = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, feature_first + feature_index),
+                                                 _mm512_maskz_loadu_pd(mask, other_feature_first + feature_index));
+        sum_1 = _mm512_fmadd_pd(difference, difference, sum_1);
+    }
+    return horizontal_sum(_mm512_add_pd(sum_0, sum_1));
+}
+
+CPP_CLUSTERING_TARGET_AVX512 inline float manhattan_distance(const float* feature_first,
+                                                             const float* other_feature_first,
+                                                             std::size_t  n_features) {
+    __m512      sum_0 = _mm512_setzero_ps(), sum_1 = _mm512_setzero_ps();
+    std::size_t feature_index = 0;
+
+    for (; feature_index + 32 <= n_features; feature_index += 32) {
+        const __m512 difference_0 = _mm512_sub_ps(_mm512_loadu_ps(feature_first + feature_index),
+                                                  _mm512_loadu_ps(other_feature_first + feature_index));
+        const __m512 difference_1 = _mm512_sub_ps(_mm512_loadu_ps(feature_first + feature_index + 16),
+                                                  _mm512_loadu_ps(other_feature_first + feature_index + 16));
+        sum_0 = _mm512_add_ps(sum_0, _mm512_abs_ps(difference_0));
+        sum_1 = _mm512_add_ps(sum_1, _mm512_abs_ps(difference_1));
+    }
+    for (; feature_index + 16 <= n_features; feature_index += 16) {
+        const __m512 difference = _mm512_sub_ps(_mm512_loadu_ps(feature_first + feature_index),
+                                                _mm512_loadu_ps(other_feature_first + feature_index));
+        sum_0 = _mm512_add_ps(sum_0, _mm512_abs_ps(difference));
+    }
+    if (feature_index < n_features) {
+        const __mmask16 mask       = tail_mask_ps(n_features - feature_index);
+        const __m512    difference = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, feature_first + feature_index),
+                                                _mm512_maskz_loadu_ps(mask, other_feature_first + feature_index));
+        sum_1 = _mm512_add_ps(sum_1, _mm512_abs_ps(difference));
+    }
+    return horizontal_sum(_mm512_add_ps(sum_0, sum_1));
+}
+
+CPP_CLUSTERING_TARGET_AVX512 inline double manhattan_distance(const double* feature_first,
+                                                              const double* other_feature_first,
+                                                              std::size_t   n_features) {
+    __m512d     sum_0 = _mm512_setzero_pd(), sum_1 = _mm512_setzero_pd();
+    std::size_t feature_index = 0;
+
+    for (; feature_index + 16 <= n_features; feature_index += 16) {
+        const __m512d difference_0 = _mm512_sub_pd(_mm512_loadu_pd(feature_first + feature_index),
+                                                   _mm512_loadu_pd(other_feature_first + feature_index));
+        const __m512d difference_1 = _mm512_sub_pd(_mm512_loadu_pd(feature_first + feature_index + 8),
+                                                   _mm512_loadu_pd(other_feature_first + feature_index + 8));
+        sum_0 = _mm512_add_pd(sum_0, _mm512_abs_pd(difference_0));
+        sum_1 = _mm512_add_pd(sum_1, _mm512_abs_pd(difference_1));
+    }
+    for (; feature_index + 8 <= n_features; feature_index += 8) {
+        const __m512d difference = _mm512_sub_pd(_mm512_loadu_pd(feature_first + feature_index),
+                                                 _mm512_loadu_pd(other_feature_first + feature_index));
+        sum_0 = _mm512_add_pd(sum_0, _mm512_abs_pd(difference));
+    }
+    if (feature_index < n_features) {
+        const __mmask8 mask       = tail_mask_pd(n_features - feature_index);
+        const __m512d  difference = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, feature_first + feature_index),
+                                                 _mm512_maskz_loadu_pd(mask, other_feature_first + feature_index));
+        sum_1 = _mm512_add_pd(sum_1, _mm512_abs_pd(difference));
+    }
+    return horizontal_sum(_mm512_add_pd(sum_0, sum_1));
+}
+
+CPP_CLUSTERING_TARGET_AVX512 inline float cosine_similarity(const float* feature_first,
+                                                            const float* other_feature_first,
+                                                            std::size_t  n_features) {
+    __m512      dot_products = _mm512_setzero_ps(), magnitudes_1 = _mm512_setzero_ps();
+    __m512      magnitudes_2  = _mm512_setzero_ps();
+    std::size_t feature_index = 0;
+
+    for (; feature_index < n_features; feature_index += 16) {
+        const __mmask16 mask = n_features - feature_index >= 16 ? static_cast<__mmask16>(0xFFFF)
+                                                                 : tail_mask_ps(n_features - feature_index);
+        const __m512 features       = _mm512_maskz_loadu_ps(mask, feature_first + feature_index);
+        const __m512 other_features = _mm512_maskz_loadu_ps(mask, other_feature_first + feature_index);
+        dot_products                = _mm512_fmadd_ps(features, other_features, dot_products);
+        magnitudes_1                = _mm512_fmadd_ps(features, features, magnitudes_1);
+        magnitudes_2                = _mm512_fmadd_ps(other_features, other_features, magnitudes_2);
+    }
+    const float dot_product = horizontal_sum(dot_products);
+    const float magnitude_1 = horizontal_sum(magnitudes_1);
+    const float magnitude_2 = horizontal_sum(magnitudes_2);
+
+    if (!magnitude_1 || !magnitude_2) {
+        return 0;
+    }
+    return dot_product / std::sqrt(magnitude_1 * magnitude_2);
+}
+
+CPP_CLUSTERING_TARGET_AVX512 inline double cosine_similarity(const double* feature_first,
+                                                             const double* other_feature_first,
+                                                             std::size_t   n_features) {
+    __m512d     dot_products = _mm512_setzero_pd(), magnitudes_1 = _mm512_setzero_pd();
+    __m512d     magnitudes_2  = _mm512_setzero_pd();
+    std::size_t feature_index = 0;
+
+    for (; feature_index < n_features; feature_index += 8) {
+        const __mmask8 mask = n_features - feature_index >= 8 ? static_cast<__mmask8>(0xFF)
+                                                              : tail_mask_pd(n_features - feature_index);
+        const __m512d features       = _mm512_maskz_loadu_pd(mask, feature_first + feature_index);
+        const __m512d other_features = _mm512_maskz_loadu_pd(mask, other_feature_first + feature_index);
+        dot_products                 = _mm512_fmadd_pd(features, other_features, dot_products);
+        magnitudes_1                 = _mm512_fmadd_pd(features, features, magnitudes_1);
+        magnitudes_2                 = _mm512_fmadd_pd(other_features, other_features, magnitudes_2);
+    }
+    const double dot_product = horizontal_sum(dot_products);
+    const double magnitude_1 = horizontal_sum(magnitudes_1);
+    const double magnitude_2 = horizontal_sum(magnitudes_2);
+
+    if (!magnitude_1 || !magnitude_2) {
+        return 0;
+    }
+    return dot_product / std::sqrt(magnitude_1 * magnitude_2);
+}
+
+}  // namespace avx512
+
+#endif
+
+// Below this number of features the indirect call costs more than what the explicit vector width gains over the
+// inlined loops.
+inline constexpr std::size_t min_dispatch_n_features = 16;
+
+// specialized by the containers of the library that store their elements contiguously (e.g. containers::Dataset)
+template <typename Iterator>
+struct is_contiguous_iterator
+  : std::bool_constant<
+        std::is_pointer_v<Iterator> ||
+        std::is_same_v<Iterator,
+                       typename std::vector<typename std::iterator_traits<Iterator>::value_type>::iterator> ||
+        std::is_same_v<Iterator,
+                       typename std::vector<typename std::iterator_traits<Iterator>::value_type>::const_iterator>> {};
+
+template <typename Iterator>
+inline constexpr bool is_contiguous_iterator_v = is_contiguous_iterator<Iterator>::value;
+
+// whether the ranges of Iterator1 and Iterator2 can be passed as pointers to the kernels
+template <typename Iterator1, typename Iterator2>
+inline constexpr bool is_dispatchable_v =
+    is_contiguous_iterator_v<Iterator1> && is_contiguous_iterator_v<Iterator2> &&
+    std::is_same_v<typename std::iterator_traits<Iterator1>::value_type,
+                   typename std::iterator_traits<Iterator2>::value_type> &&
+    (std::is_same_v<typename std::iterator_traits<Iterator1>::value_type, float> ||
+     std::is_same_v<typename std::iterator_traits<Iterator1>::value_type, double>);
+
+template <typename FloatType>
+struct DistanceKernels {
+    using KernelType = FloatType (*)(const FloatType*, const FloatType*, std::size_t);
+
+    KernelType squared_euclidean_distance;
+    KernelType manhattan_distance;
+    KernelType cosine_similarity;
+};
+
+template <typename FloatType>
+DistanceKernels<FloatType> make_distance_kernels(InstructionSet kernels_instruction_set) {
+    static_assert(std::is_same_v<FloatType, float> || std::is_same_v<FloatType, double>,
+                  "SIMD kernels are only available for float and double.");
+
+    using KernelType = typename DistanceKernels<FloatType>::KernelType;
+
+#if CPP_CLUSTERING_SIMD_X86 == true
+    if (kernels_instruction_set == InstructionSet::avx512) {
+        return {static_cast<KernelType>(&avx512::squared_euclidean_distance),
+                static_cast<KernelType>(&avx512::manhattan_distance),
+                static_cast<KernelType>(&avx512::cosine_similarity)};
+    }
+    if (kernels_instruction_set == InstructionSet::avx2) {
+        return {static_cast<KernelType>(&avx2::squared_euclidean_distance),
+                static_cast<KernelType>(&avx2::manhattan_distance),
+                static_cast<KernelType>(&avx2::cosine_similarity)};
+    }
+#else
+    static_cast<void>(kernels_instruction_set);
+#endif
+    return {&scalar::squared_euclidean_distance<FloatType>,
+            &scalar::manhattan_distance<FloatType>,
+            &scalar::cosine_similarity<FloatType>};
+}
+
+/**
+ * @brief The kernels of the instruction set of the host, resolved on the first call.
+ *
+ * @tparam FloatType float or double
+ * @return const DistanceKernels<FloatType>&
+ */
+template <typename FloatType>
+const DistanceKernels<FloatType>& distance_kernels() {
+    static const DistanceKernels<FloatType> host_distance_kernels = make_distance_kernels<FloatType>(instruction_set());
+    return host_distance_kernels;
+}
+
+// The dispatched kernels are kept out of line so that the callers that inline the small n_features path only pay for
+// a comparison.
+template <typename FloatType>
+[[gnu::noinline]] FloatType squared_euclidean_distance(const FloatType* feature_first,
+                                                       const FloatType* other_feature_first,
+                                                       std::size_t      n_features) {
+    return distance_kernels<FloatType>().squared_euclidean_distance(feature_first, other_feature_first, n_features);
+}
+
+template <typename FloatType>
+[[gnu::noinline]] FloatType euclidean_distance(const FloatType* feature_first,
+                                               const FloatType* other_feature_first,
+                                               std::size_t      n_features) {
+    return std::sqrt(squared_euclidean_distance(feature_first, other_feature_first, n_features));
+}
+
+template <typename FloatType>
+[[gnu::noinline]] FloatType manhattan_distance(const FloatType* feature_first,
+                                               const FloatType* other_feature_first,
+                                               std::size_t      n_features) {
+    return distance_kernels<FloatType>().manhattan_distance(feature_first, other_feature_first, n_features);
+}
+
+template <typename FloatType>
+[[gnu::noinline]] FloatType cosine_similarity(const FloatType* feature_first,
+                                              const FloatType* other_feature_first,
+                                              std::size_t      n_features) {
+    return distance_kernels<FloatType>().cosine_similarity(feature_first, other_feature_first, n_features);
+}
+
+}  // namespace cpp_clustering::heuristic::simd
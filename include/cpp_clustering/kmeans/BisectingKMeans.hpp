@@ -0,0 +1,351 @@
+#pragma once
+
+#include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/heuristics/Heuristics.hpp"
+#include "cpp_clustering/kmeans/KMeans.hpp"
+#include "cpp_clustering/kmeans/KMeansUtils.hpp"
+#include "cpp_clustering/kmeans/Lloyd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
+namespace cpp_clustering {
+
+/**
+ * @brief Bisecting k-means. Starts from a single cluster and repeatedly splits the cluster with the largest sum of
+ * squared errors (SSE) in 2 with a KMeans<T> fit until there are n_centroids clusters. Each split only visits the
+ * samples of the cluster it splits, so an iteration over the whole hierarchy costs O(n_samples * n_features *
+ * log(n_centroids)) when the splits are balanced instead of O(n_samples * n_centroids * n_features) for a flat KMeans.
+ * The splits form a binary tree that predict descends by moving to the nearest of the 2 children of each node.
+ *
+ * @tparam T
+ */
+template <typename T>
+class BisectingKMeans {
+    static_assert(std::is_floating_point<T>::value, "BisectingKMeans only allows floating point types.");
+
+  public:
+    using Options = typename KMeans<T>::Options;
+
+    BisectingKMeans(std::size_t n_centroids, std::size_t n_features);
+
+    BisectingKMeans(std::size_t n_centroids, std::size_t n_features, const Options& options);
+
+    BisectingKMeans(const BisectingKMeans&) = delete;
+
+    BisectingKMeans<T>& set_options(const Options& options);
+
+    template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
+    std::vector<T> fit(const SamplesIterator& data_first, const SamplesIterator& data_last);
+
+    template <typename SamplesIterator>
+    std::vector<T> fit(const SamplesIterator& data_first, const SamplesIterator& data_last);
+
+    template <typename SamplesIterator>
+    std::vector<std::size_t> predict(const SamplesIterator& data_first, const SamplesIterator& data_last) const;
+
+    // number of clusters in the hierarchy: the root, the inner nodes that were split and the leaves (the centroids)
+    std::size_t n_nodes() const {
+        return nodes_children_first_.size();
+    }
+
+  private:
+    // a leaf of the hierarchy while it is being fitted
+    struct Cluster {
+        // indices of the samples of the cluster in the dataset
+        std::vector<std::size_t> sample_indices;
+        // sum of the squared distances from the samples of the cluster to its centroid
+        T sse = 0;
+        // whether the 2-means split below has already been computed
+        bool is_bisected = false;
+        // 2 x n_features_ vectorized matrix of the centroids of the 2 halves of the cluster
+        std::vector<T> children_centroids;
+        // samples and SSE of the 2 halves of the cluster
+        std::array<std::vector<std::size_t>, 2> children_sample_indices;
+        std::array<T, 2>                        children_sse = {0, 0};
+
+        bool is_splittable() const {
+            // a cluster made of copies of the same sample cant be split
+            return sample_indices.size() > 1 && sse > 0;
+        }
+    };
+
+    template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
+    void bisect(const SamplesIterator& data_first, Cluster& cluster) const;
+
+    // number of leaves (centroids) of the hierarchy once fitted
+    std::size_t n_centroids_;
+    // number of features (dimensions) that a BisectingKMeans instance should handle
+    std::size_t n_features_;
+    // n_nodes x n_features_ vectorized matrix of the centroids of all the clusters of the hierarchy, root first
+    std::vector<T> nodes_centroids_;
+    // n_nodes vector of the index of the first of the 2 consecutive children of each node. 0 for the leaves since the
+    // root cant be a child
+    std::vector<std::size_t> nodes_children_first_;
+    // n_nodes vector of the index of the centroid of each leaf in centroids_
+    std::vector<std::size_t> nodes_centroid_indices_;
+    // n_leaves x n_features_ vectorized matrix of the centroids of the leaves in the order of the nodes
+    std::vector<T> centroids_;
+
+    Options options_;
+};
+
+template <typename T>
+BisectingKMeans<T>::BisectingKMeans(std::size_t n_centroids, std::size_t n_features)
+  : n_centroids_{n_centroids}
+  , n_features_{n_features} {}
+
+template <typename T>
+BisectingKMeans<T>::BisectingKMeans(std::size_t n_centroids, std::size_t n_features, const Options& options)
+  : n_centroids_{n_centroids}
+  , n_features_{n_features}
+  , options_{options} {}
+
+template <typename T>
+BisectingKMeans<T>& BisectingKMeans<T>::set_options(const Options& options) {
+    options_ = options;
+    return *this;
+}
+
+/**
+ * @brief Splits the leaves in decreasing SSE order. The split of a leaf only depends on its own samples, so the splits
+ * of several leaves are computed in parallel ahead of time: only the n_centroids - n_leaves leaves with the largest SSE
+ * can still be split (splitting a cluster doesnt increase the SSE) and the splits of those that dont have one yet are
+ * computed together. The leaves are then split one at a time from the largest SSE until the next one hasnt been
+ * bisected yet, which gives the same hierarchy as splitting them strictly one after the other.
+ *
+ * @tparam KMeansAlgorithm used to fit each split with 2 centroids
+ * @tparam SamplesIterator
+ * @param data_first
+ * @param data_last
+ * @return std::vector<T> the centroids of the leaves. There can be less than n_centroids of them if the dataset has
+ * less than n_centroids distinct samples
+ */
+template <typename T>
+template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
+std::vector<T> BisectingKMeans<T>::fit(const SamplesIterator& data_first, const SamplesIterator& data_last) {
+    const std::size_t n_samples = common::utils::get_n_samples(data_first, data_last, n_features_);
+
+    if (n_centroids_ == 0 || n_samples < n_centroids_) {
+        throw std::invalid_argument("The number of samples should be at least the number of centroids.");
+    }
+    // the root is the mean of the dataset
+    nodes_centroids_ = std::vector<T>(n_features_);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        std::transform(nodes_centroids_.begin(),
+                       nodes_centroids_.end(),
+                       data_first + sample_index * n_features_,
+                       nodes_centroids_.begin(),
+                       std::plus<>());
+    }
+    std::transform(nodes_centroids_.begin(),
+                   nodes_centroids_.end(),
+                   nodes_centroids_.begin(),
+                   [n_samples](const auto& feature) { return feature / static_cast<T>(n_samples); });
+
+    nodes_children_first_ = std::vector<std::size_t>(1);
+
+    // the clusters of the nodes, only filled for the leaves
+    auto clusters = std::vector<Cluster>(1);
+
+    clusters[0].sample_indices.resize(n_samples);
+    std::iota(clusters[0].sample_indices.begin(), clusters[0].sample_indices.end(), static_cast<std::size_t>(0));
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        const auto distance = heuristic::heuristic(data_first + sample_index * n_features_,
+                                                   data_first + sample_index * n_features_ + n_features_,
+                                                   nodes_centroids_.begin());
+        clusters[0].sse += distance * distance;
+    }
+    // max heap of the {sse, node_index} of the leaves that can be split
+    auto splittable_leaves = std::vector<std::pair<T, std::size_t>>();
+
+    if (clusters[0].is_splittable()) {
+        splittable_leaves.emplace_back(clusters[0].sse, 0);
+    }
+    std::size_t n_leaves = 1;
+
+    while (n_leaves < n_centroids_ && !splittable_leaves.empty()) {
+        const std::size_t node_index = splittable_leaves.front().second;
+
+        if (!clusters[node_index].is_bisected) {
+            // the leaves that could still be split before reaching n_centroids leaves
+            auto candidates = splittable_leaves;
+
+            const std::size_t n_candidates = std::min(n_centroids_ - n_leaves, candidates.size());
+
+            std::nth_element(
+                candidates.begin(), candidates.begin() + n_candidates - 1, candidates.end(), std::greater<>());
+
+            candidates.resize(n_candidates);
+
+            candidates.erase(std::remove_if(candidates.begin(),
+                                            candidates.end(),
+                                            [&clusters](const auto& candidate) {
+                                                return clusters[candidate.second].is_bisected;
+                                            }),
+                             candidates.end());
+
+            // each split is a KMeans fit with its own parallel regions that run on a single thread when nested
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for schedule(dynamic) if (candidates.size() > 1)
+#endif
+            for (std::size_t candidate_index = 0; candidate_index < candidates.size(); ++candidate_index) {
+                bisect<KMeansAlgorithm>(data_first, clusters[candidates[candidate_index].second]);
+            }
+        }
+        std::pop_heap(splittable_leaves.begin(), splittable_leaves.end());
+        splittable_leaves.pop_back();
+
+        auto children_centroids      = std::move(clusters[node_index].children_centroids);
+        auto children_sample_indices = std::move(clusters[node_index].children_sample_indices);
+        auto children_sse            = clusters[node_index].children_sse;
+
+        // the 2-means fit didnt separate the samples: the leaf stays a leaf
+        if (children_sample_indices[0].empty() || children_sample_indices[1].empty()) {
+            continue;
+        }
+        // the samples now belong to the children
+        clusters[node_index] = Cluster();
+
+        nodes_children_first_[node_index] = nodes_children_first_.size();
+
+        for (std::size_t child_index = 0; child_index < 2; ++child_index) {
+            nodes_centroids_.insert(nodes_centroids_.end(),
+                                    children_centroids.begin() + child_index * n_features_,
+                                    children_centroids.begin() + child_index * n_features_ + n_features_);
+
+            nodes_children_first_.emplace_back(0);
+
+            auto& child = clusters.emplace_back();
+
+            child.sample_indices = std::move(children_sample_indices[child_index]);
+            child.sse            = children_sse[child_index];
+
+            if (child.is_splittable()) {
+                splittable_leaves.emplace_back(child.sse, nodes_children_first_.size() - 1);
+                std::push_heap(splittable_leaves.begin(), splittable_leaves.end());
+            }
+        }
+        ++n_leaves;
+    }
+    // number the leaves in the order of the nodes
+    nodes_centroid_indices_ = std::vector<std::size_t>(n_nodes());
+    centroids_.clear();
+
+    for (std::size_t node_index = 0; node_index < n_nodes(); ++node_index) {
+        if (!nodes_children_first_[node_index]) {
+            nodes_centroid_indices_[node_index] = centroids_.size() / n_features_;
+
+            centroids_.insert(centroids_.end(),
+                              nodes_centroids_.begin() + node_index * n_features_,
+                              nodes_centroids_.begin() + node_index * n_features_ + n_features_);
+        }
+    }
+    return centroids_;
+}
+
+template <typename T>
+template <typename SamplesIterator>
+std::vector<T> BisectingKMeans<T>::fit(const SamplesIterator& data_first, const SamplesIterator& data_last) {
+    // with 2 centroids the bounds of the accelerated algorithms can only skip 2 distances per sample, which doesnt pay
+    // for their buffers
+    return fit<cpp_clustering::Lloyd>(data_first, data_last);
+}
+
+template <typename T>
+template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
+void BisectingKMeans<T>::bisect(const SamplesIterator& data_first, Cluster& cluster) const {
+    const std::size_t n_samples = cluster.sample_indices.size();
+
+    // the samples of the cluster are gathered so that the fit runs on a contiguous range
+    auto cluster_samples = std::vector<T>(n_samples * n_features_);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        std::copy(data_first + cluster.sample_indices[sample_index] * n_features_,
+                  data_first + cluster.sample_indices[sample_index] * n_features_ + n_features_,
+                  cluster_samples.begin() + sample_index * n_features_);
+    }
+    auto kmeans = KMeans<T>(2, n_features_, options_);
+
+    cluster.children_centroids =
+        kmeans.template fit<KMeansAlgorithm>(cluster_samples.cbegin(), cluster_samples.cend());
+
+    auto samples_to_nearest_centroid_indices   = std::vector<std::size_t>(n_samples);
+    auto samples_to_nearest_centroid_distances = std::vector<T>(n_samples);
+
+    kmeans::utils::samples_to_nearest_centroid_indices_and_distances(cluster_samples.cbegin(),
+                                                                     cluster_samples.cend(),
+                                                                     n_features_,
+                                                                     cluster.children_centroids,
+                                                                     samples_to_nearest_centroid_indices.begin(),
+                                                                     samples_to_nearest_centroid_distances.begin());
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        const auto child_index = samples_to_nearest_centroid_indices[sample_index];
+        const auto distance    = samples_to_nearest_centroid_distances[sample_index];
+
+        cluster.children_sample_indices[child_index].emplace_back(cluster.sample_indices[sample_index]);
+        cluster.children_sse[child_index] += distance * distance;
+    }
+    cluster.is_bisected = true;
+}
+
+/**
+ * @brief Assigns each sample to a leaf by descending the hierarchy from the root to the nearest of the 2 children of
+ * each node. Costs O(n_features * depth) per sample instead of O(n_features * n_centroids) for a flat scan, at the
+ * price of not always finding the nearest leaf.
+ *
+ * @tparam SamplesIterator
+ * @param data_first
+ * @param data_last
+ * @return std::vector<std::size_t> the index of the centroid of the leaf of each sample
+ */
+template <typename T>
+template <typename SamplesIterator>
+std::vector<std::size_t> BisectingKMeans<T>::predict(const SamplesIterator& data_first,
+                                                     const SamplesIterator& data_last) const {
+    if (nodes_children_first_.empty()) {
+        throw std::invalid_argument("The BisectingKMeans instance should be fitted before predicting.");
+    }
+    const std::size_t n_samples = common::utils::get_n_samples(data_first, data_last, n_features_);
+
+    auto samples_to_nearest_centroid_indices = std::vector<std::size_t>(n_samples);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for schedule(static)
+#endif
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        const auto sample_first = data_first + sample_index * n_features_;
+        const auto sample_last  = sample_first + n_features_;
+
+        std::size_t node_index = 0;
+
+        while (nodes_children_first_[node_index]) {
+            const std::size_t children_first = nodes_children_first_[node_index];
+
+            const auto first_child_distance = heuristic::heuristic(
+                sample_first, sample_last, nodes_centroids_.begin() + children_first * n_features_);
+
+            const auto second_child_distance = heuristic::heuristic(
+                sample_first, sample_last, nodes_centroids_.begin() + (children_first + 1) * n_features_);
+
+            node_index = second_child_distance < first_child_distance ? children_first + 1 : children_first;
+        }
+        samples_to_nearest_centroid_indices[sample_index] = nodes_centroid_indices_[node_index];
+    }
+    return samples_to_nearest_centroid_indices;
+}
+
+}  // namespace cpp_clustering
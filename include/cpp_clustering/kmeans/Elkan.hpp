@@ -0,0 +1,399 @@
+#pragma once
+
+#include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/heuristics/Heuristics.hpp"
+#include "cpp_clustering/kmeans/KMeansUtils.hpp"
+
+#include <tuple>
+#include <vector>
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
+namespace cpp_clustering {
+
+/**
+ * @brief Elkan's accelerated k-means. Keeps one upper bound and n_centroids lower bounds per sample as well as the
+ * n_centroids x n_centroids table of the distances between the centroids. The additional bounds allow to skip most of
+ * the sample to centroid distances computations in high dimension, at the cost of n_samples x n_centroids memory.
+ *
+ * @tparam Iterator
+ */
+template <typename Iterator>
+class Elkan {
+    static_assert(std::is_floating_point_v<typename Iterator::value_type>, "Elkan allows floating point types.");
+
+  public:
+    using DataType = typename Iterator::value_type;
+
+    // {samples_first_, samples_last_, n_features_}
+    using DatasetDescriptorType = std::tuple<Iterator, Iterator, std::size_t>;
+
+    Elkan(const DatasetDescriptorType& dataset_descriptor, const std::vector<DataType>& centroids);
+
+    Elkan(const DatasetDescriptorType& dataset_descriptor,
+          const std::vector<DataType>& centroids,
+          const DataType&              loss);
+
+    Elkan(const Elkan&) = delete;
+
+    DataType total_deviation() const;
+
+    // total_deviation() is maintained from the upper bounds of the reassigned samples only. This recomputes the
+    // distances from all the samples to their assigned centroids
+    DataType exact_total_deviation() const;
+
+    const std::vector<DataType>& step();
+
+    DataType max_centroid_shift() const;
+
+  private:
+    struct Buffers {
+        Buffers(const Iterator&              samples_first,
+                const Iterator&              samples_last,
+                std::size_t                  n_features,
+                const std::vector<DataType>& centroids);
+
+        Buffers(const DatasetDescriptorType& dataset_descriptor, const std::vector<DataType>& centroids);
+
+        Buffers(const Buffers&) = delete;
+
+        std::vector<std::size_t> samples_to_nearest_centroid_indices_;
+        // upper bounds: distance from each sample to its assigned centroid
+        std::vector<DataType> samples_to_nearest_centroid_distances_;
+        // lower bounds: n_samples x n_centroids distances from each sample to each centroid
+        std::vector<DataType> samples_to_centroids_lower_bounds_;
+
+        // n_centroids x n_centroids distances between each pair of centroids
+        std::vector<DataType> centroid_to_centroid_distances_;
+        std::vector<DataType> centroid_to_nearest_centroid_distances_;
+
+        std::vector<std::size_t> cluster_sizes_;
+        std::vector<DataType>    cluster_position_sums_;
+        // the centroids before the last update, overwritten at each step
+        std::vector<DataType> previous_centroids_;
+        std::vector<DataType> centroid_velocities_;
+
+        // {sample_index, previous_assigned_centroid_index, previous_assigned_centroid_distance} for each sample that
+        // changed cluster during swap_bounds. One container per thread, filled in increasing sample_index order
+        std::vector<std::vector<std::tuple<std::size_t, std::size_t, DataType>>> samples_reassignments_;
+    };
+
+    void update_centroid_to_centroid_distances();
+
+    void swap_bounds();
+
+    DataType update_bounds();
+
+    DatasetDescriptorType    dataset_descriptor_;
+    std::size_t              n_samples_;
+    std::vector<DataType>    centroids_;
+    std::unique_ptr<Buffers> buffers_ptr_;
+    DataType                 loss_;
+    // largest change of a centroid coordinate during the last step
+    DataType max_centroid_shift_;
+};
+
+template <typename Iterator>
+Elkan<Iterator>::Elkan(const DatasetDescriptorType& dataset_descriptor, const std::vector<DataType>& centroids)
+  : Elkan<Iterator>::Elkan(dataset_descriptor, centroids, common::utils::infinity<DataType>()) {
+    // compute initial loss
+    loss_ = std::reduce(buffers_ptr_->samples_to_nearest_centroid_distances_.begin(),
+                        buffers_ptr_->samples_to_nearest_centroid_distances_.end(),
+                        static_cast<typename Elkan<Iterator>::DataType>(0),
+                        std::plus<>());
+}
+
+template <typename Iterator>
+Elkan<Iterator>::Elkan(const DatasetDescriptorType& dataset_descriptor,
+                       const std::vector<DataType>& centroids,
+                       const DataType&              loss)
+  : dataset_descriptor_{dataset_descriptor}
+  , n_samples_{common::utils::get_n_samples(std::get<0>(dataset_descriptor_),
+                                            std::get<1>(dataset_descriptor_),
+                                            std::get<2>(dataset_descriptor_))}
+  , centroids_{centroids}
+  , buffers_ptr_{std::make_unique<Buffers>(dataset_descriptor, centroids_)}
+  , loss_{loss}
+  , max_centroid_shift_{common::utils::infinity<DataType>()} {
+    update_centroid_to_centroid_distances();
+}
+
+template <typename Iterator>
+typename Elkan<Iterator>::DataType Elkan<Iterator>::total_deviation() const {
+    return loss_;
+}
+
+template <typename Iterator>
+typename Elkan<Iterator>::DataType Elkan<Iterator>::exact_total_deviation() const {
+    const auto [samples_first, samples_last, n_features] = dataset_descriptor_;
+
+    return kmeans::utils::assigned_centroids_distances_sum(samples_first,
+                                                           samples_last,
+                                                           n_features,
+                                                           centroids_,
+                                                           buffers_ptr_->samples_to_nearest_centroid_indices_.begin());
+}
+
+template <typename Iterator>
+const std::vector<typename Elkan<Iterator>::DataType>& Elkan<Iterator>::step() {
+    // iterate over all the samples and swap the lower and upper bounds only if necessary
+    swap_bounds();
+
+    // keep a copy of the current non updated centroids in a buffer that is reused from one step to the next
+    std::copy(centroids_.begin(), centroids_.end(), buffers_ptr_->previous_centroids_.begin());
+
+    // update all the centroids with the new intra-cluster positions sum and cluster sizes
+    kmeans::utils::update_centroids(buffers_ptr_->cluster_sizes_,
+                                    buffers_ptr_->cluster_position_sums_,
+                                    std::get<2>(dataset_descriptor_),
+                                    centroids_);
+
+    // upate the centroids velocities based on the previous centroids and the updated centroids
+    max_centroid_shift_ = kmeans::utils::update_centroids_velocities(buffers_ptr_->previous_centroids_,
+                                                                     centroids_,
+                                                                     std::get<2>(dataset_descriptor_),
+                                                                     buffers_ptr_->centroid_velocities_);
+
+    // recompute the loss w.r.t. the updated buffers
+    loss_ = update_bounds();
+
+    return centroids_;
+}
+
+template <typename Iterator>
+typename Elkan<Iterator>::DataType Elkan<Iterator>::max_centroid_shift() const {
+    return max_centroid_shift_;
+}
+
+template <typename Iterator>
+void Elkan<Iterator>::update_centroid_to_centroid_distances() {
+    const std::size_t n_features  = std::get<2>(dataset_descriptor_);
+    const std::size_t n_centroids = centroids_.size() / n_features;
+
+    auto& centroid_to_centroid_distances         = buffers_ptr_->centroid_to_centroid_distances_;
+    auto& centroid_to_nearest_centroid_distances = buffers_ptr_->centroid_to_nearest_centroid_distances_;
+
+    // the table is symmetric so only the lower triangle is computed and then mirrored
+    for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+        centroid_to_centroid_distances[centroid_index * n_centroids + centroid_index] = 0;
+
+        for (std::size_t other_centroid_index = 0; other_centroid_index < centroid_index; ++other_centroid_index) {
+            const auto distance =
+                cpp_clustering::heuristic::heuristic(centroids_.begin() + centroid_index * n_features,
+                                                     centroids_.begin() + centroid_index * n_features + n_features,
+                                                     centroids_.begin() + other_centroid_index * n_features);
+
+            centroid_to_centroid_distances[centroid_index * n_centroids + other_centroid_index] = distance;
+            centroid_to_centroid_distances[other_centroid_index * n_centroids + centroid_index] = distance;
+        }
+    }
+    for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+        auto min_distance = common::utils::infinity<DataType>();
+
+        for (std::size_t other_centroid_index = 0; other_centroid_index < n_centroids; ++other_centroid_index) {
+            if (other_centroid_index != centroid_index) {
+                min_distance = std::min(
+                    min_distance, centroid_to_centroid_distances[centroid_index * n_centroids + other_centroid_index]);
+            }
+        }
+        centroid_to_nearest_centroid_distances[centroid_index] = min_distance;
+    }
+}
+
+template <typename Iterator>
+void Elkan<Iterator>::swap_bounds() {
+    auto& samples_to_nearest_centroid_indices   = buffers_ptr_->samples_to_nearest_centroid_indices_;
+    auto& samples_to_nearest_centroid_distances = buffers_ptr_->samples_to_nearest_centroid_distances_;
+    auto& samples_to_centroids_lower_bounds     = buffers_ptr_->samples_to_centroids_lower_bounds_;
+
+    const auto& centroid_to_centroid_distances         = buffers_ptr_->centroid_to_centroid_distances_;
+    const auto& centroid_to_nearest_centroid_distances = buffers_ptr_->centroid_to_nearest_centroid_distances_;
+
+    auto& samples_reassignments = buffers_ptr_->samples_reassignments_;
+
+    const auto [samples_first, samples_last, n_features] = dataset_descriptor_;
+
+    const std::size_t n_centroids = centroids_.size() / n_features;
+
+    kmeans::utils::reset_samples_reassignments(samples_reassignments);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel
+#endif
+    {
+#if defined(_OPENMP) && THREADS_ENABLED == true
+        auto& thread_samples_reassignments = samples_reassignments[omp_get_thread_num()];
+#else
+        auto& thread_samples_reassignments = samples_reassignments[0];
+#endif
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp for schedule(static)
+#endif
+        for (std::size_t sample_index = 0; sample_index < n_samples_; ++sample_index) {
+            const auto previous_assigned_centroid_index = samples_to_nearest_centroid_indices[sample_index];
+            // skip the sample if its upper bound is smaller than half the distance to the nearest other centroid
+            if (samples_to_nearest_centroid_distances[sample_index] <=
+                static_cast<DataType>(0.5) * centroid_to_nearest_centroid_distances[previous_assigned_centroid_index]) {
+                continue;
+            }
+            const auto previous_assigned_centroid_distance = samples_to_nearest_centroid_distances[sample_index];
+
+            auto assigned_centroid_index = previous_assigned_centroid_index;
+            auto upper_bound             = samples_to_nearest_centroid_distances[sample_index];
+            // whether the upper bound is still a bound or the actual distance to the assigned centroid
+            bool is_upper_bound_tight = false;
+
+            auto lower_bounds_first = samples_to_centroids_lower_bounds.begin() + sample_index * n_centroids;
+
+            for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+                // lower bound test and triangular inequality w.r.t. the currently assigned centroid
+                if (centroid_index == assigned_centroid_index || upper_bound <= lower_bounds_first[centroid_index] ||
+                    upper_bound <= static_cast<DataType>(0.5) *
+                                       centroid_to_centroid_distances[assigned_centroid_index * n_centroids +
+                                                                      centroid_index]) {
+                    continue;
+                }
+                if (!is_upper_bound_tight) {
+                    // tighten upper bound
+                    upper_bound = cpp_clustering::heuristic::heuristic(
+                        samples_first + sample_index * n_features,
+                        samples_first + sample_index * n_features + n_features,
+                        centroids_.begin() + assigned_centroid_index * n_features);
+
+                    lower_bounds_first[assigned_centroid_index] = upper_bound;
+                    is_upper_bound_tight                        = true;
+
+                    // the tests have to be made again with the tightened upper bound
+                    if (upper_bound <= lower_bounds_first[centroid_index] ||
+                        upper_bound <= static_cast<DataType>(0.5) *
+                                           centroid_to_centroid_distances[assigned_centroid_index * n_centroids +
+                                                                          centroid_index]) {
+                        continue;
+                    }
+                }
+                const auto nearest_candidate =
+                    cpp_clustering::heuristic::heuristic(samples_first + sample_index * n_features,
+                                                         samples_first + sample_index * n_features + n_features,
+                                                         centroids_.begin() + centroid_index * n_features);
+
+                lower_bounds_first[centroid_index] = nearest_candidate;
+
+                // if another center is closer than the current assignment
+                if (nearest_candidate < upper_bound) {
+                    upper_bound             = nearest_candidate;
+                    assigned_centroid_index = centroid_index;
+                }
+            }
+            samples_to_nearest_centroid_distances[sample_index] = upper_bound;
+
+            // if the assignment for sample_index has changed
+            if (assigned_centroid_index != previous_assigned_centroid_index) {
+                thread_samples_reassignments.emplace_back(
+                    sample_index, previous_assigned_centroid_index, previous_assigned_centroid_distance);
+
+                samples_to_nearest_centroid_indices[sample_index] = assigned_centroid_index;
+            }
+        }
+    }
+    loss_ += kmeans::utils::merge_samples_reassignments(samples_first,
+                                                        n_features,
+                                                        samples_reassignments,
+                                                        samples_to_nearest_centroid_indices,
+                                                        samples_to_nearest_centroid_distances,
+                                                        buffers_ptr_->cluster_sizes_,
+                                                        buffers_ptr_->cluster_position_sums_);
+}
+
+template <typename Iterator>
+typename Iterator::value_type Elkan<Iterator>::update_bounds() {
+    const std::size_t n_centroids = buffers_ptr_->centroid_velocities_.size();
+
+    const auto& samples_to_nearest_centroid_indices   = buffers_ptr_->samples_to_nearest_centroid_indices_;
+    auto&       samples_to_nearest_centroid_distances = buffers_ptr_->samples_to_nearest_centroid_distances_;
+    auto&       samples_to_centroids_lower_bounds     = buffers_ptr_->samples_to_centroids_lower_bounds_;
+    const auto& centroid_velocities                   = buffers_ptr_->centroid_velocities_;
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for
+#endif
+    for (std::size_t sample_index = 0; sample_index < n_samples_; ++sample_index) {
+        // move the upper bound by the same distance its assigned centroid has moved
+        samples_to_nearest_centroid_distances[sample_index] +=
+            centroid_velocities[samples_to_nearest_centroid_indices[sample_index]];
+
+        // move each lower bound by the distance its centroid has moved
+        auto lower_bounds_first = samples_to_centroids_lower_bounds.begin() + sample_index * n_centroids;
+
+        for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+            lower_bounds_first[centroid_index] = std::max(
+                static_cast<DataType>(0), lower_bounds_first[centroid_index] - centroid_velocities[centroid_index]);
+        }
+    }
+    update_centroid_to_centroid_distances();
+
+    return loss_;
+}
+
+template <typename Iterator>
+Elkan<Iterator>::Buffers::Buffers(const Iterator&                                        samples_first,
+                                  const Iterator&                                        samples_last,
+                                  std::size_t                                            n_features,
+                                  const std::vector<typename Elkan<Iterator>::DataType>& centroids)
+  : samples_to_nearest_centroid_indices_{std::vector<std::size_t>(
+        common::utils::get_n_samples(samples_first, samples_last, n_features))}
+  , samples_to_nearest_centroid_distances_{std::vector<DataType>(samples_to_nearest_centroid_indices_.size())}
+  , samples_to_centroids_lower_bounds_{std::vector<DataType>(samples_to_nearest_centroid_indices_.size() *
+                                                             (centroids.size() / n_features))}
+  , centroid_to_centroid_distances_{std::vector<DataType>((centroids.size() / n_features) *
+                                                          (centroids.size() / n_features))}
+  , centroid_to_nearest_centroid_distances_{std::vector<DataType>(centroids.size() / n_features)}
+  , previous_centroids_{std::vector<DataType>(centroids.size())}
+  , centroid_velocities_{std::vector<DataType>(centroids.size() / n_features)}
+  , samples_reassignments_{std::vector<std::vector<std::tuple<std::size_t, std::size_t, DataType>>>(
+        kmeans::utils::max_n_threads())} {
+    const std::size_t n_samples   = samples_to_nearest_centroid_indices_.size();
+    const std::size_t n_centroids = centroids.size() / n_features;
+
+    // the lower bounds start as the exact distances from each sample to each centroid
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for
+#endif
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        auto        min_distance = common::utils::infinity<DataType>();
+        std::size_t min_index    = 0;
+
+        for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+            const auto distance =
+                cpp_clustering::heuristic::heuristic(samples_first + sample_index * n_features,
+                                                     samples_first + sample_index * n_features + n_features,
+                                                     centroids.begin() + centroid_index * n_features);
+
+            samples_to_centroids_lower_bounds_[sample_index * n_centroids + centroid_index] = distance;
+
+            if (distance < min_distance) {
+                min_distance = distance;
+                min_index    = centroid_index;
+            }
+        }
+        samples_to_nearest_centroid_indices_[sample_index]   = min_index;
+        samples_to_nearest_centroid_distances_[sample_index] = min_distance;
+    }
+    cluster_sizes_ = kmeans::utils::compute_cluster_sizes(
+        samples_to_nearest_centroid_indices_.begin(), samples_to_nearest_centroid_indices_.end(), n_centroids);
+
+    cluster_position_sums_ = kmeans::utils::compute_cluster_positions_sum(
+        samples_first, samples_last, samples_to_nearest_centroid_indices_.begin(), n_centroids, n_features);
+}
+
+template <typename Iterator>
+Elkan<Iterator>::Buffers::Buffers(const DatasetDescriptorType&                           dataset_descriptor,
+                                  const std::vector<typename Elkan<Iterator>::DataType>& centroids)
+  : Elkan<Iterator>::Buffers::Buffers(std::get<0>(dataset_descriptor),
+                                      std::get<1>(dataset_descriptor),
+                                      std::get<2>(dataset_descriptor),
+                                      centroids) {}
+
+}  // namespace cpp_clustering
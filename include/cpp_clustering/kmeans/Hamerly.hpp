@@ -7,6 +7,10 @@
 #include <tuple>
 #include <vector>
 
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
 namespace cpp_clustering {
 
 template <typename Iterator>
@@ -29,7 +33,13 @@ class Hamerly {
 
     DataType total_deviation() const;
 
-    std::vector<DataType> step();
+    // total_deviation() is maintained from the upper bounds of the reassigned samples only. This recomputes the
+    // distances from all the samples to their assigned centroids
+    DataType exact_total_deviation() const;
+
+    const std::vector<DataType>& step();
+
+    DataType max_centroid_shift() const;
 
   private:
     struct Buffers {
@@ -50,15 +60,19 @@ class Hamerly {
 
         std::vector<std::size_t> cluster_sizes_;
         std::vector<DataType>    cluster_position_sums_;
-        std::vector<DataType>    centroid_velocities_;
+        // the centroids before the last update, overwritten at each step
+        std::vector<DataType> previous_centroids_;
+        std::vector<DataType> centroid_velocities_;
+
+        // {sample_index, previous_assigned_centroid_index, previous_assigned_centroid_distance} for each sample that
+        // changed cluster during swap_bounds. One container per thread, filled in increasing sample_index order
+        std::vector<std::vector<std::tuple<std::size_t, std::size_t, DataType>>> samples_reassignments_;
+        // the distances from a sample that failed the bound tests to all the centroids. One container per thread
+        std::vector<std::vector<DataType>> sample_to_centroids_distances_;
     };
 
     void swap_bounds();
 
-    void update_centroids();
-
-    void update_centroids_velocities(const std::vector<DataType>& previous_centroids);
-
     DataType update_bounds();
 
     DatasetDescriptorType    dataset_descriptor_;
@@ -66,6 +80,8 @@ class Hamerly {
     std::vector<DataType>    centroids_;
     std::unique_ptr<Buffers> buffers_ptr_;
     DataType                 loss_;
+    // largest change of a centroid coordinate during the last step
+    DataType max_centroid_shift_;
 };
 
 template <typename Iterator>
@@ -88,7 +104,8 @@ Hamerly<Iterator>::Hamerly(const DatasetDescriptorType& dataset_descriptor,
                                             std::get<2>(dataset_descriptor_))}
   , centroids_{centroids}
   , buffers_ptr_{std::make_unique<Buffers>(dataset_descriptor, centroids_)}
-  , loss_{loss} {}
+  , loss_{loss}
+  , max_centroid_shift_{common::utils::infinity<DataType>()} {}
 
 template <typename Iterator>
 typename Hamerly<Iterator>::DataType Hamerly<Iterator>::total_deviation() const {
@@ -96,18 +113,35 @@ typename Hamerly<Iterator>::DataType Hamerly<Iterator>::total_deviation() const
 }
 
 template <typename Iterator>
-std::vector<typename Hamerly<Iterator>::DataType> Hamerly<Iterator>::step() {
+typename Hamerly<Iterator>::DataType Hamerly<Iterator>::exact_total_deviation() const {
+    const auto [samples_first, samples_last, n_features] = dataset_descriptor_;
+
+    return kmeans::utils::assigned_centroids_distances_sum(samples_first,
+                                                           samples_last,
+                                                           n_features,
+                                                           centroids_,
+                                                           buffers_ptr_->samples_to_nearest_centroid_indices_.begin());
+}
+
+template <typename Iterator>
+const std::vector<typename Hamerly<Iterator>::DataType>& Hamerly<Iterator>::step() {
     // iterate over all the samples and swap the lower and upper bounds only if necessary
     swap_bounds();
 
-    // keep a copy of the current non updated centroids
-    const auto previous_centroids = centroids_;
+    // keep a copy of the current non updated centroids in a buffer that is reused from one step to the next
+    std::copy(centroids_.begin(), centroids_.end(), buffers_ptr_->previous_centroids_.begin());
 
     // update all the centroids with the new intra-cluster positions sum and cluster sizes
-    update_centroids();
+    kmeans::utils::update_centroids(buffers_ptr_->cluster_sizes_,
+                                    buffers_ptr_->cluster_position_sums_,
+                                    std::get<2>(dataset_descriptor_),
+                                    centroids_);
 
     // upate the centroids velocities based on the previous centroids and the updated centroids
-    update_centroids_velocities(previous_centroids);
+    max_centroid_shift_ = kmeans::utils::update_centroids_velocities(buffers_ptr_->previous_centroids_,
+                                                                     centroids_,
+                                                                     std::get<2>(dataset_descriptor_),
+                                                                     buffers_ptr_->centroid_velocities_);
 
     // recompute the loss w.r.t. the updated buffers
     loss_ = update_bounds();
@@ -115,6 +149,11 @@ std::vector<typename Hamerly<Iterator>::DataType> Hamerly<Iterator>::step() {
     return centroids_;
 }
 
+template <typename Iterator>
+typename Hamerly<Iterator>::DataType Hamerly<Iterator>::max_centroid_shift() const {
+    return max_centroid_shift_;
+}
+
 template <typename Iterator>
 void Hamerly<Iterator>::swap_bounds() {
     auto& samples_to_nearest_centroid_indices          = buffers_ptr_->samples_to_nearest_centroid_indices_;
@@ -123,133 +162,113 @@ void Hamerly<Iterator>::swap_bounds() {
 
     const auto& centroid_to_nearest_centroid_distances = buffers_ptr_->centroid_to_nearest_centroid_distances_;
 
-    auto& cluster_sizes         = buffers_ptr_->cluster_sizes_;
-    auto& cluster_position_sums = buffers_ptr_->cluster_position_sums_;
+    auto& samples_reassignments = buffers_ptr_->samples_reassignments_;
 
-    for (std::size_t sample_index = 0; sample_index < n_samples_; ++sample_index) {
-        auto assigned_centroid_index = samples_to_nearest_centroid_indices[sample_index];
-        // triangular inequality
-        const auto upper_bound_comparison =
-            std::max(static_cast<typename Hamerly<Iterator>::DataType>(0.5) *
-                         centroid_to_nearest_centroid_distances[assigned_centroid_index],
-                     samples_to_second_nearest_centroid_distances[sample_index]);
-        // first bound test
-        if (samples_to_nearest_centroid_distances[sample_index] > upper_bound_comparison) {
-            const auto [samples_first, samples_last, n_features] = dataset_descriptor_;
-            // tighten upper bound
-            auto upper_bound =
-                cpp_clustering::heuristic::heuristic(samples_first + sample_index * n_features,
-                                                     samples_first + sample_index * n_features + n_features,
-                                                     centroids_.begin() + assigned_centroid_index * n_features);
-
-            const auto previous_assigned_centroid_distance = samples_to_nearest_centroid_distances[sample_index];
-
-            samples_to_nearest_centroid_distances[sample_index] = upper_bound;
-
-            // second bound test
-            if (samples_to_nearest_centroid_distances[sample_index] > upper_bound_comparison) {
-                auto lower_bound = common::utils::infinity<typename Hamerly<Iterator>::DataType>();
-
-                const std::size_t n_centroids = centroids_.size() / n_features;
-
-                for (std::size_t other_centroid_index = 0; other_centroid_index < n_centroids; ++other_centroid_index) {
-                    if (other_centroid_index != assigned_centroid_index) {
-                        const auto other_nearest_candidate = cpp_clustering::heuristic::heuristic(
-                            samples_first + sample_index * n_features,
-                            samples_first + sample_index * n_features + n_features,
-                            centroids_.begin() + other_centroid_index * n_features);
-
-                        // if another center is closer than the current assignment
-                        if (other_nearest_candidate < upper_bound) {
-                            // change the lower bound to be the current upper bound
-                            lower_bound = upper_bound;
-                            // adjust the upper bound
-                            upper_bound = other_nearest_candidate;
-                            // adjust the current assignment
-                            assigned_centroid_index = other_centroid_index;
-
-                        } else if (other_nearest_candidate < lower_bound) {
-                            // reduce the lower bound to the second nearest centroid
-                            lower_bound = other_nearest_candidate;
-                        }
-                    }
-                }
-                samples_to_second_nearest_centroid_distances[sample_index] = lower_bound;
-
-                // if the assignment for sample_index has changed
-                if (samples_to_nearest_centroid_indices[sample_index] != assigned_centroid_index) {
-                    samples_to_nearest_centroid_distances[sample_index] = upper_bound;
-
-                    const auto previous_assigned_centroid_index = samples_to_nearest_centroid_indices[sample_index];
-
-                    --cluster_sizes[previous_assigned_centroid_index];
-                    ++cluster_sizes[assigned_centroid_index];
-                    samples_to_nearest_centroid_indices[sample_index] = assigned_centroid_index;
-
-                    // subtract the current sample to the centroid it was previously assigned to
-                    std::transform(
-                        cluster_position_sums.begin() + previous_assigned_centroid_index * n_features,
-                        cluster_position_sums.begin() + previous_assigned_centroid_index * n_features + n_features,
-                        samples_first + sample_index * n_features,
-                        cluster_position_sums.begin() + previous_assigned_centroid_index * n_features,
-                        std::minus<>());
-
-                    // add the current sample to the centroid it is now assigned to
-                    std::transform(cluster_position_sums.begin() + assigned_centroid_index * n_features,
-                                   cluster_position_sums.begin() + assigned_centroid_index * n_features + n_features,
-                                   samples_first + sample_index * n_features,
-                                   cluster_position_sums.begin() + assigned_centroid_index * n_features,
-                                   std::plus<>());
-
-                    // update the loss by removing its previous contribution and adding the new one
-                    loss_ -= previous_assigned_centroid_distance;
-                    loss_ += upper_bound;
-                }
-            }
-        }
-    }
-}
+    const auto [samples_first, samples_last, n_features] = dataset_descriptor_;
 
-template <typename Iterator>
-void Hamerly<Iterator>::update_centroids() {
-    const std::size_t n_features  = std::get<2>(dataset_descriptor_);
     const std::size_t n_centroids = centroids_.size() / n_features;
 
-    const auto& cluster_sizes         = buffers_ptr_->cluster_sizes_;
-    const auto& cluster_position_sums = buffers_ptr_->cluster_position_sums_;
-
-    // Update the centroids using the assigned samples
-    for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
-        const auto feature_index_start = centroid_index * n_features;
-        const auto feature_index_end   = feature_index_start + n_features;
-
-        if (cluster_sizes[centroid_index]) {
-            // Compute the new centroid position for the centroid that has more than 1 associated sample
-            std::transform(cluster_position_sums.begin() + feature_index_start,
-                           cluster_position_sums.begin() + feature_index_end,
-                           centroids_.begin() + feature_index_start,
-                           [cluster_size = cluster_sizes[centroid_index]](const auto& sum) {
-                               return sum / static_cast<typename Hamerly<Iterator>::DataType>(cluster_size);
-                           });
-        }
+    auto& sample_to_centroids_distances = buffers_ptr_->sample_to_centroids_distances_;
+
+    kmeans::utils::reset_samples_reassignments(samples_reassignments);
+
+    // the buffers only need to grow if the number of threads has been raised since they were made
+    if (sample_to_centroids_distances.size() < samples_reassignments.size()) {
+        sample_to_centroids_distances.resize(samples_reassignments.size(), std::vector<DataType>(n_centroids));
     }
-}
 
-template <typename Iterator>
-void Hamerly<Iterator>::update_centroids_velocities(
-    const std::vector<typename Hamerly<Iterator>::DataType>& previous_centroids) {
-    const std::size_t n_features  = std::get<2>(dataset_descriptor_);
-    const std::size_t n_centroids = centroids_.size() / n_features;
+    // Each sample only modifies its own bounds and assignment so the samples can be processed independently. The
+    // samples that change cluster are recorded per thread and the shared cluster buffers are updated afterwards
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel
+#endif
+    {
+#if defined(_OPENMP) && THREADS_ENABLED == true
+        auto& thread_samples_reassignments         = samples_reassignments[omp_get_thread_num()];
+        auto& thread_sample_to_centroids_distances = sample_to_centroids_distances[omp_get_thread_num()];
+#else
+        auto& thread_samples_reassignments         = samples_reassignments[0];
+        auto& thread_sample_to_centroids_distances = sample_to_centroids_distances[0];
+#endif
+
+        // static scheduling gives each thread a contiguous range of samples in thread number order
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp for schedule(static)
+#endif
+        for (std::size_t sample_index = 0; sample_index < n_samples_; ++sample_index) {
+            auto assigned_centroid_index = samples_to_nearest_centroid_indices[sample_index];
+            // triangular inequality
+            const auto upper_bound_comparison =
+                std::max(static_cast<typename Hamerly<Iterator>::DataType>(0.5) *
+                             centroid_to_nearest_centroid_distances[assigned_centroid_index],
+                         samples_to_second_nearest_centroid_distances[sample_index]);
+            // first bound test
+            if (samples_to_nearest_centroid_distances[sample_index] > upper_bound_comparison) {
+                const auto sample_first = samples_first + sample_index * n_features;
+                const auto sample_last  = sample_first + n_features;
+                // tighten upper bound
+                auto upper_bound = cpp_clustering::heuristic::heuristic(
+                    sample_first, sample_last, centroids_.begin() + assigned_centroid_index * n_features);
+
+                const auto previous_assigned_centroid_distance = samples_to_nearest_centroid_distances[sample_index];
+
+                samples_to_nearest_centroid_distances[sample_index] = upper_bound;
+
+                // second bound test
+                if (samples_to_nearest_centroid_distances[sample_index] > upper_bound_comparison) {
+                    auto lower_bound = common::utils::infinity<typename Hamerly<Iterator>::DataType>();
+
+                    cpp_clustering::heuristic::heuristic_one_to_many(
+                        sample_first,
+                        sample_last,
+                        centroids_.begin(),
+                        centroids_.end(),
+                        thread_sample_to_centroids_distances.begin());
+
+                    for (std::size_t other_centroid_index = 0; other_centroid_index < n_centroids;
+                         ++other_centroid_index) {
+                        if (other_centroid_index != assigned_centroid_index) {
+                            const auto other_nearest_candidate =
+                                thread_sample_to_centroids_distances[other_centroid_index];
+
+                            // if another center is closer than the current assignment
+                            if (other_nearest_candidate < upper_bound) {
+                                // change the lower bound to be the current upper bound
+                                lower_bound = upper_bound;
+                                // adjust the upper bound
+                                upper_bound = other_nearest_candidate;
+                                // adjust the current assignment
+                                assigned_centroid_index = other_centroid_index;
+
+                            } else if (other_nearest_candidate < lower_bound) {
+                                // reduce the lower bound to the second nearest centroid
+                                lower_bound = other_nearest_candidate;
+                            }
+                        }
+                    }
+                    samples_to_second_nearest_centroid_distances[sample_index] = lower_bound;
 
-    auto& centroid_velocities = buffers_ptr_->centroid_velocities_;
+                    // if the assignment for sample_index has changed
+                    if (samples_to_nearest_centroid_indices[sample_index] != assigned_centroid_index) {
+                        samples_to_nearest_centroid_distances[sample_index] = upper_bound;
 
-    // compute the distances between the non updated and updated centroids
-    for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
-        centroid_velocities[centroid_index] =
-            cpp_clustering::heuristic::heuristic(previous_centroids.begin() + centroid_index * n_features,
-                                                 previous_centroids.begin() + centroid_index * n_features + n_features,
-                                                 centroids_.begin() + centroid_index * n_features);
+                        thread_samples_reassignments.emplace_back(sample_index,
+                                                                  samples_to_nearest_centroid_indices[sample_index],
+                                                                  previous_assigned_centroid_distance);
+
+                        samples_to_nearest_centroid_indices[sample_index] = assigned_centroid_index;
+                    }
+                }
+            }
+        }
     }
+    loss_ += kmeans::utils::merge_samples_reassignments(samples_first,
+                                                        n_features,
+                                                        samples_reassignments,
+                                                        samples_to_nearest_centroid_indices,
+                                                        samples_to_nearest_centroid_distances,
+                                                        buffers_ptr_->cluster_sizes_,
+                                                        buffers_ptr_->cluster_position_sums_);
 }
 
 template <typename Iterator>
@@ -276,8 +295,10 @@ typename Iterator::value_type Hamerly<Iterator>::update_bounds() {
             (assigned_centroid_index == furthest_moving_centroid_index) ? second_furthest_moving_centroid_distance
                                                                         : furthest_moving_centroid_distance;
     }
-    buffers_ptr_->centroid_to_nearest_centroid_distances_ = kmeans::utils::nearest_neighbor_distances(
-        centroids_.begin(), centroids_.end(), std::get<2>(dataset_descriptor_));
+    kmeans::utils::nearest_neighbor_distances(centroids_.begin(),
+                                              centroids_.end(),
+                                              std::get<2>(dataset_descriptor_),
+                                              buffers_ptr_->centroid_to_nearest_centroid_distances_.begin());
 
     return loss_;
 }
@@ -287,14 +308,9 @@ Hamerly<Iterator>::Buffers::Buffers(const Iterator&
                                     const Iterator&                                          samples_last,
                                     std::size_t                                              n_features,
                                     const std::vector<typename Hamerly<Iterator>::DataType>& centroids)
-  : samples_to_nearest_centroid_indices_{kmeans::utils::samples_to_nearest_centroid_indices(samples_first,
-                                                                                            samples_last,
-                                                                                            n_features,
-                                                                                            centroids)}
-  , samples_to_nearest_centroid_distances_{kmeans::utils::samples_to_nearest_centroid_distances(samples_first,
-                                                                                                samples_last,
-                                                                                                n_features,
-                                                                                                centroids)}
+  : samples_to_nearest_centroid_indices_{std::vector<std::size_t>(
+        common::utils::get_n_samples(samples_first, samples_last, n_features))}
+  , samples_to_nearest_centroid_distances_{std::vector<DataType>(samples_to_nearest_centroid_indices_.size())}
   , samples_to_second_nearest_centroid_distances_{kmeans::utils::samples_to_second_nearest_centroid_distances(
         samples_first,
         samples_last,
@@ -303,15 +319,29 @@ Hamerly<Iterator>::Buffers::Buffers(const Iterator&
   , centroid_to_nearest_centroid_distances_{kmeans::utils::nearest_neighbor_distances(centroids.begin(),
                                                                                       centroids.end(),
                                                                                       n_features)}
-  , cluster_sizes_{kmeans::utils::compute_cluster_sizes(samples_to_nearest_centroid_indices_.begin(),
-                                                        samples_to_nearest_centroid_indices_.end(),
-                                                        centroids.size() / n_features)}
-  , cluster_position_sums_{kmeans::utils::compute_cluster_positions_sum(samples_first,
-                                                                        samples_last,
-                                                                        samples_to_nearest_centroid_indices_.begin(),
-                                                                        centroids.size() / n_features,
-                                                                        n_features)}
-  , centroid_velocities_{std::vector<typename Hamerly<Iterator>::DataType>(centroids.size() / n_features)} {}
+  , previous_centroids_{std::vector<typename Hamerly<Iterator>::DataType>(centroids.size())}
+  , centroid_velocities_{std::vector<typename Hamerly<Iterator>::DataType>(centroids.size() / n_features)}
+  , samples_reassignments_{std::vector<std::vector<std::tuple<std::size_t, std::size_t, DataType>>>(
+        kmeans::utils::max_n_threads())}
+  , sample_to_centroids_distances_{std::vector<std::vector<DataType>>(kmeans::utils::max_n_threads(),
+                                                                      std::vector<DataType>(centroids.size() /
+                                                                                            n_features))} {
+    // the nearest centroid indices and distances come from the same pass
+    kmeans::utils::samples_to_nearest_centroid_indices_and_distances(samples_first,
+                                                                     samples_last,
+                                                                     n_features,
+                                                                     centroids,
+                                                                     samples_to_nearest_centroid_indices_.begin(),
+                                                                     samples_to_nearest_centroid_distances_.begin());
+
+    const std::size_t n_centroids = centroids.size() / n_features;
+
+    cluster_sizes_ = kmeans::utils::compute_cluster_sizes(
+        samples_to_nearest_centroid_indices_.begin(), samples_to_nearest_centroid_indices_.end(), n_centroids);
+
+    cluster_position_sums_ = kmeans::utils::compute_cluster_positions_sum(
+        samples_first, samples_last, samples_to_nearest_centroid_indices_.begin(), n_centroids, n_features);
+}
 
 template <typename Iterator>
 Hamerly<Iterator>::Buffers::Buffers(const DatasetDescriptorType&                             dataset_descriptor,
@@ -0,0 +1,433 @@
+#pragma once
+
+#include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/heuristics/Heuristics.hpp"
+#include "cpp_clustering/kmeans/Hamerly.hpp"
+#include "cpp_clustering/kmeans/KMeans.hpp"
+#include "cpp_clustering/kmeans/KMeansUtils.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
+namespace cpp_clustering {
+
+/**
+ * @brief Hierarchical k-means tree (vocabulary tree, https://ieeexplore.ieee.org/document/1641018). Each node is split
+ * in branching_factor children by a KMeans<T> fit on its own samples, down to depth levels, which gives up to
+ * branching_factor^depth leaves (the centroids). predict and forward descend the tree from the root and only compare a
+ * sample to the children of the beam_width nearest nodes of each level: O(beam_width * branching_factor * depth *
+ * n_features) per sample instead of O(n_centroids * n_features) for a flat KMeans. A beam width of 1 is a greedy
+ * descent, larger beam widths are more likely to reach the nearest leaf.
+ *
+ * @tparam T
+ */
+template <typename T>
+class HierarchicalKMeans {
+    static_assert(std::is_floating_point<T>::value, "HierarchicalKMeans only allows floating point types.");
+
+  public:
+    using Options = typename KMeans<T>::Options;
+
+    HierarchicalKMeans(std::size_t branching_factor, std::size_t depth, std::size_t n_features);
+
+    HierarchicalKMeans(std::size_t    branching_factor,
+                       std::size_t    depth,
+                       std::size_t    n_features,
+                       const Options& options);
+
+    HierarchicalKMeans(const HierarchicalKMeans&) = delete;
+
+    HierarchicalKMeans<T>& set_options(const Options& options);
+
+    // number of nodes per level that predict and forward keep while descending the tree
+    HierarchicalKMeans<T>& set_beam_width(std::size_t beam_width);
+
+    template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
+    std::vector<T> fit(const SamplesIterator& data_first, const SamplesIterator& data_last);
+
+    template <typename SamplesIterator>
+    std::vector<T> fit(const SamplesIterator& data_first, const SamplesIterator& data_last);
+
+    template <typename SamplesIterator>
+    std::vector<T> forward(const SamplesIterator& data_first, const SamplesIterator& data_last) const;
+
+    template <typename SamplesIterator>
+    std::vector<std::size_t> predict(const SamplesIterator& data_first, const SamplesIterator& data_last) const;
+
+    std::size_t n_nodes() const {
+        return nodes_children_first_.size();
+    }
+
+    std::size_t n_centroids() const {
+        return centroids_.size() / n_features_;
+    }
+
+  private:
+    template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
+    void split(const SamplesIterator&                 data_first,
+               const std::vector<std::size_t>&        sample_indices,
+               std::vector<T>&                        children_centroids,
+               std::vector<std::vector<std::size_t>>& children_sample_indices) const;
+
+    template <typename SamplesIterator, typename IteratorInt, typename IteratorFloat>
+    void samples_to_nearest_leaf_indices_and_distances(const SamplesIterator& data_first,
+                                                       const SamplesIterator& data_last,
+                                                       IteratorInt            samples_to_nearest_leaf_indices_first,
+                                                       IteratorFloat samples_to_nearest_leaf_distances_first) const;
+
+    // maximum number of children of a node
+    std::size_t branching_factor_;
+    // maximum number of levels below the root
+    std::size_t depth_;
+    // number of features (dimensions) that a HierarchicalKMeans instance should handle
+    std::size_t n_features_;
+    std::size_t beam_width_ = 1;
+    // n_nodes x n_features_ vectorized matrix of the centroids of all the nodes of the tree, level by level from the
+    // root. The children of a node are consecutive
+    std::vector<T> nodes_centroids_;
+    // n_nodes vectors of the index of the first child and of the number of children of each node (0 for the leaves)
+    std::vector<std::size_t> nodes_children_first_;
+    std::vector<std::size_t> nodes_n_children_;
+    // n_nodes vector of the index of the centroid of each leaf in centroids_
+    std::vector<std::size_t> nodes_centroid_indices_;
+    // n_leaves x n_features_ vectorized matrix of the centroids of the leaves in the order of the nodes
+    std::vector<T> centroids_;
+
+    Options options_;
+};
+
+template <typename T>
+HierarchicalKMeans<T>::HierarchicalKMeans(std::size_t branching_factor, std::size_t depth, std::size_t n_features)
+  : branching_factor_{branching_factor}
+  , depth_{depth}
+  , n_features_{n_features} {}
+
+template <typename T>
+HierarchicalKMeans<T>::HierarchicalKMeans(std::size_t    branching_factor,
+                                          std::size_t    depth,
+                                          std::size_t    n_features,
+                                          const Options& options)
+  : branching_factor_{branching_factor}
+  , depth_{depth}
+  , n_features_{n_features}
+  , options_{options} {}
+
+template <typename T>
+HierarchicalKMeans<T>& HierarchicalKMeans<T>::set_options(const Options& options) {
+    options_ = options;
+    return *this;
+}
+
+template <typename T>
+HierarchicalKMeans<T>& HierarchicalKMeans<T>::set_beam_width(std::size_t beam_width) {
+    if (!beam_width) {
+        throw std::invalid_argument("The beam width should be at least 1.");
+    }
+    beam_width_ = beam_width;
+    return *this;
+}
+
+/**
+ * @brief Builds the tree level by level. The nodes of a level are split independently from each other so they are
+ * fitted in parallel, then their children are appended in the order of the nodes so that the tree doesnt depend on the
+ * number of threads. A node becomes a leaf when it has less than branching_factor samples, when its samples are all the
+ * same or when its fit leaves less than 2 non empty children. The empty children are dropped.
+ *
+ * @tparam KMeansAlgorithm used to fit the children of each node
+ * @tparam SamplesIterator
+ * @param data_first
+ * @param data_last
+ * @return std::vector<T> the centroids of the leaves
+ */
+template <typename T>
+template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
+std::vector<T> HierarchicalKMeans<T>::fit(const SamplesIterator& data_first, const SamplesIterator& data_last) {
+    const std::size_t n_samples = common::utils::get_n_samples(data_first, data_last, n_features_);
+
+    if (branching_factor_ < 2) {
+        throw std::invalid_argument("The branching factor should be at least 2.");
+    }
+    if (!n_samples) {
+        throw std::invalid_argument("The dataset should contain at least one sample.");
+    }
+    // the root is the mean of the dataset
+    nodes_centroids_ = std::vector<T>(n_features_);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        std::transform(nodes_centroids_.begin(),
+                       nodes_centroids_.end(),
+                       data_first + sample_index * n_features_,
+                       nodes_centroids_.begin(),
+                       std::plus<>());
+    }
+    std::transform(nodes_centroids_.begin(),
+                   nodes_centroids_.end(),
+                   nodes_centroids_.begin(),
+                   [n_samples](const auto& feature) { return feature / static_cast<T>(n_samples); });
+
+    nodes_children_first_ = std::vector<std::size_t>(1);
+    nodes_n_children_     = std::vector<std::size_t>(1);
+
+    // the nodes of the current level and their samples
+    auto level_nodes          = std::vector<std::size_t>(1, 0);
+    auto level_sample_indices = std::vector<std::vector<std::size_t>>(1, std::vector<std::size_t>(n_samples));
+
+    std::iota(level_sample_indices[0].begin(), level_sample_indices[0].end(), static_cast<std::size_t>(0));
+
+    for (std::size_t level_index = 0; level_index < depth_ && !level_nodes.empty(); ++level_index) {
+        auto level_children_centroids      = std::vector<std::vector<T>>(level_nodes.size());
+        auto level_children_sample_indices = std::vector<std::vector<std::vector<std::size_t>>>(level_nodes.size());
+
+        // each fit has its own parallel regions that run on a single thread when nested
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for schedule(dynamic) if (level_nodes.size() > 1)
+#endif
+        for (std::size_t node_index = 0; node_index < level_nodes.size(); ++node_index) {
+            split<KMeansAlgorithm>(data_first,
+                                   level_sample_indices[node_index],
+                                   level_children_centroids[node_index],
+                                   level_children_sample_indices[node_index]);
+        }
+        auto next_level_nodes          = std::vector<std::size_t>();
+        auto next_level_sample_indices = std::vector<std::vector<std::size_t>>();
+
+        for (std::size_t node_index = 0; node_index < level_nodes.size(); ++node_index) {
+            const auto& children_centroids      = level_children_centroids[node_index];
+            auto&       children_sample_indices = level_children_sample_indices[node_index];
+
+            nodes_children_first_[level_nodes[node_index]] = n_nodes();
+            nodes_n_children_[level_nodes[node_index]]     = children_sample_indices.size();
+
+            for (std::size_t child_index = 0; child_index < children_sample_indices.size(); ++child_index) {
+                next_level_nodes.emplace_back(n_nodes());
+                next_level_sample_indices.emplace_back(std::move(children_sample_indices[child_index]));
+
+                nodes_centroids_.insert(nodes_centroids_.end(),
+                                        children_centroids.begin() + child_index * n_features_,
+                                        children_centroids.begin() + child_index * n_features_ + n_features_);
+                nodes_children_first_.emplace_back(0);
+                nodes_n_children_.emplace_back(0);
+            }
+        }
+        level_nodes          = std::move(next_level_nodes);
+        level_sample_indices = std::move(next_level_sample_indices);
+    }
+    // number the leaves in the order of the nodes
+    nodes_centroid_indices_ = std::vector<std::size_t>(n_nodes());
+    centroids_.clear();
+
+    for (std::size_t node_index = 0; node_index < n_nodes(); ++node_index) {
+        if (!nodes_n_children_[node_index]) {
+            nodes_centroid_indices_[node_index] = n_centroids();
+
+            centroids_.insert(centroids_.end(),
+                              nodes_centroids_.begin() + node_index * n_features_,
+                              nodes_centroids_.begin() + node_index * n_features_ + n_features_);
+        }
+    }
+    return centroids_;
+}
+
+template <typename T>
+template <typename SamplesIterator>
+std::vector<T> HierarchicalKMeans<T>::fit(const SamplesIterator& data_first, const SamplesIterator& data_last) {
+    return fit<cpp_clustering::Hamerly>(data_first, data_last);
+}
+
+/**
+ * @brief Fits branching_factor centroids on the samples of a node and groups the samples by nearest centroid. The
+ * outputs are left empty when the node should be a leaf.
+ *
+ * @tparam KMeansAlgorithm
+ * @tparam SamplesIterator
+ * @param data_first
+ * @param sample_indices the indices of the samples of the node in the dataset
+ * @param children_centroids output n_children x n_features_ vectorized matrix of the centroids of the children
+ * @param children_sample_indices output n_children vectors of the indices of the samples of each child
+ */
+template <typename T>
+template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
+void HierarchicalKMeans<T>::split(const SamplesIterator&                 data_first,
+                                  const std::vector<std::size_t>&        sample_indices,
+                                  std::vector<T>&                        children_centroids,
+                                  std::vector<std::vector<std::size_t>>& children_sample_indices) const {
+    const std::size_t n_samples = sample_indices.size();
+
+    if (n_samples < branching_factor_) {
+        return;
+    }
+    // the samples of the node are gathered so that the fit runs on a contiguous range
+    auto node_samples = std::vector<T>(n_samples * n_features_);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        std::copy(data_first + sample_indices[sample_index] * n_features_,
+                  data_first + sample_indices[sample_index] * n_features_ + n_features_,
+                  node_samples.begin() + sample_index * n_features_);
+    }
+    // kmeans++ cant pick distinct centroids among copies of the same sample
+    bool has_distinct_samples = false;
+
+    for (std::size_t sample_index = 1; sample_index < n_samples && !has_distinct_samples; ++sample_index) {
+        has_distinct_samples = !std::equal(node_samples.begin(),
+                                           node_samples.begin() + n_features_,
+                                           node_samples.begin() + sample_index * n_features_);
+    }
+    if (!has_distinct_samples) {
+        return;
+    }
+    auto kmeans = KMeans<T>(branching_factor_, n_features_, options_);
+
+    const auto centroids = kmeans.template fit<KMeansAlgorithm>(node_samples.cbegin(), node_samples.cend());
+
+    const auto samples_to_nearest_centroid_indices = kmeans::utils::samples_to_nearest_centroid_indices(
+        node_samples.cbegin(), node_samples.cend(), n_features_, centroids);
+
+    auto centroids_sample_indices = std::vector<std::vector<std::size_t>>(branching_factor_);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        centroids_sample_indices[samples_to_nearest_centroid_indices[sample_index]].emplace_back(
+            sample_indices[sample_index]);
+    }
+    // the empty clusters arent kept as children
+    for (std::size_t centroid_index = 0; centroid_index < branching_factor_; ++centroid_index) {
+        if (!centroids_sample_indices[centroid_index].empty()) {
+            children_centroids.insert(children_centroids.end(),
+                                      centroids.begin() + centroid_index * n_features_,
+                                      centroids.begin() + centroid_index * n_features_ + n_features_);
+            children_sample_indices.emplace_back(std::move(centroids_sample_indices[centroid_index]));
+        }
+    }
+    if (children_sample_indices.size() < 2) {
+        children_centroids.clear();
+        children_sample_indices.clear();
+    }
+}
+
+/**
+ * @brief Beam search from the root: at each level the nodes of the beam are replaced by their children (the leaves
+ * stay in the beam as they are) and only the beam_width nearest nodes are kept, until the beam only contains leaves.
+ *
+ * @tparam SamplesIterator
+ * @tparam IteratorInt
+ * @tparam IteratorFloat
+ * @param data_first
+ * @param data_last
+ * @param samples_to_nearest_leaf_indices_first output of n_samples indices of the nearest leaf found in centroids_
+ * @param samples_to_nearest_leaf_distances_first output of n_samples distances to the nearest leaf found
+ */
+template <typename T>
+template <typename SamplesIterator, typename IteratorInt, typename IteratorFloat>
+void HierarchicalKMeans<T>::samples_to_nearest_leaf_indices_and_distances(
+    const SamplesIterator& data_first,
+    const SamplesIterator& data_last,
+    IteratorInt            samples_to_nearest_leaf_indices_first,
+    IteratorFloat          samples_to_nearest_leaf_distances_first) const {
+    if (nodes_children_first_.empty()) {
+        throw std::invalid_argument("The HierarchicalKMeans instance should be fitted before predicting.");
+    }
+    const std::size_t n_samples = common::utils::get_n_samples(data_first, data_last, n_features_);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel
+#endif
+    {
+        // {distance, node_index} of the nodes of the current level and of their children
+        auto beam       = std::vector<std::pair<T, std::size_t>>();
+        auto candidates = std::vector<std::pair<T, std::size_t>>();
+        // distances from a sample to the children of a node
+        auto children_distances = std::vector<T>(branching_factor_);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp for schedule(static)
+#endif
+        for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+            const auto sample_first = data_first + sample_index * n_features_;
+            const auto sample_last  = sample_first + n_features_;
+
+            beam.assign(1, {heuristic::heuristic(sample_first, sample_last, nodes_centroids_.begin()), 0});
+
+            bool has_inner_nodes = nodes_n_children_[0] > 0;
+
+            while (has_inner_nodes) {
+                candidates.clear();
+                has_inner_nodes = false;
+
+                for (const auto& [distance, node_index] : beam) {
+                    const std::size_t children_first = nodes_children_first_[node_index];
+                    const std::size_t n_children     = nodes_n_children_[node_index];
+
+                    if (!n_children) {
+                        candidates.emplace_back(distance, node_index);
+                        continue;
+                    }
+                    heuristic::heuristic_one_to_many(
+                        sample_first,
+                        sample_last,
+                        nodes_centroids_.begin() + children_first * n_features_,
+                        nodes_centroids_.begin() + (children_first + n_children) * n_features_,
+                        children_distances.begin());
+
+                    for (std::size_t child_index = 0; child_index < n_children; ++child_index) {
+                        candidates.emplace_back(children_distances[child_index], children_first + child_index);
+
+                        has_inner_nodes |= nodes_n_children_[children_first + child_index] > 0;
+                    }
+                }
+                if (candidates.size() > beam_width_) {
+                    std::nth_element(candidates.begin(), candidates.begin() + beam_width_ - 1, candidates.end());
+                    candidates.resize(beam_width_);
+
+                    has_inner_nodes = std::any_of(candidates.begin(), candidates.end(), [this](const auto& candidate) {
+                        return nodes_n_children_[candidate.second] > 0;
+                    });
+                }
+                std::swap(beam, candidates);
+            }
+            const auto& [nearest_leaf_distance, nearest_leaf_node_index] = *std::min_element(beam.begin(), beam.end());
+
+            samples_to_nearest_leaf_indices_first[sample_index]   = nodes_centroid_indices_[nearest_leaf_node_index];
+            samples_to_nearest_leaf_distances_first[sample_index] = nearest_leaf_distance;
+        }
+    }
+}
+
+template <typename T>
+template <typename SamplesIterator>
+std::vector<T> HierarchicalKMeans<T>::forward(const SamplesIterator& data_first,
+                                              const SamplesIterator& data_last) const {
+    const std::size_t n_samples = common::utils::get_n_samples(data_first, data_last, n_features_);
+
+    auto samples_to_nearest_leaf_indices   = std::vector<std::size_t>(n_samples);
+    auto samples_to_nearest_leaf_distances = std::vector<T>(n_samples);
+
+    samples_to_nearest_leaf_indices_and_distances(
+        data_first, data_last, samples_to_nearest_leaf_indices.begin(), samples_to_nearest_leaf_distances.begin());
+
+    return samples_to_nearest_leaf_distances;
+}
+
+template <typename T>
+template <typename SamplesIterator>
+std::vector<std::size_t> HierarchicalKMeans<T>::predict(const SamplesIterator& data_first,
+                                                        const SamplesIterator& data_last) const {
+    const std::size_t n_samples = common::utils::get_n_samples(data_first, data_last, n_features_);
+
+    auto samples_to_nearest_leaf_indices   = std::vector<std::size_t>(n_samples);
+    auto samples_to_nearest_leaf_distances = std::vector<T>(n_samples);
+
+    samples_to_nearest_leaf_indices_and_distances(
+        data_first, data_last, samples_to_nearest_leaf_indices.begin(), samples_to_nearest_leaf_distances.begin());
+
+    return samples_to_nearest_leaf_indices;
+}
+
+}  // namespace cpp_clustering
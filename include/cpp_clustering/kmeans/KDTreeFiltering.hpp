@@ -0,0 +1,540 @@
+#pragma once
+
+#include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/containers/kdtree/KDTree.hpp"
+#include "cpp_clustering/heuristics/Heuristics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
+namespace cpp_clustering {
+
+/**
+ * @brief Filtering k-means (https://www.cs.umd.edu/~mount/Projects/KMeans/pami02.pdf). The samples are stored in a
+ * KDTree whose nodes keep the number, the sum and the sum of the squared norms of the samples of their subtree. Each
+ * step goes down the tree with a list of candidate centroids per node: the candidates that are farther than the
+ * candidate closest to the midpoint of the bounding box of the node for every point of the box are removed. Once a
+ * single candidate is left, the whole subtree is assigned to it with the statistics of the node, without visiting its
+ * samples. Works best with a few features and many samples.
+ *
+ * The loss is the sum of the squared distances from the samples to their nearest centroid since it can be computed
+ * from the statistics of the nodes.
+ *
+ * @tparam Iterator
+ */
+template <typename Iterator>
+class KDTreeFiltering {
+    static_assert(std::is_floating_point_v<typename Iterator::value_type>,
+                  "KDTreeFiltering allows floating point types.");
+
+  public:
+    using DataType = typename Iterator::value_type;
+
+    // {samples_first_, samples_last_, n_features_}
+    using DatasetDescriptorType = std::tuple<Iterator, Iterator, std::size_t>;
+
+    KDTreeFiltering(const DatasetDescriptorType& dataset_descriptor, const std::vector<DataType>& centroids);
+
+    KDTreeFiltering(const DatasetDescriptorType& dataset_descriptor,
+                    const std::vector<DataType>& centroids,
+                    const DataType&              loss);
+
+    KDTreeFiltering(const KDTreeFiltering&) = delete;
+
+    DataType total_deviation();
+
+    const std::vector<DataType>& step();
+
+    DataType max_centroid_shift() const;
+
+  private:
+    // the KDTree reorders the samples so it is built on a copy of them
+    using SamplesIterator = typename std::vector<DataType>::iterator;
+
+    // cluster sizes, intra-cluster sums of positions and loss accumulated during a pass over the tree
+    struct Statistics {
+        std::vector<std::size_t> cluster_sizes_;
+        std::vector<DataType>    cluster_position_sums_;
+        DataType                 loss_;
+        // the candidates of the nodes from the root to the current node, one list after the other
+        std::vector<std::size_t> candidates_;
+    };
+
+    struct Buffers {
+        Buffers(const Iterator&              samples_first,
+                const Iterator&              samples_last,
+                std::size_t                  n_features,
+                const std::vector<DataType>& centroids);
+
+        Buffers(const DatasetDescriptorType& dataset_descriptor, const std::vector<DataType>& centroids);
+
+        Buffers(const Buffers&) = delete;
+
+        std::size_t add_node(std::size_t     kdnode_index,
+                             SamplesIterator samples_first,
+                             SamplesIterator samples_last,
+                             std::size_t     n_features);
+
+        std::vector<DataType>               samples_;
+        containers::KDTree<SamplesIterator> kdtree_;
+        // the samples of the leaves or the median samples of the cuts of the kdtree in depth first order and the
+        // indices of their children (0 for the leaves since the root cant be a child)
+        std::vector<containers::SamplesRangeType<SamplesIterator>> nodes_samples_;
+        std::vector<std::array<std::size_t, 2>>                    nodes_children_;
+        // number, sum (n_nodes x n_features) and sum of the squared norms of the samples of the subtree of each node
+        std::vector<std::size_t> nodes_n_samples_;
+        std::vector<DataType>    nodes_position_sums_;
+        std::vector<DataType>    nodes_squared_norms_sums_;
+        // smallest box containing the samples of the subtree of each node (n_nodes x n_features), tighter than the cell
+        // of the kdnode
+        std::vector<std::pair<DataType, DataType>> nodes_bounding_boxes_;
+
+        std::vector<std::size_t> cluster_sizes_;
+        std::vector<DataType>    cluster_position_sums_;
+
+        // statistics accumulated by each thread, kept from one step to the next
+        std::vector<Statistics> threads_statistics_;
+        // {node_index, candidates} of the subtrees that are filtered in parallel
+        std::vector<std::pair<std::size_t, std::vector<std::size_t>>> subtrees_;
+    };
+
+    void update_centroids();
+
+    DataType update_buffers();
+
+    void filter(std::size_t node_index,
+                std::size_t candidates_begin,
+                std::size_t depth,
+                Statistics& statistics,
+                bool        collect_subtrees);
+
+    void add_sample(const SamplesIterator& sample_first,
+                    std::size_t            candidates_begin,
+                    Statistics&            statistics) const;
+
+    DatasetDescriptorType    dataset_descriptor_;
+    std::size_t              n_samples_;
+    std::vector<DataType>    centroids_;
+    std::unique_ptr<Buffers> buffers_ptr_;
+    DataType                 loss_;
+    // largest change of a centroid coordinate during the last step
+    DataType max_centroid_shift_;
+    // depth at which the tree is split in subtrees filtered in parallel
+    std::size_t parallel_depth_;
+};
+
+template <typename Iterator>
+KDTreeFiltering<Iterator>::KDTreeFiltering(const DatasetDescriptorType& dataset_descriptor,
+                                           const std::vector<DataType>& centroids)
+  : KDTreeFiltering<Iterator>::KDTreeFiltering(dataset_descriptor, centroids, common::utils::infinity<DataType>()) {}
+
+template <typename Iterator>
+KDTreeFiltering<Iterator>::KDTreeFiltering(const DatasetDescriptorType& dataset_descriptor,
+                                           const std::vector<DataType>& centroids,
+                                           const DataType&              loss)
+  : dataset_descriptor_{dataset_descriptor}
+  , n_samples_{common::utils::get_n_samples(std::get<0>(dataset_descriptor_),
+                                            std::get<1>(dataset_descriptor_),
+                                            std::get<2>(dataset_descriptor_))}
+  , centroids_{centroids}
+  , buffers_ptr_{std::make_unique<Buffers>(dataset_descriptor, centroids_)}
+  , loss_{loss}
+  , max_centroid_shift_{common::utils::infinity<DataType>()} {
+#if defined(_OPENMP) && THREADS_ENABLED == true
+    const std::size_t n_threads = std::max(1, omp_get_max_threads());
+#else
+    const std::size_t n_threads = 1;
+#endif
+    // about 8 subtrees per thread to balance the pruning that differs from one subtree to the other
+    parallel_depth_ = n_threads > 1 ? static_cast<std::size_t>(std::ceil(std::log2(n_threads))) + 3 : 0;
+
+    // initial assignment, cluster sizes, intra-cluster sum of positions and loss
+    loss_ = update_buffers();
+}
+
+template <typename Iterator>
+typename KDTreeFiltering<Iterator>::DataType KDTreeFiltering<Iterator>::total_deviation() {
+    return loss_;
+}
+
+template <typename Iterator>
+const std::vector<typename KDTreeFiltering<Iterator>::DataType>& KDTreeFiltering<Iterator>::step() {
+    // update all the centroids with the new intra-cluster positions sum and cluster sizes
+    update_centroids();
+    // recompute the loss w.r.t. the updated buffers
+    loss_ = update_buffers();
+    return centroids_;
+}
+
+template <typename Iterator>
+typename KDTreeFiltering<Iterator>::DataType KDTreeFiltering<Iterator>::max_centroid_shift() const {
+    return max_centroid_shift_;
+}
+
+template <typename Iterator>
+void KDTreeFiltering<Iterator>::update_centroids() {
+    const auto        n_features  = std::get<2>(dataset_descriptor_);
+    const std::size_t n_centroids = centroids_.size() / n_features;
+
+    const auto& cluster_sizes         = buffers_ptr_->cluster_sizes_;
+    const auto& cluster_position_sums = buffers_ptr_->cluster_position_sums_;
+
+    max_centroid_shift_ = 0;
+
+    for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+        // the centroids without samples keep their position
+        if (!cluster_sizes[centroid_index]) {
+            continue;
+        }
+        for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+            auto& coordinate = centroids_[centroid_index * n_features + feature_index];
+
+            const auto updated_coordinate = cluster_position_sums[centroid_index * n_features + feature_index] /
+                                            static_cast<DataType>(cluster_sizes[centroid_index]);
+
+            max_centroid_shift_ = std::max(max_centroid_shift_, std::abs(updated_coordinate - coordinate));
+
+            coordinate = updated_coordinate;
+        }
+    }
+}
+
+/**
+ * @brief Single pass over the tree that accumulates the cluster sizes, the intra-cluster sums of positions and the
+ * loss. With several threads, the top of the tree is filtered first down to parallel_depth_ and the subtrees left
+ * with more than one candidate are then filtered in parallel, each thread in its own statistics which are summed in
+ * thread order.
+ *
+ * @return KDTreeFiltering<Iterator>::DataType the loss
+ */
+template <typename Iterator>
+typename Iterator::value_type KDTreeFiltering<Iterator>::update_buffers() {
+    const std::size_t n_features  = std::get<2>(dataset_descriptor_);
+    const std::size_t n_centroids = centroids_.size() / n_features;
+
+    auto& threads_statistics = buffers_ptr_->threads_statistics_;
+    auto& subtrees           = buffers_ptr_->subtrees_;
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+    const std::size_t n_threads = std::max(1, omp_get_max_threads());
+#else
+    const std::size_t n_threads = 1;
+#endif
+    threads_statistics.resize(n_threads);
+
+    // reset all the buffers beforehand since the parallel region might use less threads than requested
+    for (auto& statistics : threads_statistics) {
+        statistics.cluster_sizes_.assign(n_centroids, 0);
+        statistics.cluster_position_sums_.assign(n_centroids * n_features, static_cast<DataType>(0));
+        statistics.loss_ = 0;
+        statistics.candidates_.resize(n_centroids);
+        std::iota(statistics.candidates_.begin(), statistics.candidates_.end(), static_cast<std::size_t>(0));
+    }
+    subtrees.clear();
+
+    // the top of the tree is filtered in the statistics of the first thread
+    filter(0, 0, 0, threads_statistics[0], parallel_depth_ > 0);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for schedule(static)
+#endif
+    for (std::size_t subtree_index = 0; subtree_index < subtrees.size(); ++subtree_index) {
+#if defined(_OPENMP) && THREADS_ENABLED == true
+        auto& statistics = threads_statistics[omp_get_thread_num()];
+#else
+        auto& statistics = threads_statistics[0];
+#endif
+        statistics.candidates_ = subtrees[subtree_index].second;
+
+        filter(subtrees[subtree_index].first, 0, parallel_depth_, statistics, false);
+    }
+    auto& cluster_sizes         = buffers_ptr_->cluster_sizes_;
+    auto& cluster_position_sums = buffers_ptr_->cluster_position_sums_;
+
+    cluster_sizes.assign(n_centroids, 0);
+    cluster_position_sums.assign(n_centroids * n_features, static_cast<DataType>(0));
+
+    auto loss = static_cast<DataType>(0);
+
+    // merge the threads buffers in thread order so that the result doesnt depend on the scheduling
+    for (const auto& statistics : threads_statistics) {
+        std::transform(cluster_sizes.begin(),
+                       cluster_sizes.end(),
+                       statistics.cluster_sizes_.begin(),
+                       cluster_sizes.begin(),
+                       std::plus<>());
+
+        std::transform(cluster_position_sums.begin(),
+                       cluster_position_sums.end(),
+                       statistics.cluster_position_sums_.begin(),
+                       cluster_position_sums.begin(),
+                       std::plus<>());
+
+        loss += statistics.loss_;
+    }
+    return loss;
+}
+
+/**
+ * @brief Filters the candidates [candidates_begin, end) of statistics.candidates_ for a node and recurses on its
+ * children with the remaining ones.
+ *
+ * @param node_index
+ * @param candidates_begin
+ * @param depth depth of the node in the tree
+ * @param statistics
+ * @param collect_subtrees whether the nodes at parallel_depth_ are recorded in subtrees_ instead of being filtered
+ */
+template <typename Iterator>
+void KDTreeFiltering<Iterator>::filter(std::size_t node_index,
+                                       std::size_t candidates_begin,
+                                       std::size_t depth,
+                                       Statistics& statistics,
+                                       bool        collect_subtrees) {
+    const std::size_t n_features = std::get<2>(dataset_descriptor_);
+    const std::size_t n_samples  = buffers_ptr_->nodes_n_samples_[node_index];
+
+    if (!n_samples) {
+        return;
+    }
+    const auto& node_samples = buffers_ptr_->nodes_samples_[node_index];
+    const auto  bounding_box = buffers_ptr_->nodes_bounding_boxes_.begin() + node_index * n_features;
+    auto&       candidates   = statistics.candidates_;
+
+    const std::size_t candidates_end = candidates.size();
+
+    // the candidate closest to the midpoint of the bounding box
+    std::size_t closest_candidate = candidates[candidates_begin];
+    auto        closest_distance  = common::utils::infinity<DataType>();
+
+    for (std::size_t candidate_index = candidates_begin; candidate_index < candidates_end; ++candidate_index) {
+        const auto centroid_first = centroids_.begin() + candidates[candidate_index] * n_features;
+
+        DataType distance = 0;
+
+        for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+            const DataType difference =
+                *(centroid_first + feature_index) -
+                (bounding_box[feature_index].first + bounding_box[feature_index].second) / 2;
+
+            distance += difference * difference;
+        }
+        if (distance < closest_distance) {
+            closest_distance  = distance;
+            closest_candidate = candidates[candidate_index];
+        }
+    }
+    const auto closest_centroid_first = centroids_.begin() + closest_candidate * n_features;
+
+    // the candidates that arent farther than the closest candidate for every point of the box are appended
+    for (std::size_t candidate_index = candidates_begin; candidate_index < candidates_end; ++candidate_index) {
+        const std::size_t candidate = candidates[candidate_index];
+
+        if (candidate == closest_candidate) {
+            candidates.emplace_back(candidate);
+            continue;
+        }
+        const auto centroid_first = centroids_.begin() + candidate * n_features;
+
+        DataType candidate_distance = 0, closest_candidate_distance = 0;
+
+        // the vertex of the box the furthest in the direction from the closest candidate to the candidate
+        for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+            const DataType vertex_feature =
+                *(centroid_first + feature_index) > *(closest_centroid_first + feature_index)
+                    ? bounding_box[feature_index].second
+                    : bounding_box[feature_index].first;
+
+            const DataType candidate_difference         = *(centroid_first + feature_index) - vertex_feature;
+            const DataType closest_candidate_difference = *(closest_centroid_first + feature_index) - vertex_feature;
+
+            candidate_distance += candidate_difference * candidate_difference;
+            closest_candidate_distance += closest_candidate_difference * closest_candidate_difference;
+        }
+        if (candidate_distance < closest_candidate_distance) {
+            candidates.emplace_back(candidate);
+        }
+    }
+    if (candidates.size() - candidates_end == 1) {
+        // the whole subtree is assigned to the closest candidate
+        const auto node_position_sums_first = buffers_ptr_->nodes_position_sums_.begin() + node_index * n_features;
+
+        statistics.cluster_sizes_[closest_candidate] += n_samples;
+
+        std::transform(statistics.cluster_position_sums_.begin() + closest_candidate * n_features,
+                       statistics.cluster_position_sums_.begin() + closest_candidate * n_features + n_features,
+                       node_position_sums_first,
+                       statistics.cluster_position_sums_.begin() + closest_candidate * n_features,
+                       std::plus<>());
+
+        // sum of the squared distances: sum ||x||^2 - 2 * <c, sum x> + n * ||c||^2
+        const auto dot_product = std::transform_reduce(
+            closest_centroid_first, closest_centroid_first + n_features, node_position_sums_first, DataType{0});
+        const auto squared_norm = std::transform_reduce(
+            closest_centroid_first, closest_centroid_first + n_features, closest_centroid_first, DataType{0});
+
+        statistics.loss_ += std::max(DataType{0},
+                                     buffers_ptr_->nodes_squared_norms_sums_[node_index] - 2 * dot_product +
+                                         static_cast<DataType>(n_samples) * squared_norm);
+
+    } else if (collect_subtrees && depth == parallel_depth_) {
+        buffers_ptr_->subtrees_.emplace_back(
+            node_index, std::vector<std::size_t>(candidates.begin() + candidates_end, candidates.end()));
+
+    } else {
+        // the samples of a leaf or the median sample of a cut
+        for (auto sample_first = node_samples.first; sample_first != node_samples.second; sample_first += n_features) {
+            add_sample(sample_first, candidates_end, statistics);
+        }
+        if (buffers_ptr_->nodes_children_[node_index][0]) {
+            const auto& children = buffers_ptr_->nodes_children_[node_index];
+
+            filter(children[0], candidates_end, depth + 1, statistics, collect_subtrees);
+            filter(children[1], candidates_end, depth + 1, statistics, collect_subtrees);
+        }
+    }
+    candidates.resize(candidates_end);
+}
+
+template <typename Iterator>
+void KDTreeFiltering<Iterator>::add_sample(const SamplesIterator& sample_first,
+                                           std::size_t            candidates_begin,
+                                           Statistics&            statistics) const {
+    const std::size_t n_features = std::get<2>(dataset_descriptor_);
+
+    std::size_t nearest_candidate = statistics.candidates_[candidates_begin];
+    auto        nearest_distance  = common::utils::infinity<DataType>();
+
+    for (std::size_t candidate_index = candidates_begin; candidate_index < statistics.candidates_.size();
+         ++candidate_index) {
+        const std::size_t candidate = statistics.candidates_[candidate_index];
+
+        const auto distance = heuristic::squared_euclidean_distance(
+            sample_first, sample_first + n_features, centroids_.begin() + candidate * n_features);
+
+        if (distance < nearest_distance) {
+            nearest_distance  = distance;
+            nearest_candidate = candidate;
+        }
+    }
+    ++statistics.cluster_sizes_[nearest_candidate];
+
+    std::transform(statistics.cluster_position_sums_.begin() + nearest_candidate * n_features,
+                   statistics.cluster_position_sums_.begin() + nearest_candidate * n_features + n_features,
+                   sample_first,
+                   statistics.cluster_position_sums_.begin() + nearest_candidate * n_features,
+                   std::plus<>());
+
+    statistics.loss_ += nearest_distance;
+}
+
+template <typename Iterator>
+KDTreeFiltering<Iterator>::Buffers::Buffers(const Iterator&              samples_first,
+                                            const Iterator&              samples_last,
+                                            std::size_t                  n_features,
+                                            const std::vector<DataType>& centroids)
+  : samples_{samples_first, samples_last}
+  , kdtree_{samples_.begin(), samples_.end(), n_features}
+  , cluster_sizes_{std::vector<std::size_t>(centroids.size() / n_features)}
+  , cluster_position_sums_{std::vector<DataType>(centroids.size())} {
+    add_node(0, kdtree_.samples_first(), kdtree_.samples_last(), n_features);
+}
+
+template <typename Iterator>
+KDTreeFiltering<Iterator>::Buffers::Buffers(const DatasetDescriptorType& dataset_descriptor,
+                                            const std::vector<DataType>& centroids)
+  : KDTreeFiltering<Iterator>::Buffers::Buffers(std::get<0>(dataset_descriptor),
+                                                std::get<1>(dataset_descriptor),
+                                                std::get<2>(dataset_descriptor),
+                                                centroids) {}
+
+/**
+ * @brief Appends a node of the kdtree and its subtree in depth first order with the statistics of their samples.
+ *
+ * @param kdnode_index
+ * @param samples_first first sample of the subtree of the kdnode
+ * @param samples_last
+ * @param n_features
+ * @return std::size_t the index of the node
+ */
+template <typename Iterator>
+std::size_t KDTreeFiltering<Iterator>::Buffers::add_node(std::size_t     kdnode_index,
+                                                         SamplesIterator samples_first,
+                                                         SamplesIterator samples_last,
+                                                         std::size_t     n_features) {
+    const std::size_t node_index = nodes_samples_.size();
+    const auto&       kdnode     = kdtree_.nodes()[kdnode_index];
+    // the median sample of a cut is in the middle of the samples of its subtree
+    const auto median_first =
+        samples_first + common::utils::get_n_samples(samples_first, samples_last, n_features) / 2 * n_features;
+
+    nodes_samples_.emplace_back(kdnode.is_leaf() ? samples_first : median_first,
+                                kdnode.is_leaf() ? samples_last : median_first + n_features);
+    nodes_children_.push_back({0, 0});
+    nodes_n_samples_.emplace_back(
+        common::utils::get_n_samples(nodes_samples_.back().first, nodes_samples_.back().second, n_features));
+    nodes_position_sums_.resize(nodes_position_sums_.size() + n_features);
+    nodes_squared_norms_sums_.emplace_back(0);
+    nodes_bounding_boxes_.resize(nodes_bounding_boxes_.size() + n_features,
+                                 {common::utils::infinity<DataType>(), -common::utils::infinity<DataType>()});
+
+    for (auto sample_first = nodes_samples_[node_index].first; sample_first != nodes_samples_[node_index].second;
+         sample_first += n_features) {
+        std::transform(sample_first,
+                       sample_first + n_features,
+                       nodes_position_sums_.begin() + node_index * n_features,
+                       nodes_position_sums_.begin() + node_index * n_features,
+                       std::plus<>());
+
+        nodes_squared_norms_sums_[node_index] +=
+            std::transform_reduce(sample_first, sample_first + n_features, sample_first, DataType{0});
+
+        for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+            auto& [min_feature, max_feature] = nodes_bounding_boxes_[node_index * n_features + feature_index];
+
+            min_feature = std::min(min_feature, *(sample_first + feature_index));
+            max_feature = std::max(max_feature, *(sample_first + feature_index));
+        }
+    }
+    if (!kdnode.is_leaf()) {
+        for (std::size_t child_index = 0; child_index < 2; ++child_index) {
+            const std::size_t child_node_index =
+                child_index ? add_node(kdnode.right_index_, median_first + n_features, samples_last, n_features)
+                            : add_node(kdnode_index + 1, samples_first, median_first, n_features);
+
+            nodes_children_[node_index][child_index] = child_node_index;
+            nodes_n_samples_[node_index] += nodes_n_samples_[child_node_index];
+
+            std::transform(nodes_position_sums_.begin() + node_index * n_features,
+                           nodes_position_sums_.begin() + node_index * n_features + n_features,
+                           nodes_position_sums_.begin() + child_node_index * n_features,
+                           nodes_position_sums_.begin() + node_index * n_features,
+                           std::plus<>());
+
+            nodes_squared_norms_sums_[node_index] += nodes_squared_norms_sums_[child_node_index];
+
+            for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+                auto& [min_feature, max_feature] = nodes_bounding_boxes_[node_index * n_features + feature_index];
+
+                const auto& [child_min_feature, child_max_feature] =
+                    nodes_bounding_boxes_[child_node_index * n_features + feature_index];
+
+                min_feature = std::min(min_feature, child_min_feature);
+                max_feature = std::max(max_feature, child_max_feature);
+            }
+        }
+    }
+    return node_index;
+}
+
+}  // namespace cpp_clustering
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/containers/Dataset.hpp"
+#include "cpp_clustering/containers/DatasetHandle.hpp"
 #include "cpp_clustering/heuristics/Heuristics.hpp"
+#include "cpp_clustering/kmeans/Elkan.hpp"
 #include "cpp_clustering/kmeans/Hamerly.hpp"
 #include "cpp_clustering/kmeans/KMeansPlusPlus.hpp"
 #include "cpp_clustering/kmeans/Lloyd.hpp"
+#include "cpp_clustering/kmeans/Yinyang.hpp"
 #include "cpp_clustering/math/random/Distributions.hpp"
 
 #include <algorithm>
@@ -15,6 +19,8 @@
 #include <limits>
 #include <memory>
 #include <numeric>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 namespace cpp_clustering {
@@ -50,12 +56,19 @@ class KMeans {
             return *this;
         }
 
+        // run the n_init candidates in lockstep and stop the ones that cant reach the lowest loss anymore
+        Options& racing(bool racing) {
+            racing_ = racing;
+            return *this;
+        }
+
         Options& operator=(const Options& options) {
             max_iter_       = options.max_iter_;
             early_stopping_ = options.early_stopping_;
             patience_       = options.patience_;
             tolerance_      = options.tolerance_;
             n_init_         = options.n_init_;
+            racing_         = options.racing_;
             return *this;
         }
 
@@ -64,6 +77,7 @@ class KMeans {
         std::size_t patience_       = 0;
         T           tolerance_      = 0;
         std::size_t n_init_         = 1;
+        bool        racing_         = false;
     };
 
   public:
@@ -79,6 +93,19 @@ class KMeans {
 
     KMeans<T>& set_options(const Options& options);
 
+    template <template <typename> class KMeansAlgorithm, typename SamplesIterator, typename Function>
+    std::vector<T> fit(const containers::DatasetHandle<SamplesIterator>& dataset,
+                       const Function&                                   centroids_initializer);
+
+    template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
+    std::vector<T> fit(const containers::DatasetHandle<SamplesIterator>& dataset);
+
+    template <template <typename> class KMeansAlgorithm, typename Function>
+    std::vector<T> fit(const containers::Dataset<T>& dataset, const Function& centroids_initializer);
+
+    template <template <typename> class KMeansAlgorithm>
+    std::vector<T> fit(const containers::Dataset<T>& dataset);
+
     template <template <typename> class KMeansAlgorithm, typename SamplesIterator, typename Function>
     std::vector<T> fit(const SamplesIterator& data_first,
                        const SamplesIterator& data_last,
@@ -95,12 +122,30 @@ class KMeans {
     template <typename SamplesIterator>
     std::vector<T> fit(const SamplesIterator& data_first, const SamplesIterator& data_last);
 
+    template <typename SamplesIterator>
+    std::vector<T> fit(const containers::DatasetHandle<SamplesIterator>& dataset);
+
+    std::vector<T> fit(const containers::Dataset<T>& dataset);
+
+    template <typename SamplesIterator, typename Function>
+    std::vector<T> partial_fit(const SamplesIterator& batch_first,
+                               const SamplesIterator& batch_last,
+                               const Function&        centroids_initializer);
+
+    template <typename SamplesIterator>
+    std::vector<T> partial_fit(const SamplesIterator& batch_first, const SamplesIterator& batch_last);
+
     template <typename SamplesIterator>
     std::vector<T> forward(const SamplesIterator& data_first, const SamplesIterator& data_last) const;
 
     template <typename SamplesIterator>
     std::vector<std::size_t> predict(const SamplesIterator& data_first, const SamplesIterator& data_last) const;
 
+    template <typename SamplesIterator>
+    std::vector<std::size_t> predict(const containers::DatasetHandle<SamplesIterator>& dataset) const;
+
+    std::vector<std::size_t> predict(const containers::Dataset<T>& dataset) const;
+
   private:
     void prune_unassigned_centroids();  // NOT IMPLEMENTED
 
@@ -110,6 +155,9 @@ class KMeans {
     std::size_t n_features_;
     // n_centroids_ x n_features_ vectorized matrix (n_centroids_ could vary)
     std::vector<T> centroids_;
+    // n_centroids_ vector of the number of samples each centroid has been updated with by partial_fit. The learning
+    // rate of a centroid is the inverse of its count
+    std::vector<std::size_t> centroids_counts_;
 
     Options options_;
 };
@@ -147,11 +195,28 @@ KMeans<T>& KMeans<T>::set_options(const Options& options) {
     return *this;
 }
 
+/**
+ * @brief Fits the centroids on a dataset handle. The initializer is called with the handle if it accepts
+ * (dataset, n_centroids) so that the values cached in the handle (e.g. the squared norms of the samples) are shared by
+ * all the n_init candidates. Otherwise it is called with (data_first, data_last, n_centroids, n_features).
+ *
+ * @tparam KMeansAlgorithm
+ * @tparam SamplesIterator
+ * @tparam Function
+ * @param dataset
+ * @param centroids_initializer
+ * @return std::vector<T> the centroids with the lowest loss
+ */
 template <typename T>
 template <template <typename> class KMeansAlgorithm, typename SamplesIterator, typename Function>
-std::vector<T> KMeans<T>::fit(const SamplesIterator& data_first,
-                              const SamplesIterator& data_last,
-                              const Function&        centroids_initializer) {
+std::vector<T> KMeans<T>::fit(const containers::DatasetHandle<SamplesIterator>& dataset,
+                              const Function&                                   centroids_initializer) {
+    if (dataset.n_features() != n_features_) {
+        throw std::invalid_argument("The dataset should have the same number of features as the KMeans instance.");
+    }
+    const auto& data_first = dataset.samples_first();
+    const auto& data_last  = dataset.samples_last();
+
     // contains the centroids for each tries which number is defined by options_.n_init_ if centroids_ werent already
     // assigned
     auto centroids_candidates = std::vector<std::vector<T>>();
@@ -159,23 +224,50 @@ std::vector<T> KMeans<T>::fit(const SamplesIterator& data_first,
     if (centroids_.empty()) {
         for (std::size_t k = 0; k < options_.n_init_; ++k) {
             // default initialization of the centroids if not initialized
-            centroids_candidates.emplace_back(centroids_initializer(data_first, data_last, n_centroids_, n_features_));
+            if constexpr (std::is_invocable_v<const Function&,
+                                              const containers::DatasetHandle<SamplesIterator>&,
+                                              std::size_t>) {
+                centroids_candidates.emplace_back(centroids_initializer(dataset, n_centroids_));
+            } else {
+                centroids_candidates.emplace_back(
+                    centroids_initializer(data_first, data_last, n_centroids_, n_features_));
+            }
         }
     } else {
         // if the centroids were already assigned, copy them once
         centroids_candidates.emplace_back(centroids_);
     }
+    if (options_.racing_ && centroids_candidates.size() > 1) {
+        auto kmeans_algorithms = std::vector<std::unique_ptr<KMeansAlgorithm<SamplesIterator>>>(
+            centroids_candidates.size());
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for
+#endif
+        for (std::size_t k = 0; k < centroids_candidates.size(); ++k) {
+            kmeans_algorithms[k] = std::make_unique<KMeansAlgorithm<SamplesIterator>>(
+                std::make_tuple(data_first, data_last, n_features_), centroids_candidates[k]);
+        }
+        const auto candidates_losses = common::utils::race_candidates(kmeans_algorithms,
+                                                                      centroids_candidates,
+                                                                      options_.max_iter_,
+                                                                      options_.early_stopping_,
+                                                                      options_.patience_,
+                                                                      options_.tolerance_);
+
+        const std::size_t min_loss_index = common::utils::argmin(candidates_losses.begin(), candidates_losses.end());
+
+        centroids_ = centroids_candidates[min_loss_index];
+
+        return centroids_;
+    }
     // make the losses buffer for each centroids candidates
     auto candidates_losses = std::vector<T>(centroids_candidates.size());
 
-    // This creates a n_candidates vector of n_centroids vectors. The elements of each vector should be initialized to
-    // infinity, but since common::utils::are_containers_equal checks container sizes, it's not necessary to do so. We
-    // could use only one candidate with a single thread but we make it thread safe this way we dont necessarily need to
-    // initialize with vectors of infinities
-    auto centroids_candidates_prev = std::vector<std::vector<T>>(centroids_candidates.size());
-
+    // the candidates are processed in parallel only if there are several of them. Otherwise the region stays inactive
+    // so that the KMeansAlgorithm can use all the threads within its own step
 #if defined(_OPENMP) && THREADS_ENABLED == true
-#pragma omp parallel for
+#pragma omp parallel for if (centroids_candidates.size() > 1)
 #endif
     for (std::size_t k = 0; k < centroids_candidates.size(); ++k) {
 #if defined(VERBOSE) && VERBOSE == true
@@ -191,22 +283,22 @@ std::vector<T> KMeans<T>::fit(const SamplesIterator& data_first,
             // loss before step to also get the initial loss
             printf("%.3f, ", kmeans_algorithm.total_deviation());
 #endif
+            // the centroids are owned by the algorithm and only copied once the candidate stops
+            const auto& centroids = kmeans_algorithm.step();
 
-            centroids_candidates[k] = kmeans_algorithm.step();
+            bool has_converged = false;
 
-            if (options_.early_stopping_ &&
-                common::utils::are_containers_equal(
-                    centroids_candidates[k], centroids_candidates_prev[k], options_.tolerance_)) {
-                if (patience_iter == options_.patience_) {
-                    break;
-                }
+            if (options_.early_stopping_ && kmeans_algorithm.max_centroid_shift() <= options_.tolerance_) {
+                has_converged = patience_iter == options_.patience_;
                 ++patience_iter;
 
             } else {
                 patience_iter = 0;
             }
-            // save the results from the current step
-            centroids_candidates_prev[k] = centroids_candidates[k];
+            if (has_converged || iter + 1 == options_.max_iter_) {
+                std::copy(centroids.begin(), centroids.end(), centroids_candidates[k].begin());
+                break;
+            }
         }
 #if defined(VERBOSE) && VERBOSE == true
         // final loss
@@ -223,6 +315,53 @@ std::vector<T> KMeans<T>::fit(const SamplesIterator& data_first,
     return centroids_;
 }
 
+template <typename T>
+template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
+std::vector<T> KMeans<T>::fit(const containers::DatasetHandle<SamplesIterator>& dataset) {
+    return fit<KMeansAlgorithm>(dataset, cpp_clustering::kmeansplusplus::make_centroids<SamplesIterator>);
+}
+
+/**
+ * @brief Fits the centroids on the aligned and padded rows of a Dataset. The padding features are null for all the
+ * samples and thus for the centroids, so the algorithms run on the padded rows without any change and the padding is
+ * removed from the centroids afterwards. The initializer is called with a view or iterators of the padded rows.
+ *
+ * @tparam KMeansAlgorithm
+ * @tparam Function
+ * @param dataset
+ * @param centroids_initializer
+ * @return std::vector<T> the centroids with the lowest loss
+ */
+template <typename T>
+template <template <typename> class KMeansAlgorithm, typename Function>
+std::vector<T> KMeans<T>::fit(const containers::Dataset<T>& dataset, const Function& centroids_initializer) {
+    if (dataset.n_features() != n_features_) {
+        throw std::invalid_argument("The dataset should have the same number of features as the KMeans instance.");
+    }
+    auto padded_kmeans = KMeans<T>(n_centroids_, dataset.padded_n_features(), dataset.pad_rows(centroids_), options_);
+
+    centroids_ =
+        dataset.remove_padding(padded_kmeans.template fit<KMeansAlgorithm>(dataset.view(), centroids_initializer));
+
+    return centroids_;
+}
+
+template <typename T>
+template <template <typename> class KMeansAlgorithm>
+std::vector<T> KMeans<T>::fit(const containers::Dataset<T>& dataset) {
+    return fit<KMeansAlgorithm>(
+        dataset, cpp_clustering::kmeansplusplus::make_centroids<typename containers::Dataset<T>::ConstIterator>);
+}
+
+template <typename T>
+template <template <typename> class KMeansAlgorithm, typename SamplesIterator, typename Function>
+std::vector<T> KMeans<T>::fit(const SamplesIterator& data_first,
+                              const SamplesIterator& data_last,
+                              const Function&        centroids_initializer) {
+    return fit<KMeansAlgorithm>(containers::DatasetHandle<SamplesIterator>(data_first, data_last, n_features_),
+                                centroids_initializer);
+}
+
 template <typename T>
 template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
 std::vector<T> KMeans<T>::fit(const SamplesIterator& data_first, const SamplesIterator& data_last) {
@@ -250,6 +389,72 @@ std::vector<T> KMeans<T>::fit(const SamplesIterator& data_first, const SamplesIt
         data_first, data_last, cpp_clustering::kmeansplusplus::make_centroids<SamplesIterator>);
 }
 
+template <typename T>
+template <typename SamplesIterator>
+std::vector<T> KMeans<T>::fit(const containers::DatasetHandle<SamplesIterator>& dataset) {
+    return fit<cpp_clustering::Hamerly>(dataset);
+}
+
+template <typename T>
+std::vector<T> KMeans<T>::fit(const containers::Dataset<T>& dataset) {
+    return fit<cpp_clustering::Hamerly>(dataset);
+}
+
+/**
+ * @brief Mini-batch k-means update (https://www.eecs.tufts.edu/~dsculley/papers/fastkmeans.pdf). The samples of the
+ * batch are first assigned to their nearest centroid, then each centroid moves towards its samples one at a time with a
+ * learning rate that decreases with the number of samples it has seen so far. Can be called repeatedly on a stream of
+ * batches that wouldn't fit in memory at once.
+ *
+ * @tparam SamplesIterator
+ * @tparam Function
+ * @param batch_first
+ * @param batch_last
+ * @param centroids_initializer called on the first batch if the centroids were not already assigned
+ * @return std::vector<T> the updated centroids
+ */
+template <typename T>
+template <typename SamplesIterator, typename Function>
+std::vector<T> KMeans<T>::partial_fit(const SamplesIterator& batch_first,
+                                      const SamplesIterator& batch_last,
+                                      const Function&        centroids_initializer) {
+    if (centroids_.empty()) {
+        if (common::utils::get_n_samples(batch_first, batch_last, n_features_) < n_centroids_) {
+            throw std::invalid_argument("The first batch should contain at least n_centroids samples.");
+        }
+        centroids_ = centroids_initializer(batch_first, batch_last, n_centroids_, n_features_);
+    }
+    if (centroids_counts_.size() != n_centroids_) {
+        centroids_counts_ = std::vector<std::size_t>(n_centroids_);
+    }
+    // cache the assignments of the batch w.r.t. the centroids before the update
+    const auto batch_to_nearest_centroid_indices =
+        kmeans::utils::samples_to_nearest_centroid_indices(batch_first, batch_last, n_features_, centroids_);
+
+    for (std::size_t sample_index = 0; sample_index < batch_to_nearest_centroid_indices.size(); ++sample_index) {
+        const auto centroid_index = batch_to_nearest_centroid_indices[sample_index];
+        // per centroid learning rate
+        const auto learning_rate = static_cast<T>(1) / static_cast<T>(++centroids_counts_[centroid_index]);
+
+        // centroid <- (1 - learning_rate) * centroid + learning_rate * sample
+        std::transform(centroids_.begin() + centroid_index * n_features_,
+                       centroids_.begin() + centroid_index * n_features_ + n_features_,
+                       batch_first + sample_index * n_features_,
+                       centroids_.begin() + centroid_index * n_features_,
+                       [learning_rate](const auto& centroid_feature, const auto& sample_feature) {
+                           return centroid_feature + learning_rate * (sample_feature - centroid_feature);
+                       });
+    }
+    return centroids_;
+}
+
+template <typename T>
+template <typename SamplesIterator>
+std::vector<T> KMeans<T>::partial_fit(const SamplesIterator& batch_first, const SamplesIterator& batch_last) {
+    // seed the centroids with kmeans++ on the first batch
+    return partial_fit(batch_first, batch_last, cpp_clustering::kmeansplusplus::make_centroids<SamplesIterator>);
+}
+
 template <typename T>
 template <typename SamplesIterator>
 std::vector<T> KMeans<T>::forward(const SamplesIterator& data_first, const SamplesIterator& data_last) const {
@@ -262,4 +467,22 @@ std::vector<std::size_t> KMeans<T>::predict(const SamplesIterator& data_first, c
     return kmeans::utils::samples_to_nearest_centroid_indices(data_first, data_last, n_features_, centroids_);
 }
 
+template <typename T>
+template <typename SamplesIterator>
+std::vector<std::size_t> KMeans<T>::predict(const containers::DatasetHandle<SamplesIterator>& dataset) const {
+    if (dataset.n_features() != n_features_) {
+        throw std::invalid_argument("The dataset should have the same number of features as the KMeans instance.");
+    }
+    return predict(dataset.samples_first(), dataset.samples_last());
+}
+
+template <typename T>
+std::vector<std::size_t> KMeans<T>::predict(const containers::Dataset<T>& dataset) const {
+    if (dataset.n_features() != n_features_) {
+        throw std::invalid_argument("The dataset should have the same number of features as the KMeans instance.");
+    }
+    return kmeans::utils::samples_to_nearest_centroid_indices(
+        dataset.begin(), dataset.end(), dataset.padded_n_features(), dataset.pad_rows(centroids_));
+}
+
 }  // namespace cpp_clustering
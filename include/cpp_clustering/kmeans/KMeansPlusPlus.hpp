@@ -1,6 +1,7 @@
 #pragma once
 
 #include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/containers/DatasetHandle.hpp"
 #include "cpp_clustering/heuristics/Heuristics.hpp"
 #include "cpp_clustering/kmeans/KMeansUtils.hpp"
 #include "cpp_clustering/math/random/Distributions.hpp"
@@ -17,17 +18,82 @@
 #include <string>
 #include <vector>
 
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
 namespace cpp_clustering::kmeansplusplus {
 
+/**
+ * @brief Draws n_indices indices (with replacement) with a probability proportional to their weight with a single
+ * linear scan over the sorted random thresholds. Falls back to uniform draws if all the weights are null.
+ *
+ * @tparam FloatType
+ * @param weights
+ * @param weights_sum the sum of the weights
+ * @param n_indices
+ * @return std::vector<std::size_t>
+ */
+template <typename FloatType>
+std::vector<std::size_t> weighted_random_indices(const std::vector<FloatType>& weights,
+                                                 const FloatType&              weights_sum,
+                                                 std::size_t                   n_indices) {
+    auto random_indices = std::vector<std::size_t>(n_indices);
+
+    if (!(weights_sum > 0)) {
+        auto index_select = math::random::uniform_distribution<std::size_t>(0, weights.size() - 1);
+
+        std::generate(random_indices.begin(), random_indices.end(), [&index_select]() { return index_select(); });
+        return random_indices;
+    }
+    auto uniform = math::random::uniform_distribution<FloatType>(0, weights_sum);
+
+    auto random_weights = std::vector<FloatType>(n_indices);
+    std::generate(random_weights.begin(), random_weights.end(), [&uniform]() { return uniform(); });
+    std::sort(random_weights.begin(), random_weights.end());
+
+    auto        cumulative_weight = static_cast<FloatType>(0);
+    std::size_t last_non_null     = 0;
+    std::size_t n_drawn           = 0;
+
+    for (std::size_t index = 0; index < weights.size() && n_drawn < n_indices; ++index) {
+        if (weights[index] > 0) {
+            cumulative_weight += weights[index];
+            last_non_null = index;
+
+            while (n_drawn < n_indices && random_weights[n_drawn] < cumulative_weight) {
+                random_indices[n_drawn++] = index;
+            }
+        }
+    }
+    // rounding errors in weights_sum can leave the last random weights slightly above the cumulative sum
+    std::fill(random_indices.begin() + n_drawn, random_indices.end(), last_non_null);
+
+    return random_indices;
+}
+
+/**
+ * @brief Draws an index with a probability proportional to its weight with a single linear scan. Cheaper than building
+ * an alias table when the weights change after each draw. Falls back to an uniform draw if all the weights are null.
+ *
+ * @tparam FloatType
+ * @param weights
+ * @param weights_sum the sum of the weights
+ * @return std::size_t
+ */
+template <typename FloatType>
+std::size_t weighted_random_index(const std::vector<FloatType>& weights, const FloatType& weights_sum) {
+    return weighted_random_indices(weights, weights_sum, 1).front();
+}
+
 /**
  * @brief Initializes the first centroid randomly and then weights subsequent centroids based on the distance to all
  * previous centroids, has the advantage of being more likely to find a better overall solution. By ensuring that each
  * subsequent centroid is well-separated from all previous centroids, this version of kmeans++ can help to avoid local
  * minima and improve the quality of the final clustering result.
  *
- * However, the disadvantage of this approach is that it can be computationally expensive, especially for larger
- * datasets or higher-dimensional data. Since each new centroid must be evaluated with respect to all previous
- * centroids, the algorithm may slow down significantly as the number of clusters increases or the dataset size grows.
+ * The distance from each sample to its nearest centroid is kept from one centroid to the next and only updated against
+ * the newly added centroid, so the whole initialization costs O(n_samples * n_centroids * n_features).
  *
  * @tparam IteratorFloat
  * @param data_first
@@ -44,16 +110,29 @@ std::vector<typename IteratorFloat::value_type> make_centroids(const IteratorFlo
     static_assert(std::is_floating_point<typename IteratorFloat::value_type>::value,
                   "Data should be a floating point type.");
 
+    using DataType = typename IteratorFloat::value_type;
+
     auto centroids = common::utils::select_random_sample(data_first, data_last, n_features);
 
+    // the distances from each sample to its closest centroid
+    auto nearest_centroid_distances =
+        kmeans::utils::samples_to_nearest_centroid_distances(data_first, data_last, n_features, centroids);
+
+    auto nearest_centroid_distances_sum = std::reduce(
+        nearest_centroid_distances.begin(), nearest_centroid_distances.end(), static_cast<DataType>(0), std::plus<>());
+
     for (std::size_t centroid_index = 1; centroid_index < n_centroids; ++centroid_index) {
-        // recompute the distances from each sample to its closest centroid
-        auto nearest_centroid_distances =
-            kmeans::utils::samples_to_nearest_centroid_distances(data_first, data_last, n_features, centroids);
+        if (centroid_index > 1) {
+            // only the last added centroid can be closer than the previous nearest centroids
+            nearest_centroid_distances_sum =
+                kmeans::utils::update_samples_to_nearest_centroid_distances(data_first,
+                                                                            data_last,
+                                                                            n_features,
+                                                                            centroids.cend() - n_features,
+                                                                            nearest_centroid_distances.begin());
+        }
         // use these distances as weighted probabilities
-        auto alias_method = math::random::VosesAliasMethod(nearest_centroid_distances);
-
-        const auto random_index = alias_method();
+        const auto random_index = weighted_random_index(nearest_centroid_distances, nearest_centroid_distances_sum);
 
         centroids.insert(centroids.end(),
                          data_first + random_index * n_features,
@@ -62,6 +141,397 @@ std::vector<typename IteratorFloat::value_type> make_centroids(const IteratorFlo
     return centroids;
 }
 
+/**
+ * @brief Greedy kmeans++ (as in https://theory.stanford.edu/~sergei/papers/kMeansPP-soda.pdf and scikit-learn). Each
+ * step draws 2 + log(n_centroids) candidates instead of one and keeps the candidate that reduces the most the sum of
+ * the distances from each sample to its nearest centroid. The potentials of all the candidates are computed in a
+ * single parallel pass over the samples. The squared norms of the samples are taken from the dataset handle so that
+ * they are computed once for all the steps and all the calls made with the same handle.
+ *
+ * @tparam IteratorFloat
+ * @param dataset
+ * @param n_centroids
+ * @return std::vector<typename IteratorFloat::value_type>
+ */
+template <typename IteratorFloat>
+std::vector<typename IteratorFloat::value_type> make_centroids_greedy(
+    const containers::DatasetHandle<IteratorFloat>& dataset,
+    std::size_t                                     n_centroids) {
+    static_assert(std::is_floating_point<typename IteratorFloat::value_type>::value,
+                  "Data should be a floating point type.");
+
+    using DataType = typename IteratorFloat::value_type;
+
+    const auto [data_first, data_last, n_features] = dataset.dataset_descriptor();
+
+    const std::size_t n_samples     = dataset.n_samples();
+    const auto&       squared_norms = dataset.squared_norms();
+    // the number of local trials recommended by the authors
+    const std::size_t n_local_trials = 2 + static_cast<std::size_t>(std::log(static_cast<double>(n_centroids)));
+
+    auto centroids = common::utils::select_random_sample(data_first, data_last, n_features);
+
+    // the distances from each sample to its closest centroid
+    auto nearest_centroid_distances =
+        kmeans::utils::samples_to_nearest_centroid_distances(data_first, data_last, n_features, centroids);
+
+    auto nearest_centroid_distances_sum = std::reduce(
+        nearest_centroid_distances.begin(), nearest_centroid_distances.end(), static_cast<DataType>(0), std::plus<>());
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+    auto threads_candidates_potentials = std::vector<std::vector<DataType>>(std::max(1, omp_get_max_threads()));
+#else
+    auto threads_candidates_potentials = std::vector<std::vector<DataType>>(1);
+#endif
+
+    auto candidates_squared_norms = std::vector<DataType>(n_local_trials);
+
+    for (std::size_t centroid_index = 1; centroid_index < n_centroids; ++centroid_index) {
+        const auto candidates_indices =
+            weighted_random_indices(nearest_centroid_distances, nearest_centroid_distances_sum, n_local_trials);
+
+        for (auto& thread_candidates_potentials : threads_candidates_potentials) {
+            thread_candidates_potentials.assign(n_local_trials, static_cast<DataType>(0));
+        }
+        for (std::size_t trial_index = 0; trial_index < n_local_trials; ++trial_index) {
+            candidates_squared_norms[trial_index] = squared_norms[candidates_indices[trial_index]];
+        }
+        // the sum of the nearest centroid distances if each candidate was added to the centroids
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel
+#endif
+        {
+#if defined(_OPENMP) && THREADS_ENABLED == true
+            auto& candidates_potentials = threads_candidates_potentials[omp_get_thread_num()];
+#else
+            auto& candidates_potentials = threads_candidates_potentials[0];
+#endif
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp for schedule(static)
+#endif
+            for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+                const auto sample_first = data_first + sample_index * n_features;
+
+                // ||x - c||^2 = ||x||^2 - 2 x.c + ||c||^2 so that 4 candidates share the same loads of the sample
+                const auto sample_squared_norm = squared_norms[sample_index];
+
+                const auto nearest_centroid_distance = nearest_centroid_distances[sample_index];
+
+                auto add_candidate_potential = [&](std::size_t trial_index, const DataType& dot_product) {
+                    const auto squared_distance =
+                        sample_squared_norm - 2 * dot_product + candidates_squared_norms[trial_index];
+
+                    // the sqrt is only needed when the candidate is closer than the current nearest centroid
+                    candidates_potentials[trial_index] +=
+                        (squared_distance < nearest_centroid_distance * nearest_centroid_distance)
+                            ? std::sqrt(std::max(squared_distance, static_cast<DataType>(0)))
+                            : nearest_centroid_distance;
+                };
+                std::size_t trial_index = 0;
+
+                for (; trial_index + 4 <= n_local_trials; trial_index += 4) {
+                    const auto dot_products =
+                        kmeans::utils::dot_products_4(sample_first,
+                                                      n_features,
+                                                      data_first + candidates_indices[trial_index] * n_features,
+                                                      data_first + candidates_indices[trial_index + 1] * n_features,
+                                                      data_first + candidates_indices[trial_index + 2] * n_features,
+                                                      data_first + candidates_indices[trial_index + 3] * n_features);
+
+                    for (std::size_t offset = 0; offset < 4; ++offset) {
+                        add_candidate_potential(trial_index + offset, dot_products[offset]);
+                    }
+                }
+                for (; trial_index < n_local_trials; ++trial_index) {
+                    add_candidate_potential(
+                        trial_index,
+                        std::transform_reduce(sample_first,
+                                              sample_first + n_features,
+                                              data_first + candidates_indices[trial_index] * n_features,
+                                              static_cast<DataType>(0)));
+                }
+            }
+        }
+        auto candidates_potentials = std::vector<DataType>(n_local_trials);
+
+        for (const auto& thread_candidates_potentials : threads_candidates_potentials) {
+            std::transform(candidates_potentials.begin(),
+                           candidates_potentials.end(),
+                           thread_candidates_potentials.begin(),
+                           candidates_potentials.begin(),
+                           std::plus<>());
+        }
+        // keep the candidate with the lowest potential
+        const auto best_candidate_index = candidates_indices[std::distance(
+            candidates_potentials.begin(),
+            std::min_element(candidates_potentials.begin(), candidates_potentials.end()))];
+
+        centroids.insert(centroids.end(),
+                         data_first + best_candidate_index * n_features,
+                         data_first + best_candidate_index * n_features + n_features);
+
+        if (centroid_index + 1 < n_centroids) {
+            nearest_centroid_distances_sum =
+                kmeans::utils::update_samples_to_nearest_centroid_distances(data_first,
+                                                                            data_last,
+                                                                            n_features,
+                                                                            centroids.cend() - n_features,
+                                                                            nearest_centroid_distances.begin());
+        }
+    }
+    return centroids;
+}
+
+template <typename IteratorFloat>
+std::vector<typename IteratorFloat::value_type> make_centroids_greedy(const IteratorFloat& data_first,
+                                                                      const IteratorFloat& data_last,
+                                                                      std::size_t          n_centroids,
+                                                                      std::size_t          n_features) {
+    return make_centroids_greedy(containers::DatasetHandle<IteratorFloat>(data_first, data_last, n_features),
+                                 n_centroids);
+}
+
+/**
+ * @brief Scalable kmeans++ (kmeans||) https://arxiv.org/pdf/1203.6402.pdf. Instead of picking the centroids one at a
+ * time, each round samples about 2 * n_centroids candidates independently and in parallel with a probability
+ * proportional to their distance to the current candidates. After a few rounds, each candidate is weighted by the
+ * number of samples it is the nearest to and the final centroids are chosen among the candidates with a weighted
+ * kmeans++. The weights are the nearest candidate distances, as in make_centroids.
+ *
+ * @tparam IteratorFloat
+ * @param data_first
+ * @param data_last
+ * @param n_centroids
+ * @param n_features
+ * @return std::vector<typename IteratorFloat::value_type>
+ */
+template <typename IteratorFloat>
+std::vector<typename IteratorFloat::value_type> make_centroids_parallel(const IteratorFloat& data_first,
+                                                                        const IteratorFloat& data_last,
+                                                                        std::size_t          n_centroids,
+                                                                        std::size_t          n_features) {
+    static_assert(std::is_floating_point<typename IteratorFloat::value_type>::value,
+                  "Data should be a floating point type.");
+
+    using DataType = typename IteratorFloat::value_type;
+
+    // the values recommended by the authors
+    const std::size_t n_rounds            = 5;
+    const auto        oversampling_factor = static_cast<DataType>(2 * n_centroids);
+
+    const std::size_t n_samples = common::utils::get_n_samples(data_first, data_last, n_features);
+
+    auto candidates = common::utils::select_random_sample(data_first, data_last, n_features);
+
+    // the distances from each sample to its closest candidate
+    auto nearest_candidate_distances =
+        kmeans::utils::samples_to_nearest_centroid_distances(data_first, data_last, n_features, candidates);
+
+    auto nearest_candidate_distances_sum = std::reduce(nearest_candidate_distances.begin(),
+                                                       nearest_candidate_distances.end(),
+                                                       static_cast<DataType>(0),
+                                                       std::plus<>());
+
+    for (std::size_t round = 0; round < n_rounds && nearest_candidate_distances_sum > 0; ++round) {
+#if defined(_OPENMP) && THREADS_ENABLED == true
+        auto threads_new_candidates = std::vector<std::vector<DataType>>(std::max(1, omp_get_max_threads()));
+#else
+        auto threads_new_candidates = std::vector<std::vector<DataType>>(1);
+#endif
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel
+#endif
+        {
+#if defined(_OPENMP) && THREADS_ENABLED == true
+            auto& thread_new_candidates = threads_new_candidates[omp_get_thread_num()];
+#else
+            auto& thread_new_candidates = threads_new_candidates[0];
+#endif
+            auto uniform = math::random::uniform_distribution<DataType>(0, 1);
+
+            // each sample is selected independently with probability l * d(x) / sum(d(x))
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp for schedule(static)
+#endif
+            for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+                if (uniform() * nearest_candidate_distances_sum <
+                    oversampling_factor * nearest_candidate_distances[sample_index]) {
+                    thread_new_candidates.insert(thread_new_candidates.end(),
+                                                 data_first + sample_index * n_features,
+                                                 data_first + sample_index * n_features + n_features);
+                }
+            }
+        }
+        // merge the candidates of each thread in increasing sample order
+        auto new_candidates = std::vector<DataType>();
+
+        for (const auto& thread_new_candidates : threads_new_candidates) {
+            new_candidates.insert(new_candidates.end(), thread_new_candidates.begin(), thread_new_candidates.end());
+        }
+        if (new_candidates.empty()) {
+            continue;
+        }
+        // only the new candidates can be closer than the previous nearest candidates
+        const auto new_candidates_distances =
+            kmeans::utils::samples_to_nearest_centroid_distances(data_first, data_last, n_features, new_candidates);
+
+        std::transform(nearest_candidate_distances.begin(),
+                       nearest_candidate_distances.end(),
+                       new_candidates_distances.begin(),
+                       nearest_candidate_distances.begin(),
+                       [](const auto& lhs, const auto& rhs) { return std::min(lhs, rhs); });
+
+        nearest_candidate_distances_sum = std::reduce(nearest_candidate_distances.begin(),
+                                                      nearest_candidate_distances.end(),
+                                                      static_cast<DataType>(0),
+                                                      std::plus<>());
+
+        candidates.insert(candidates.end(), new_candidates.begin(), new_candidates.end());
+    }
+    const std::size_t n_candidates = candidates.size() / n_features;
+
+    if (n_candidates <= n_centroids) {
+        // not enough candidates to choose from (e.g. with many duplicated samples)
+        return make_centroids(data_first, data_last, n_centroids, n_features);
+    }
+    // weight each candidate by the number of samples it is the nearest to
+    const auto samples_to_nearest_candidate_indices =
+        kmeans::utils::samples_to_nearest_centroid_indices(data_first, data_last, n_features, candidates);
+
+    const auto candidates_weights = kmeans::utils::compute_cluster_sizes(
+        samples_to_nearest_candidate_indices.begin(), samples_to_nearest_candidate_indices.end(), n_candidates);
+
+    // weighted kmeans++ over the candidates
+    auto candidates_probabilities = std::vector<DataType>(candidates_weights.begin(), candidates_weights.end());
+
+    auto first_index = weighted_random_index(
+        candidates_probabilities,
+        std::reduce(
+            candidates_probabilities.begin(), candidates_probabilities.end(), static_cast<DataType>(0), std::plus<>()));
+
+    auto centroids = std::vector<DataType>(candidates.begin() + first_index * n_features,
+                                           candidates.begin() + first_index * n_features + n_features);
+
+    auto nearest_centroid_distances = kmeans::utils::samples_to_nearest_centroid_distances(
+        candidates.cbegin(), candidates.cend(), n_features, centroids);
+
+    for (std::size_t centroid_index = 1; centroid_index < n_centroids; ++centroid_index) {
+        if (centroid_index > 1) {
+            kmeans::utils::update_samples_to_nearest_centroid_distances(candidates.cbegin(),
+                                                                        candidates.cend(),
+                                                                        n_features,
+                                                                        centroids.cend() - n_features,
+                                                                        nearest_centroid_distances.begin());
+        }
+        std::transform(candidates_weights.begin(),
+                       candidates_weights.end(),
+                       nearest_centroid_distances.begin(),
+                       candidates_probabilities.begin(),
+                       [](const auto& weight, const auto& distance) { return weight * distance; });
+
+        const auto random_index = weighted_random_index(
+            candidates_probabilities,
+            std::reduce(candidates_probabilities.begin(),
+                        candidates_probabilities.end(),
+                        static_cast<DataType>(0),
+                        std::plus<>()));
+
+        centroids.insert(centroids.end(),
+                         candidates.begin() + random_index * n_features,
+                         candidates.begin() + random_index * n_features + n_features);
+    }
+    return centroids;
+}
+
+/**
+ * @brief Assumption-free kmeans++ approximation with Markov chains (AFK-MC2)
+ * https://papers.nips.cc/paper_files/paper/2016/file/d67d8ab4f4c10bf22aa353e27879133c-Paper.pdf. A single pass over
+ * the data builds the proposal distribution q(x) = 1/2 * d(x, c_1) / sum(d(x, c_1)) + 1/2 * 1 / n_samples with an
+ * alias table. Each subsequent centroid is the last state of a Markov chain of proposals drawn in O(1), accepted
+ * w.r.t. their distance to the current centroids. After the first pass, the cost doesnt depend on n_samples. The
+ * target distribution uses the nearest centroid distances, as in make_centroids.
+ *
+ * @tparam IteratorFloat
+ * @param data_first
+ * @param data_last
+ * @param n_centroids
+ * @param n_features
+ * @return std::vector<typename IteratorFloat::value_type>
+ */
+template <typename IteratorFloat>
+std::vector<typename IteratorFloat::value_type> afkmc2(const IteratorFloat& data_first,
+                                                       const IteratorFloat& data_last,
+                                                       std::size_t          n_centroids,
+                                                       std::size_t          n_features) {
+    static_assert(std::is_floating_point<typename IteratorFloat::value_type>::value,
+                  "Data should be a floating point type.");
+
+    using DataType = typename IteratorFloat::value_type;
+
+    // the markov chains length recommended by the authors
+    const std::size_t chain_length = 200;
+
+    const std::size_t n_samples = common::utils::get_n_samples(data_first, data_last, n_features);
+
+    auto centroids = common::utils::select_random_sample(data_first, data_last, n_features);
+
+    // the single pass over the data to build the proposal distribution
+    auto proposal_probabilities =
+        kmeans::utils::samples_to_nearest_centroid_distances(data_first, data_last, n_features, centroids);
+
+    const auto distances_sum = std::reduce(
+        proposal_probabilities.begin(), proposal_probabilities.end(), static_cast<DataType>(0), std::plus<>());
+
+    std::transform(proposal_probabilities.begin(),
+                   proposal_probabilities.end(),
+                   proposal_probabilities.begin(),
+                   [distances_sum, n_samples](const auto& distance) {
+                       return (distances_sum > 0 ? distance / (2 * distances_sum) : static_cast<DataType>(0)) +
+                              static_cast<DataType>(1) / (2 * static_cast<DataType>(n_samples));
+                   });
+
+    auto proposal_alias_method = math::random::VosesAliasMethod(proposal_probabilities);
+    auto uniform               = math::random::uniform_distribution<DataType>(0, 1);
+
+    // distance from a sample to its nearest centroid
+    auto nearest_centroid_distance = [&centroids, &data_first, n_features](std::size_t sample_index) {
+        auto min_distance = common::utils::infinity<DataType>();
+
+        for (std::size_t centroid_index = 0; centroid_index < centroids.size() / n_features; ++centroid_index) {
+            min_distance =
+                std::min(min_distance,
+                         cpp_clustering::heuristic::heuristic(data_first + sample_index * n_features,
+                                                              data_first + sample_index * n_features + n_features,
+                                                              centroids.begin() + centroid_index * n_features));
+        }
+        return min_distance;
+    };
+
+    for (std::size_t centroid_index = 1; centroid_index < n_centroids; ++centroid_index) {
+        auto sample_index    = static_cast<std::size_t>(proposal_alias_method());
+        auto sample_distance = nearest_centroid_distance(sample_index);
+
+        for (std::size_t chain_index = 1; chain_index < chain_length; ++chain_index) {
+            const auto candidate_index    = static_cast<std::size_t>(proposal_alias_method());
+            const auto candidate_distance = nearest_centroid_distance(candidate_index);
+
+            // metropolis-hastings acceptance: (d(y) / q(y)) / (d(x) / q(x)) > u
+            if (sample_distance * proposal_probabilities[candidate_index] == 0 ||
+                candidate_distance * proposal_probabilities[sample_index] >
+                    uniform() * sample_distance * proposal_probabilities[candidate_index]) {
+                sample_index    = candidate_index;
+                sample_distance = candidate_distance;
+            }
+        }
+        centroids.insert(centroids.end(),
+                         data_first + sample_index * n_features,
+                         data_first + sample_index * n_features + n_features);
+    }
+    return centroids;
+}
+
 /**
  * @brief The second version of kmeans++, which weights subsequent centroids based only on the distance to the previous
  * centroid, can be faster since it only requires evaluating the distance to a single previous centroid for each new
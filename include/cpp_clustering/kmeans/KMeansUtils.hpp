@@ -1,10 +1,585 @@
 #pragma once
 
 #include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/containers/FeatureMajorView.hpp"
+#include "cpp_clustering/containers/kdtree/KDTree.hpp"
 #include "cpp_clustering/heuristics/Heuristics.hpp"
 
+#include <array>
+#include <cstdint>
+#include <tuple>
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
 namespace kmeans::utils {
 
+template <typename Iterator, typename OutputIterator>
+void samples_squared_norms(const Iterator&       samples_first,
+                           const Iterator&       samples_last,
+                           std::size_t           n_features,
+                           const OutputIterator& squared_norms_first) {
+    using DataType = typename Iterator::value_type;
+
+    const std::size_t n_samples = common::utils::get_n_samples(samples_first, samples_last, n_features);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        const auto sample_first = samples_first + sample_index * n_features;
+
+        squared_norms_first[sample_index] =
+            std::transform_reduce(sample_first, sample_first + n_features, sample_first, static_cast<DataType>(0));
+    }
+}
+
+template <typename Iterator>
+std::vector<typename Iterator::value_type> samples_squared_norms(const Iterator& samples_first,
+                                                                 const Iterator& samples_last,
+                                                                 std::size_t     n_features) {
+    auto squared_norms = std::vector<typename Iterator::value_type>(
+        common::utils::get_n_samples(samples_first, samples_last, n_features));
+
+    samples_squared_norms(samples_first, samples_last, n_features, squared_norms.begin());
+
+    return squared_norms;
+}
+
+/**
+ * @brief Dot products of a sample with 4 centroids at once so that each feature of the sample is loaded once for 4
+ * multiply-adds. The loop is a plain reduction that the compiler vectorizes.
+ */
+template <typename Iterator1, typename Iterator2>
+std::array<typename Iterator1::value_type, 4> dot_products_4(const Iterator1& sample_first,
+                                                             std::size_t      n_features,
+                                                             const Iterator2& centroid_0_first,
+                                                             const Iterator2& centroid_1_first,
+                                                             const Iterator2& centroid_2_first,
+                                                             const Iterator2& centroid_3_first) {
+    using DataType = typename Iterator1::value_type;
+
+    DataType dot_0 = 0, dot_1 = 0, dot_2 = 0, dot_3 = 0;
+
+    for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+        const DataType feature = *(sample_first + feature_index);
+
+        dot_0 += feature * *(centroid_0_first + feature_index);
+        dot_1 += feature * *(centroid_1_first + feature_index);
+        dot_2 += feature * *(centroid_2_first + feature_index);
+        dot_3 += feature * *(centroid_3_first + feature_index);
+    }
+    return {dot_0, dot_1, dot_2, dot_3};
+}
+
+// number of samples of a tile of the blocked nearest centroid assignment. The samples of a tile share the same tiles
+// of centroids
+inline constexpr std::size_t nearest_centroid_samples_block_size = 64;
+
+// number of centroids processed at once in the vector lanes of the blocked nearest centroid assignment specialized for
+// a number of features known at compile time. Fewer centroids than that use the runtime kernel
+inline constexpr std::size_t nearest_centroid_chunk_size = 16;
+
+/**
+ * @brief Blocked nearest centroid assignment of the samples in [samples_block_begin, samples_block_end) for a number
+ * of features known at compile time. Each tile of centroids is transposed feature-major so that ||c||^2 - 2 x.c is
+ * computed for a chunk of consecutive centroids in the same vector registers while the features of the sample stay in
+ * registers. The running argmin is kept per vector lane with selects and reduced once per tile. The nearest centroids
+ * are the same as the ones of the runtime kernel.
+ *
+ * @tparam NFeatures
+ * @tparam Iterator
+ * @tparam IteratorInt
+ * @tparam IteratorFloat
+ * @param samples_first
+ * @param samples_block_begin
+ * @param samples_block_end
+ * @param centroids
+ * @param centroids_squared_norms
+ * @param samples_to_nearest_centroid_indices_first output indexed by sample_index
+ * @param samples_to_nearest_centroid_distances_first output indexed by sample_index
+ */
+template <std::size_t NFeatures, typename Iterator, typename IteratorInt, typename IteratorFloat>
+void samples_block_to_nearest_centroid_indices_and_distances(
+    const Iterator&                                   samples_first,
+    std::size_t                                       samples_block_begin,
+    std::size_t                                       samples_block_end,
+    const std::vector<typename Iterator::value_type>& centroids,
+    const std::vector<typename Iterator::value_type>& centroids_squared_norms,
+    IteratorInt                                       samples_to_nearest_centroid_indices_first,
+    IteratorFloat                                     samples_to_nearest_centroid_distances_first) {
+    static_assert(NFeatures != common::utils::dynamic_n_features, "The number of features should be known.");
+
+    using DataType = typename Iterator::value_type;
+
+    // the centroids of a tile are processed by chunks with a compile time trip count that the compiler vectorizes
+    constexpr std::size_t centroids_chunk_size = nearest_centroid_chunk_size;
+    // a tile of centroids takes at most 16KiB and at most 256 centroids
+    constexpr std::size_t centroids_block_size = std::min(
+        static_cast<std::size_t>(256),
+        std::max(centroids_chunk_size,
+                 16384 / (NFeatures * sizeof(DataType)) / centroids_chunk_size * centroids_chunk_size));
+
+    // indices of the centroids within a tile, with the same width as DataType so that they share the vector lanes
+    using LaneIndexType = std::conditional_t<sizeof(DataType) <= sizeof(std::uint32_t), std::uint32_t, std::uint64_t>;
+
+    const std::size_t n_centroids = centroids_squared_norms.size();
+
+    // the features of the tile of centroids, feature-major: centroids_block_transposed[f * centroids_block_size + c].
+    // The last chunk of the tile is padded with null centroids of infinite squared norm
+    auto centroids_block_transposed    = std::array<DataType, NFeatures * centroids_block_size>();
+    auto centroids_block_squared_norms = std::array<DataType, centroids_block_size>();
+
+    auto block_min_values  = std::array<DataType, nearest_centroid_samples_block_size>();
+    auto block_min_indices = std::array<std::size_t, nearest_centroid_samples_block_size>();
+
+    block_min_values.fill(common::utils::infinity<DataType>());
+    block_min_indices.fill(0);
+
+    for (std::size_t centroids_block_begin = 0; centroids_block_begin < n_centroids;
+         centroids_block_begin += centroids_block_size) {
+        const std::size_t n_block_centroids = std::min(centroids_block_size, n_centroids - centroids_block_begin);
+        const std::size_t n_block_chunks = (n_block_centroids + centroids_chunk_size - 1) / centroids_chunk_size;
+        const std::size_t n_block_padded_centroids = n_block_chunks * centroids_chunk_size;
+
+        for (std::size_t block_centroid_index = n_block_centroids; block_centroid_index < n_block_padded_centroids;
+             ++block_centroid_index) {
+            for (std::size_t feature_index = 0; feature_index < NFeatures; ++feature_index) {
+                centroids_block_transposed[feature_index * centroids_block_size + block_centroid_index] = 0;
+            }
+            centroids_block_squared_norms[block_centroid_index] = common::utils::infinity<DataType>();
+        }
+        for (std::size_t block_centroid_index = 0; block_centroid_index < n_block_centroids; ++block_centroid_index) {
+            for (std::size_t feature_index = 0; feature_index < NFeatures; ++feature_index) {
+                centroids_block_transposed[feature_index * centroids_block_size + block_centroid_index] =
+                    centroids[(centroids_block_begin + block_centroid_index) * NFeatures + feature_index];
+            }
+            centroids_block_squared_norms[block_centroid_index] =
+                centroids_squared_norms[centroids_block_begin + block_centroid_index];
+        }
+        for (std::size_t sample_index = samples_block_begin; sample_index < samples_block_end; ++sample_index) {
+            auto sample = std::array<DataType, NFeatures>();
+
+            std::copy(samples_first + sample_index * NFeatures,
+                      samples_first + sample_index * NFeatures + NFeatures,
+                      sample.begin());
+
+            // running minimum of ||c||^2 - 2 x.c and its centroid index in the tile for each lane of a chunk, updated
+            // with selects instead of branches so that the argmin is vectorized with the distances
+            auto lanes_min_values  = std::array<DataType, centroids_chunk_size>();
+            auto lanes_min_indices = std::array<LaneIndexType, centroids_chunk_size>();
+
+            lanes_min_values.fill(common::utils::infinity<DataType>());
+            lanes_min_indices.fill(0);
+
+            for (std::size_t chunk_begin = 0; chunk_begin < n_block_padded_centroids;
+                 chunk_begin += centroids_chunk_size) {
+                auto dot_products = std::array<DataType, centroids_chunk_size>();
+
+                for (std::size_t feature_index = 0; feature_index < NFeatures; ++feature_index) {
+                    const auto chunk_features_first =
+                        centroids_block_transposed.begin() + feature_index * centroids_block_size + chunk_begin;
+
+                    for (std::size_t lane_index = 0; lane_index < centroids_chunk_size; ++lane_index) {
+                        dot_products[lane_index] += sample[feature_index] * chunk_features_first[lane_index];
+                    }
+                }
+                for (std::size_t lane_index = 0; lane_index < centroids_chunk_size; ++lane_index) {
+                    const DataType nearest_candidate =
+                        centroids_block_squared_norms[chunk_begin + lane_index] - 2 * dot_products[lane_index];
+
+                    const bool is_nearer = nearest_candidate < lanes_min_values[lane_index];
+
+                    const auto block_centroid_index = static_cast<LaneIndexType>(chunk_begin + lane_index);
+
+                    lanes_min_values[lane_index]  = is_nearer ? nearest_candidate : lanes_min_values[lane_index];
+                    lanes_min_indices[lane_index] = is_nearer ? block_centroid_index : lanes_min_indices[lane_index];
+                }
+            }
+            auto& min_value = block_min_values[sample_index - samples_block_begin];
+            auto& min_index = block_min_indices[sample_index - samples_block_begin];
+
+            // the ties go to the lowest centroid index, like a sequential scan of the centroids would do
+            for (std::size_t lane_index = 0; lane_index < centroids_chunk_size; ++lane_index) {
+                const std::size_t centroid_index = centroids_block_begin + lanes_min_indices[lane_index];
+
+                if (lanes_min_values[lane_index] < min_value ||
+                    (lanes_min_values[lane_index] == min_value && centroid_index < min_index)) {
+                    min_value = lanes_min_values[lane_index];
+                    min_index = centroid_index;
+                }
+            }
+        }
+    }
+    for (std::size_t sample_index = samples_block_begin; sample_index < samples_block_end; ++sample_index) {
+        const auto min_index = block_min_indices[sample_index - samples_block_begin];
+
+        *(samples_to_nearest_centroid_indices_first + sample_index) = min_index;
+        *(samples_to_nearest_centroid_distances_first + sample_index) =
+            cpp_clustering::heuristic::heuristic<NFeatures>(samples_first + sample_index * NFeatures,
+                                                            samples_first + sample_index * NFeatures + NFeatures,
+                                                            centroids.begin() + min_index * NFeatures);
+    }
+}
+
+/**
+ * @brief Blocked nearest centroid assignment of the samples in [samples_block_begin, samples_block_end) (at most
+ * nearest_centroid_samples_block_size samples). Uses the expansion ||x - c||^2 = ||x||^2 - 2 x.c + ||c||^2 so that the
+ * inner loops are only dot products. The tile of samples iterates over tiles of centroids small enough to stay in the
+ * L1 cache while they are reused by all the samples of the tile. ||x||^2 doesnt change the argmin, so only
+ * ||c||^2 - 2 x.c is compared and the distance of the winning pair is computed exactly once with a single sqrt (which
+ * also avoids the cancellation errors of the expansion in the returned distances). The common numbers of features
+ * are dispatched to the kernel specialized at compile time when there are enough centroids to fill its vector lanes.
+ *
+ * @tparam Iterator
+ * @tparam IteratorInt
+ * @tparam IteratorFloat
+ * @param samples_first
+ * @param n_features
+ * @param samples_block_begin
+ * @param samples_block_end
+ * @param centroids
+ * @param centroids_squared_norms
+ * @param samples_to_nearest_centroid_indices_first output indexed by sample_index
+ * @param samples_to_nearest_centroid_distances_first output indexed by sample_index
+ */
+template <typename Iterator, typename IteratorInt, typename IteratorFloat>
+void samples_block_to_nearest_centroid_indices_and_distances(
+    const Iterator&                                   samples_first,
+    std::size_t                                       n_features,
+    std::size_t                                       samples_block_begin,
+    std::size_t                                       samples_block_end,
+    const std::vector<typename Iterator::value_type>& centroids,
+    const std::vector<typename Iterator::value_type>& centroids_squared_norms,
+    IteratorInt                                       samples_to_nearest_centroid_indices_first,
+    IteratorFloat                                     samples_to_nearest_centroid_distances_first) {
+    using DataType = typename Iterator::value_type;
+
+    const bool is_specialized = common::utils::dispatch_n_features(n_features, [&](auto n_features_constant) {
+        constexpr std::size_t NFeatures = decltype(n_features_constant)::value;
+
+        if (centroids_squared_norms.size() < nearest_centroid_chunk_size) {
+            return false;
+        }
+        if constexpr (NFeatures != common::utils::dynamic_n_features) {
+            samples_block_to_nearest_centroid_indices_and_distances<NFeatures>(
+                samples_first,
+                samples_block_begin,
+                samples_block_end,
+                centroids,
+                centroids_squared_norms,
+                samples_to_nearest_centroid_indices_first,
+                samples_to_nearest_centroid_distances_first);
+        }
+        return NFeatures != common::utils::dynamic_n_features;
+    });
+
+    if (is_specialized) {
+        return;
+    }
+    // bytes budget of a tile of centroids
+    constexpr std::size_t centroids_block_bytes = 16384;
+
+    const std::size_t n_centroids = centroids_squared_norms.size();
+
+    // a multiple of 4 centroids for the dot_products_4 kernel
+    const std::size_t centroid_bytes = std::max(n_features, static_cast<std::size_t>(1)) * sizeof(DataType);
+    const std::size_t centroids_block_size =
+        std::max(static_cast<std::size_t>(4), centroids_block_bytes / centroid_bytes / 4 * 4);
+
+    // the running minimum of ||c||^2 - 2 x.c and its centroid index for each sample of the tile
+    auto block_min_values  = std::array<DataType, nearest_centroid_samples_block_size>();
+    auto block_min_indices = std::array<std::size_t, nearest_centroid_samples_block_size>();
+
+    block_min_values.fill(common::utils::infinity<DataType>());
+    block_min_indices.fill(0);
+
+    for (std::size_t centroids_block_begin = 0; centroids_block_begin < n_centroids;
+         centroids_block_begin += centroids_block_size) {
+        const std::size_t centroids_block_end = std::min(centroids_block_begin + centroids_block_size, n_centroids);
+
+        for (std::size_t sample_index = samples_block_begin; sample_index < samples_block_end; ++sample_index) {
+            const auto sample_first = samples_first + sample_index * n_features;
+
+            auto& min_value = block_min_values[sample_index - samples_block_begin];
+            auto& min_index = block_min_indices[sample_index - samples_block_begin];
+
+            std::size_t centroid_index = centroids_block_begin;
+
+            for (; centroid_index + 4 <= centroids_block_end; centroid_index += 4) {
+                const auto dot_products = dot_products_4(sample_first,
+                                                         n_features,
+                                                         centroids.begin() + centroid_index * n_features,
+                                                         centroids.begin() + (centroid_index + 1) * n_features,
+                                                         centroids.begin() + (centroid_index + 2) * n_features,
+                                                         centroids.begin() + (centroid_index + 3) * n_features);
+
+                for (std::size_t offset = 0; offset < 4; ++offset) {
+                    const auto nearest_candidate =
+                        centroids_squared_norms[centroid_index + offset] - 2 * dot_products[offset];
+
+                    if (nearest_candidate < min_value) {
+                        min_value = nearest_candidate;
+                        min_index = centroid_index + offset;
+                    }
+                }
+            }
+            for (; centroid_index < centroids_block_end; ++centroid_index) {
+                const auto nearest_candidate =
+                    centroids_squared_norms[centroid_index] -
+                    2 * std::transform_reduce(sample_first,
+                                              sample_first + n_features,
+                                              centroids.begin() + centroid_index * n_features,
+                                              static_cast<DataType>(0));
+
+                if (nearest_candidate < min_value) {
+                    min_value = nearest_candidate;
+                    min_index = centroid_index;
+                }
+            }
+        }
+    }
+    for (std::size_t sample_index = samples_block_begin; sample_index < samples_block_end; ++sample_index) {
+        const auto min_index = block_min_indices[sample_index - samples_block_begin];
+
+        *(samples_to_nearest_centroid_indices_first + sample_index) = min_index;
+        *(samples_to_nearest_centroid_distances_first + sample_index) =
+            cpp_clustering::heuristic::heuristic(samples_first + sample_index * n_features,
+                                                 samples_first + sample_index * n_features + n_features,
+                                                 centroids.begin() + min_index * n_features);
+    }
+}
+
+/**
+ * @brief Nearest centroid assignment of the samples in [samples_block_begin, samples_block_end) (at most
+ * nearest_centroid_samples_block_size samples) of a feature-major dataset. The samples of the tile are compared to one
+ * centroid at a time and the loops run over consecutive samples of each column, so that the vector lanes are filled
+ * with samples even when there are only a few features. The squared distances are computed directly (without the
+ * expansion) and the running argmin of each sample is kept with selects.
+ *
+ * @tparam NFeatures the number of features if known at compile time, common::utils::dynamic_n_features otherwise
+ * @tparam DataType
+ * @tparam IteratorInt
+ * @tparam IteratorFloat
+ * @param samples_first
+ * @param n_features
+ * @param samples_block_begin
+ * @param samples_block_end
+ * @param centroids
+ * @param samples_to_nearest_centroid_indices_first output indexed by sample_index
+ * @param samples_to_nearest_centroid_distances_first output indexed by sample_index
+ */
+template <std::size_t NFeatures, typename DataType, typename IteratorInt, typename IteratorFloat>
+void feature_major_samples_block_to_nearest_centroid_indices_and_distances(
+    const cpp_clustering::containers::FeatureMajorIterator<DataType>& samples_first,
+    std::size_t                                                       n_features,
+    std::size_t                                                       samples_block_begin,
+    std::size_t                                                       samples_block_end,
+    const std::vector<DataType>&                                      centroids,
+    IteratorInt                                                       samples_to_nearest_centroid_indices_first,
+    IteratorFloat                                                     samples_to_nearest_centroid_distances_first) {
+    // centroid indices with the same width as DataType so that they share the vector lanes
+    using LaneIndexType = std::conditional_t<sizeof(DataType) <= sizeof(std::uint32_t), std::uint32_t, std::uint64_t>;
+
+    const std::size_t n_centroids        = centroids.size() / n_features;
+    const std::size_t samples_block_size = samples_block_end - samples_block_begin;
+    // the first sample of the tile in the columns
+    const DataType* samples_block_columns =
+        samples_first.columns() + samples_first.sample_index() + samples_block_begin;
+
+    auto block_min_values        = std::array<DataType, nearest_centroid_samples_block_size>();
+    auto block_min_indices       = std::array<LaneIndexType, nearest_centroid_samples_block_size>();
+    auto block_squared_distances = std::array<DataType, nearest_centroid_samples_block_size>();
+
+    block_min_values.fill(common::utils::infinity<DataType>());
+    block_min_indices.fill(0);
+
+    for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+        const auto centroid_first = centroids.begin() + centroid_index * n_features;
+
+        if constexpr (NFeatures != common::utils::dynamic_n_features) {
+            auto centroid = std::array<DataType, NFeatures>();
+
+            std::copy(centroid_first, centroid_first + NFeatures, centroid.begin());
+
+            for (std::size_t block_sample_index = 0; block_sample_index < samples_block_size; ++block_sample_index) {
+                auto squared_distance = static_cast<DataType>(0);
+
+                for (std::size_t feature_index = 0; feature_index < NFeatures; ++feature_index) {
+                    const DataType difference =
+                        samples_block_columns[feature_index * samples_first.n_samples() + block_sample_index] -
+                        centroid[feature_index];
+
+                    squared_distance += difference * difference;
+                }
+                block_squared_distances[block_sample_index] = squared_distance;
+            }
+        } else {
+            std::fill(block_squared_distances.begin(), block_squared_distances.end(), static_cast<DataType>(0));
+
+            for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+                const DataType  centroid_feature = *(centroid_first + feature_index);
+                const DataType* column           = samples_block_columns + feature_index * samples_first.n_samples();
+
+                for (std::size_t block_sample_index = 0; block_sample_index < samples_block_size;
+                     ++block_sample_index) {
+                    const DataType difference = column[block_sample_index] - centroid_feature;
+
+                    block_squared_distances[block_sample_index] += difference * difference;
+                }
+            }
+        }
+        // strictly closer so that the ties go to the lowest centroid index
+        for (std::size_t block_sample_index = 0; block_sample_index < samples_block_size; ++block_sample_index) {
+            const bool is_closer = block_squared_distances[block_sample_index] < block_min_values[block_sample_index];
+
+            block_min_values[block_sample_index] =
+                is_closer ? block_squared_distances[block_sample_index] : block_min_values[block_sample_index];
+            block_min_indices[block_sample_index] =
+                is_closer ? static_cast<LaneIndexType>(centroid_index) : block_min_indices[block_sample_index];
+        }
+    }
+    for (std::size_t block_sample_index = 0; block_sample_index < samples_block_size; ++block_sample_index) {
+        *(samples_to_nearest_centroid_indices_first + samples_block_begin + block_sample_index) =
+            block_min_indices[block_sample_index];
+        *(samples_to_nearest_centroid_distances_first + samples_block_begin + block_sample_index) =
+            std::sqrt(block_min_values[block_sample_index]);
+    }
+}
+
+/**
+ * @brief Overload of the blocked nearest centroid assignment for the feature-major datasets. The common numbers of
+ * features are dispatched to the kernel specialized at compile time.
+ */
+template <typename DataType, typename IteratorInt, typename IteratorFloat>
+void samples_block_to_nearest_centroid_indices_and_distances(
+    const cpp_clustering::containers::FeatureMajorIterator<DataType>& samples_first,
+    std::size_t                                                       n_features,
+    std::size_t                                                       samples_block_begin,
+    std::size_t                                                       samples_block_end,
+    const std::vector<DataType>&                                      centroids,
+    const std::vector<DataType>&                                      centroids_squared_norms,
+    IteratorInt                                                       samples_to_nearest_centroid_indices_first,
+    IteratorFloat                                                     samples_to_nearest_centroid_distances_first) {
+    // the squared distances are computed directly
+    static_cast<void>(centroids_squared_norms);
+
+    common::utils::dispatch_n_features(n_features, [&](auto n_features_constant) {
+        feature_major_samples_block_to_nearest_centroid_indices_and_distances<decltype(n_features_constant)::value>(
+            samples_first,
+            n_features,
+            samples_block_begin,
+            samples_block_end,
+            centroids,
+            samples_to_nearest_centroid_indices_first,
+            samples_to_nearest_centroid_distances_first);
+    });
+}
+
+/**
+ * @brief Adds the samples in [samples_block_begin, samples_block_end) to the sum of positions of their cluster.
+ *
+ * @tparam Iterator
+ * @tparam IteratorInt
+ * @tparam IteratorFloat
+ * @param samples_first
+ * @param n_features
+ * @param samples_block_begin
+ * @param samples_block_end
+ * @param samples_to_nearest_centroid_indices_first indexed by sample_index
+ * @param cluster_position_sums_first n_centroids x n_features sums updated inplace
+ */
+template <typename Iterator, typename IteratorInt, typename IteratorFloat>
+void add_samples_block_to_cluster_position_sums(const Iterator&    samples_first,
+                                                std::size_t        n_features,
+                                                std::size_t        samples_block_begin,
+                                                std::size_t        samples_block_end,
+                                                const IteratorInt& samples_to_nearest_centroid_indices_first,
+                                                IteratorFloat      cluster_position_sums_first) {
+    for (std::size_t sample_index = samples_block_begin; sample_index < samples_block_end; ++sample_index) {
+        const auto centroid_index = *(samples_to_nearest_centroid_indices_first + sample_index);
+
+        std::transform(cluster_position_sums_first + centroid_index * n_features,
+                       cluster_position_sums_first + centroid_index * n_features + n_features,
+                       samples_first + sample_index * n_features,
+                       cluster_position_sums_first + centroid_index * n_features,
+                       std::plus<>());
+    }
+}
+
+/**
+ * @brief Overload for the feature-major datasets that reads one column at a time instead of jumping from sample to
+ * sample. Each sum still adds its samples in increasing sample order, so the result is the same as the sample-major
+ * overload.
+ */
+template <typename DataType, typename IteratorInt, typename IteratorFloat>
+void add_samples_block_to_cluster_position_sums(
+    const cpp_clustering::containers::FeatureMajorIterator<DataType>& samples_first,
+    std::size_t                                                       n_features,
+    std::size_t                                                       samples_block_begin,
+    std::size_t                                                       samples_block_end,
+    const IteratorInt&                                                samples_to_nearest_centroid_indices_first,
+    IteratorFloat                                                     cluster_position_sums_first) {
+    for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+        const DataType* column =
+            samples_first.columns() + feature_index * samples_first.n_samples() + samples_first.sample_index();
+
+        for (std::size_t sample_index = samples_block_begin; sample_index < samples_block_end; ++sample_index) {
+            const auto centroid_index = *(samples_to_nearest_centroid_indices_first + sample_index);
+
+            *(cluster_position_sums_first + centroid_index * n_features + feature_index) += column[sample_index];
+        }
+    }
+}
+
+/**
+ * @brief Nearest centroid index and distance of each sample, computed in parallel over tiles of samples with
+ * samples_block_to_nearest_centroid_indices_and_distances.
+ *
+ * @tparam Iterator
+ * @tparam IteratorInt
+ * @tparam IteratorFloat
+ * @param samples_first
+ * @param samples_last
+ * @param n_features
+ * @param centroids
+ * @param samples_to_nearest_centroid_indices_first output of n_samples nearest centroid indices
+ * @param samples_to_nearest_centroid_distances_first output of n_samples nearest centroid distances
+ */
+template <typename Iterator, typename IteratorInt, typename IteratorFloat>
+void samples_to_nearest_centroid_indices_and_distances(
+    const Iterator&                                   samples_first,
+    const Iterator&                                   samples_last,
+    std::size_t                                       n_features,
+    const std::vector<typename Iterator::value_type>& centroids,
+    IteratorInt                                       samples_to_nearest_centroid_indices_first,
+    IteratorFloat                                     samples_to_nearest_centroid_distances_first) {
+    const std::size_t n_samples = common::utils::get_n_samples(samples_first, samples_last, n_features);
+
+    if (centroids.empty()) {
+        return;
+    }
+    const auto centroids_squared_norms = samples_squared_norms(centroids.begin(), centroids.end(), n_features);
+
+    const std::size_t n_samples_blocks =
+        (n_samples + nearest_centroid_samples_block_size - 1) / nearest_centroid_samples_block_size;
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for schedule(static)
+#endif
+    for (std::size_t samples_block_index = 0; samples_block_index < n_samples_blocks; ++samples_block_index) {
+        const std::size_t samples_block_begin = samples_block_index * nearest_centroid_samples_block_size;
+
+        samples_block_to_nearest_centroid_indices_and_distances(
+            samples_first,
+            n_features,
+            samples_block_begin,
+            std::min(samples_block_begin + nearest_centroid_samples_block_size, n_samples),
+            centroids,
+            centroids_squared_norms,
+            samples_to_nearest_centroid_indices_first,
+            samples_to_nearest_centroid_distances_first);
+    }
+}
+
 template <typename Iterator>
 std::vector<std::size_t> samples_to_nearest_centroid_indices(
     const Iterator&                                   samples_first,
@@ -13,30 +588,19 @@ std::vector<std::size_t> samples_to_nearest_centroid_indices(
     const std::vector<typename Iterator::value_type>& centroids) {
     using DataType = typename Iterator::value_type;
 
-    const std::size_t n_samples   = common::utils::get_n_samples(samples_first, samples_last, n_features);
-    const std::size_t n_centroids = centroids.size() / n_features;
+    const std::size_t n_samples = common::utils::get_n_samples(samples_first, samples_last, n_features);
 
     // contains the indices from each sample to the nearest centroid
-    auto nearest_centroid_indices = std::vector<std::size_t>(n_samples);
+    auto nearest_centroid_indices   = std::vector<std::size_t>(n_samples);
+    auto nearest_centroid_distances = std::vector<DataType>(n_samples);
 
-    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
-        // distance buffer for a given data sample to each cluster
-        auto        min_distance = common::utils::infinity<DataType>();
-        std::size_t min_index    = 0;
+    samples_to_nearest_centroid_indices_and_distances(samples_first,
+                                                      samples_last,
+                                                      n_features,
+                                                      centroids,
+                                                      nearest_centroid_indices.begin(),
+                                                      nearest_centroid_distances.begin());
 
-        for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
-            const DataType sample_to_centroid_distance =
-                cpp_clustering::heuristic::heuristic(samples_first + sample_index * n_features,
-                                                     samples_first + sample_index * n_features + n_features,
-                                                     centroids.begin() + centroid_index * n_features);
-
-            if (sample_to_centroid_distance < min_distance) {
-                min_distance = sample_to_centroid_distance;
-                min_index    = centroid_index;
-            }
-        }
-        nearest_centroid_indices[sample_index] = min_index;
-    }
     return nearest_centroid_indices;
 }
 
@@ -48,28 +612,64 @@ std::vector<typename Iterator::value_type> samples_to_nearest_centroid_distances
     const std::vector<typename Iterator::value_type>& centroids) {
     using DataType = typename Iterator::value_type;
 
-    const std::size_t n_samples   = common::utils::get_n_samples(samples_first, samples_last, n_features);
-    const std::size_t n_centroids = centroids.size() / n_features;
+    const std::size_t n_samples = common::utils::get_n_samples(samples_first, samples_last, n_features);
 
     // contains the distances from each sample to the nearest centroid
+    auto nearest_centroid_indices   = std::vector<std::size_t>(n_samples);
     auto nearest_centroid_distances = std::vector<DataType>(n_samples);
 
+    samples_to_nearest_centroid_indices_and_distances(samples_first,
+                                                      samples_last,
+                                                      n_features,
+                                                      centroids,
+                                                      nearest_centroid_indices.begin(),
+                                                      nearest_centroid_distances.begin());
+
+    return nearest_centroid_distances;
+}
+
+/**
+ * @brief Updates the distances from each sample to its nearest centroid after a single centroid has been added to the
+ * centroids the distances were computed with, so that only n_samples new distances are computed.
+ *
+ * @tparam Iterator
+ * @tparam CentroidIterator
+ * @tparam IteratorFloat
+ * @param samples_first
+ * @param samples_last
+ * @param n_features
+ * @param new_centroid_first
+ * @param samples_to_nearest_centroid_distances_first n_samples distances updated inplace
+ * @return Iterator::value_type the sum of the updated distances
+ */
+template <typename Iterator, typename CentroidIterator, typename IteratorFloat>
+typename Iterator::value_type update_samples_to_nearest_centroid_distances(
+    const Iterator&         samples_first,
+    const Iterator&         samples_last,
+    std::size_t             n_features,
+    const CentroidIterator& new_centroid_first,
+    IteratorFloat           samples_to_nearest_centroid_distances_first) {
+    using DataType = typename Iterator::value_type;
+
+    const std::size_t n_samples = common::utils::get_n_samples(samples_first, samples_last, n_features);
+
+    auto distances_sum = static_cast<DataType>(0);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for reduction(+ : distances_sum)
+#endif
     for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
-        auto min_distance = common::utils::infinity<DataType>();
+        auto& nearest_centroid_distance = *(samples_to_nearest_centroid_distances_first + sample_index);
 
-        for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
-            const auto nearest_candidate =
-                cpp_clustering::heuristic::heuristic(samples_first + sample_index * n_features,
-                                                     samples_first + sample_index * n_features + n_features,
-                                                     centroids.begin() + centroid_index * n_features);
+        nearest_centroid_distance =
+            std::min(nearest_centroid_distance,
+                     cpp_clustering::heuristic::heuristic(samples_first + sample_index * n_features,
+                                                          samples_first + sample_index * n_features + n_features,
+                                                          new_centroid_first));
 
-            if (nearest_candidate < min_distance) {
-                min_distance = nearest_candidate;
-            }
-        }
-        nearest_centroid_distances[sample_index] = min_distance;
+        distances_sum += nearest_centroid_distance;
     }
-    return nearest_centroid_distances;
+    return distances_sum;
 }
 
 template <typename Iterator>
@@ -88,14 +688,15 @@ std::vector<typename Iterator::value_type> samples_to_second_nearest_centroid_di
 
     // iterate over all the samples
     for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        const auto sample_first = samples_first + sample_index * n_features;
+        const auto sample_last  = sample_first + n_features;
+
         auto first_min_distance  = std::numeric_limits<DataType>::max();
         auto second_min_distance = std::numeric_limits<DataType>::max();
         // iterate over the centroids indices
         for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
-            const auto second_nearest_candidate =
-                cpp_clustering::heuristic::heuristic(samples_first + sample_index * n_features,
-                                                     samples_first + sample_index * n_features + n_features,
-                                                     centroids.begin() + centroid_index * n_features);
+            const auto second_nearest_candidate = cpp_clustering::heuristic::heuristic(
+                sample_first, sample_last, centroids.begin() + centroid_index * n_features);
 
             if (second_nearest_candidate < first_min_distance) {
                 second_min_distance = first_min_distance;
@@ -155,17 +756,222 @@ std::vector<typename Iterator::value_type> compute_cluster_positions_sum(
     return cluster_positions_sum;
 }
 
+/**
+ * @brief The sum of the distances from each sample to the centroid it's assigned to, without searching the nearest one.
+ *
+ * @tparam Iterator
+ * @tparam IteratorInt
+ * @param samples_first
+ * @param samples_last
+ * @param n_features
+ * @param centroids
+ * @param samples_to_nearest_centroid_indices_first
+ * @return Iterator::value_type
+ */
+template <typename Iterator, typename IteratorInt>
+typename Iterator::value_type assigned_centroids_distances_sum(
+    const Iterator&                                   samples_first,
+    const Iterator&                                   samples_last,
+    std::size_t                                       n_features,
+    const std::vector<typename Iterator::value_type>& centroids,
+    const IteratorInt&                                samples_to_nearest_centroid_indices_first) {
+    static_assert(std::is_integral_v<typename IteratorInt::value_type>, "Input elements type should be integral.");
+
+    using DataType = typename Iterator::value_type;
+
+    const std::size_t n_samples = common::utils::get_n_samples(samples_first, samples_last, n_features);
+
+    auto distances_sum = static_cast<DataType>(0);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for reduction(+ : distances_sum)
+#endif
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        const auto assigned_centroid_index = *(samples_to_nearest_centroid_indices_first + sample_index);
+
+        distances_sum +=
+            cpp_clustering::heuristic::heuristic(samples_first + sample_index * n_features,
+                                                 samples_first + sample_index * n_features + n_features,
+                                                 centroids.begin() + assigned_centroid_index * n_features);
+    }
+    return distances_sum;
+}
+
+/**
+ * @brief The number of per thread buffers that a parallel region of the bound-based algorithms may index.
+ *
+ * @return std::size_t
+ */
+inline std::size_t max_n_threads() {
+#if defined(_OPENMP) && THREADS_ENABLED == true
+    return std::max(1, omp_get_max_threads());
+#else
+    return 1;
+#endif
+}
+
+/**
+ * @brief Makes one empty container of reassignments per thread for the bounds tests of Hamerly, Elkan and Yinyang. All
+ * of them are cleared since the parallel region might use less threads than requested.
+ *
+ * @tparam SamplesReassignments
+ * @param samples_reassignments
+ */
+template <typename SamplesReassignments>
+void reset_samples_reassignments(std::vector<SamplesReassignments>& samples_reassignments) {
+    samples_reassignments.resize(max_n_threads());
+
+    for (auto& thread_samples_reassignments : samples_reassignments) {
+        thread_samples_reassignments.clear();
+    }
+}
+
+/**
+ * @brief Moves the samples that changed cluster during the bounds tests of Hamerly, Elkan and Yinyang from the cluster
+ * size and position sum of their previous centroid to the ones of their new centroid. The reassignments of each thread
+ * are merged in increasing sample_index order so that the floating point accumulations happen in the same order as
+ * with a single thread.
+ *
+ * @tparam Iterator
+ * @param samples_first
+ * @param n_features
+ * @param samples_reassignments {sample_index, previous_assigned_centroid_index, previous_assigned_centroid_distance}
+ * for each sample that changed cluster. One container per thread
+ * @param samples_to_nearest_centroid_indices the new assignments
+ * @param samples_to_nearest_centroid_distances the upper bounds to the new assigned centroids
+ * @param cluster_sizes
+ * @param cluster_position_sums
+ * @return the change of the loss: the new contributions of the reassigned samples minus their previous ones
+ */
 template <typename Iterator>
-std::vector<typename Iterator::value_type> nearest_neighbor_distances(const Iterator& data_first,
-                                                                      const Iterator& data_last,
-                                                                      std::size_t     n_features) {
+typename Iterator::value_type merge_samples_reassignments(
+    const Iterator& samples_first,
+    std::size_t     n_features,
+    const std::vector<std::vector<std::tuple<std::size_t, std::size_t, typename Iterator::value_type>>>&
+                                                      samples_reassignments,
+    const std::vector<std::size_t>&                   samples_to_nearest_centroid_indices,
+    const std::vector<typename Iterator::value_type>& samples_to_nearest_centroid_distances,
+    std::vector<std::size_t>&                         cluster_sizes,
+    std::vector<typename Iterator::value_type>&       cluster_position_sums) {
+    auto loss_change = static_cast<typename Iterator::value_type>(0);
+
+    for (const auto& thread_samples_reassignments : samples_reassignments) {
+        for (const auto& [sample_index, previous_assigned_centroid_index, previous_assigned_centroid_distance] :
+             thread_samples_reassignments) {
+            const auto assigned_centroid_index = samples_to_nearest_centroid_indices[sample_index];
+
+            --cluster_sizes[previous_assigned_centroid_index];
+            ++cluster_sizes[assigned_centroid_index];
+
+            // subtract the current sample to the centroid it was previously assigned to
+            std::transform(cluster_position_sums.begin() + previous_assigned_centroid_index * n_features,
+                           cluster_position_sums.begin() + previous_assigned_centroid_index * n_features + n_features,
+                           samples_first + sample_index * n_features,
+                           cluster_position_sums.begin() + previous_assigned_centroid_index * n_features,
+                           std::minus<>());
+
+            // add the current sample to the centroid it is now assigned to
+            std::transform(cluster_position_sums.begin() + assigned_centroid_index * n_features,
+                           cluster_position_sums.begin() + assigned_centroid_index * n_features + n_features,
+                           samples_first + sample_index * n_features,
+                           cluster_position_sums.begin() + assigned_centroid_index * n_features,
+                           std::plus<>());
+
+            // remove the previous contribution of the sample and add the new one
+            loss_change -= previous_assigned_centroid_distance;
+            loss_change += samples_to_nearest_centroid_distances[sample_index];
+        }
+    }
+    return loss_change;
+}
+
+/**
+ * @brief Moves each centroid with at least one assigned sample to the mean of its samples. The centroids without
+ * samples stay where they are.
+ *
+ * @tparam DataType
+ * @param cluster_sizes
+ * @param cluster_position_sums
+ * @param n_features
+ * @param centroids
+ */
+template <typename DataType>
+void update_centroids(const std::vector<std::size_t>& cluster_sizes,
+                      const std::vector<DataType>&    cluster_position_sums,
+                      std::size_t                     n_features,
+                      std::vector<DataType>&          centroids) {
+    const std::size_t n_centroids = cluster_sizes.size();
+
+    for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+        const auto feature_index_start = centroid_index * n_features;
+        const auto feature_index_end   = feature_index_start + n_features;
+
+        if (cluster_sizes[centroid_index]) {
+            std::transform(cluster_position_sums.begin() + feature_index_start,
+                           cluster_position_sums.begin() + feature_index_end,
+                           centroids.begin() + feature_index_start,
+                           [cluster_size = cluster_sizes[centroid_index]](const auto& sum) {
+                               return sum / static_cast<DataType>(cluster_size);
+                           });
+        }
+    }
+}
+
+/**
+ * @brief Distances between the centroids before and after their update, used to move the bounds of Hamerly, Elkan and
+ * Yinyang.
+ *
+ * @tparam DataType
+ * @param previous_centroids
+ * @param centroids
+ * @param n_features
+ * @param centroid_velocities output, one distance per centroid
+ * @return DataType the largest change of a centroid coordinate
+ */
+template <typename DataType>
+DataType update_centroids_velocities(const std::vector<DataType>& previous_centroids,
+                                     const std::vector<DataType>& centroids,
+                                     std::size_t                  n_features,
+                                     std::vector<DataType>&       centroid_velocities) {
+    const std::size_t n_centroids = centroids.size() / n_features;
+
+    for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+        centroid_velocities[centroid_index] =
+            cpp_clustering::heuristic::heuristic(previous_centroids.begin() + centroid_index * n_features,
+                                                 previous_centroids.begin() + centroid_index * n_features + n_features,
+                                                 centroids.begin() + centroid_index * n_features);
+    }
+    return std::transform_reduce(
+        centroids.begin(),
+        centroids.end(),
+        previous_centroids.begin(),
+        static_cast<DataType>(0),
+        [](const auto& lhs, const auto& rhs) { return std::max(lhs, rhs); },
+        [](const auto& coordinate, const auto& previous_coordinate) {
+            return std::abs(coordinate - previous_coordinate);
+        });
+}
+
+/**
+ * @brief Writes the distance from each data d_i to its nearest data d_j with i != j by brute force. It doesn't
+ * allocate so it can be called at each step on the centroids.
+ *
+ * @tparam Iterator
+ * @tparam OutputIterator
+ * @param data_first
+ * @param data_last
+ * @param n_features
+ * @param neighbor_distances_first
+ */
+template <typename Iterator, typename OutputIterator>
+void nearest_neighbor_distances(const Iterator&       data_first,
+                                const Iterator&       data_last,
+                                std::size_t           n_features,
+                                const OutputIterator& neighbor_distances_first) {
     using DataType = typename Iterator::value_type;
 
     const std::size_t n_rows = common::utils::get_n_samples(data_first, data_last, n_features);
 
-    // contains the distances from each data d_i to its nearest data d_j with i != j
-    auto neighbor_distances = std::vector<DataType>(n_rows);
-
     for (std::size_t row_index = 0; row_index < n_rows; ++row_index) {
         auto min_distance = common::utils::infinity<DataType>();
 
@@ -181,8 +987,40 @@ std::vector<typename Iterator::value_type> nearest_neighbor_distances(const Iter
                 }
             }
         }
-        neighbor_distances[row_index] = min_distance;
+        neighbor_distances_first[row_index] = min_distance;
     }
+}
+
+// number of features from which the nearest neighbors are always searched by brute force
+inline constexpr std::size_t nearest_neighbor_kdtree_max_n_features = 16;
+
+template <typename Iterator>
+std::vector<typename Iterator::value_type> nearest_neighbor_distances(const Iterator& data_first,
+                                                                      const Iterator& data_last,
+                                                                      std::size_t     n_features) {
+    using DataType = typename Iterator::value_type;
+
+    const std::size_t n_rows = common::utils::get_n_samples(data_first, data_last, n_features);
+
+    // contains the distances from each data d_i to its nearest data d_j with i != j
+    auto neighbor_distances = std::vector<DataType>(n_rows, common::utils::infinity<DataType>());
+
+    // the kdtree only prunes well with more data than vertices of a box (2^n_features), brute force otherwise
+    if (n_features < nearest_neighbor_kdtree_max_n_features && n_rows > (std::size_t{1} << n_features)) {
+        // the kdtree reorders the data so it is built on a copy of it
+        auto data = std::vector<DataType>(data_first, data_last);
+
+        const auto kdtree = cpp_clustering::containers::KDTree(data.begin(), data.end(), n_features);
+        // the nearest neighbor of d_i is d_i itself (or a duplicate of it) so the second one is its nearest d_j
+        const auto distances = kdtree.knn(data_first, data_last, 2).second;
+
+        for (std::size_t row_index = 0; row_index < n_rows; ++row_index) {
+            neighbor_distances[row_index] = distances[row_index * 2 + 1];
+        }
+        return neighbor_distances;
+    }
+    nearest_neighbor_distances(data_first, data_last, n_features, neighbor_distances.begin());
+
     return neighbor_distances;
 }
 
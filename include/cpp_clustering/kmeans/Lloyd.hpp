@@ -7,6 +7,10 @@
 #include <tuple>
 #include <vector>
 
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
 namespace cpp_clustering {
 
 template <typename Iterator>
@@ -29,7 +33,9 @@ class Lloyd {
 
     DataType total_deviation();
 
-    std::vector<DataType> step();
+    const std::vector<DataType>& step();
+
+    DataType max_centroid_shift() const;
 
   private:
     struct Buffers {
@@ -47,9 +53,13 @@ class Lloyd {
 
         std::vector<std::size_t> cluster_sizes_;
         std::vector<DataType>    cluster_position_sums_;
-    };
+        std::vector<DataType>    centroids_squared_norms_;
 
-    void update_clusters();
+        // partial cluster sizes, positions sums and losses accumulated by each thread, kept from one step to the next
+        std::vector<std::vector<std::size_t>> threads_cluster_sizes_;
+        std::vector<std::vector<DataType>>    threads_cluster_position_sums_;
+        std::vector<DataType>                 threads_losses_;
+    };
 
     void update_centroids();
 
@@ -60,6 +70,8 @@ class Lloyd {
     std::vector<DataType>    centroids_;
     std::unique_ptr<Buffers> buffers_ptr_;
     DataType                 loss_;
+    // largest change of a centroid coordinate during the last step
+    DataType max_centroid_shift_;
 };
 
 template <typename Iterator>
@@ -82,7 +94,11 @@ Lloyd<Iterator>::Lloyd(const DatasetDescriptorType& dataset_descriptor,
                                             std::get<2>(dataset_descriptor_))}
   , centroids_{centroids}
   , buffers_ptr_{std::make_unique<Buffers>(dataset_descriptor, centroids_)}
-  , loss_{loss} {}
+  , loss_{loss}
+  , max_centroid_shift_{common::utils::infinity<DataType>()} {
+    // initial assignment, cluster sizes and intra-cluster sum of positions
+    update_buffers();
+}
 
 template <typename Iterator>
 typename Lloyd<Iterator>::DataType Lloyd<Iterator>::total_deviation() {
@@ -90,9 +106,7 @@ typename Lloyd<Iterator>::DataType Lloyd<Iterator>::total_deviation() {
 }
 
 template <typename Iterator>
-std::vector<typename Lloyd<Iterator>::DataType> Lloyd<Iterator>::step() {
-    // update the cluster sizes and intra-cluster sum of positions
-    update_clusters();
+const std::vector<typename Lloyd<Iterator>::DataType>& Lloyd<Iterator>::step() {
     // update all the centroids with the new intra-cluster positions sum and cluster sizes
     update_centroids();
     // recompute the loss w.r.t. the updated buffers
@@ -100,6 +114,11 @@ std::vector<typename Lloyd<Iterator>::DataType> Lloyd<Iterator>::step() {
     return centroids_;
 }
 
+template <typename Iterator>
+typename Lloyd<Iterator>::DataType Lloyd<Iterator>::max_centroid_shift() const {
+    return max_centroid_shift_;
+}
+
 template <typename Iterator>
 void Lloyd<Iterator>::update_centroids() {
     const auto        n_features  = std::get<2>(dataset_descriptor_);
@@ -108,6 +127,14 @@ void Lloyd<Iterator>::update_centroids() {
     auto& cluster_sizes         = buffers_ptr_->cluster_sizes_;
     auto& cluster_position_sums = buffers_ptr_->cluster_position_sums_;
 
+    max_centroid_shift_ = 0;
+
+    // returns the new value of a coordinate and keeps track of the largest coordinate change
+    auto update_coordinate = [this](const auto& previous_coordinate, const auto& coordinate) {
+        max_centroid_shift_ = std::max(max_centroid_shift_, std::abs(coordinate - previous_coordinate));
+        return coordinate;
+    };
+
     // Update the centroids using the assigned samples
     for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
         const auto feature_index_start = centroid_index * n_features;
@@ -115,56 +142,140 @@ void Lloyd<Iterator>::update_centroids() {
 
         if (cluster_sizes[centroid_index] == 0) {
             // For centroids with only 1 associated sample, the new position is the same as the previous one
-            std::copy(cluster_position_sums.begin() + feature_index_start,
-                      cluster_position_sums.begin() + feature_index_end,
-                      centroids_.begin() + feature_index_start);
+            std::transform(centroids_.begin() + feature_index_start,
+                           centroids_.begin() + feature_index_end,
+                           cluster_position_sums.begin() + feature_index_start,
+                           centroids_.begin() + feature_index_start,
+                           update_coordinate);
         } else {
             // Compute the new centroid position for the centroid that has more than 1 associated sample
-            std::transform(cluster_position_sums.begin() + feature_index_start,
-                           cluster_position_sums.begin() + feature_index_end,
+            std::transform(centroids_.begin() + feature_index_start,
+                           centroids_.begin() + feature_index_end,
+                           cluster_position_sums.begin() + feature_index_start,
                            centroids_.begin() + feature_index_start,
-                           [cluster_size = cluster_sizes[centroid_index]](const auto& sum) {
-                               return sum / static_cast<typename Lloyd<Iterator>::DataType>(cluster_size);
+                           [&update_coordinate, cluster_size = cluster_sizes[centroid_index]](
+                               const auto& previous_coordinate, const auto& sum) {
+                               return update_coordinate(
+                                   previous_coordinate,
+                                   sum / static_cast<typename Lloyd<Iterator>::DataType>(cluster_size));
                            });
         }
     }
 }
 
+/**
+ * @brief Single pass over the samples that assigns each sample to its nearest centroid and accumulates the cluster
+ * sizes, the intra-cluster sums of positions and the loss while the tile of samples is still in cache. Each thread
+ * accumulates in its own buffers which are then summed in thread order.
+ *
+ * @return Lloyd<Iterator>::DataType the loss
+ */
 template <typename Iterator>
 typename Iterator::value_type Lloyd<Iterator>::update_buffers() {
-    buffers_ptr_->samples_to_nearest_centroid_indices_ =
-        kmeans::utils::samples_to_nearest_centroid_indices(std::get<0>(dataset_descriptor_),
-                                                           std::get<1>(dataset_descriptor_),
-                                                           std::get<2>(dataset_descriptor_),
-                                                           centroids_);
-
-    buffers_ptr_->samples_to_nearest_centroid_distances_ =
-        kmeans::utils::samples_to_nearest_centroid_distances(std::get<0>(dataset_descriptor_),
-                                                             std::get<1>(dataset_descriptor_),
-                                                             std::get<2>(dataset_descriptor_),
-                                                             centroids_);
-
-    return std::reduce(buffers_ptr_->samples_to_nearest_centroid_distances_.begin(),
-                       buffers_ptr_->samples_to_nearest_centroid_distances_.end(),
-                       static_cast<typename Lloyd<Iterator>::DataType>(0),
-                       std::plus<>());
-}
-
-template <typename Iterator>
-void Lloyd<Iterator>::update_clusters() {
     const auto [samples_first, samples_last, n_features] = dataset_descriptor_;
     const std::size_t n_centroids                        = centroids_.size() / n_features;
 
-    buffers_ptr_->cluster_sizes_ =
-        kmeans::utils::compute_cluster_sizes(buffers_ptr_->samples_to_nearest_centroid_indices_.begin(),
-                                             buffers_ptr_->samples_to_nearest_centroid_indices_.end(),
-                                             n_centroids);
-    buffers_ptr_->cluster_position_sums_ =
-        kmeans::utils::compute_cluster_positions_sum(samples_first,
-                                                     samples_last,
-                                                     buffers_ptr_->samples_to_nearest_centroid_indices_.begin(),
-                                                     n_centroids,
-                                                     n_features);
+    auto& samples_to_nearest_centroid_indices   = buffers_ptr_->samples_to_nearest_centroid_indices_;
+    auto& samples_to_nearest_centroid_distances = buffers_ptr_->samples_to_nearest_centroid_distances_;
+    auto& threads_cluster_sizes                 = buffers_ptr_->threads_cluster_sizes_;
+    auto& threads_cluster_position_sums         = buffers_ptr_->threads_cluster_position_sums_;
+    auto& threads_losses                        = buffers_ptr_->threads_losses_;
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+    const std::size_t n_threads = std::max(1, omp_get_max_threads());
+#else
+    const std::size_t n_threads = 1;
+#endif
+    threads_cluster_sizes.resize(n_threads);
+    threads_cluster_position_sums.resize(n_threads);
+    threads_losses.resize(n_threads);
+
+    // reset all the buffers beforehand since the parallel region might use less threads than requested
+    for (std::size_t thread_index = 0; thread_index < n_threads; ++thread_index) {
+        threads_cluster_sizes[thread_index].assign(n_centroids, 0);
+        threads_cluster_position_sums[thread_index].assign(n_centroids * n_features, static_cast<DataType>(0));
+        threads_losses[thread_index] = 0;
+    }
+    auto& centroids_squared_norms = buffers_ptr_->centroids_squared_norms_;
+
+    kmeans::utils::samples_squared_norms(
+        centroids_.begin(), centroids_.end(), n_features, centroids_squared_norms.begin());
+
+    const std::size_t n_samples_blocks = (n_samples_ + kmeans::utils::nearest_centroid_samples_block_size - 1) /
+                                         kmeans::utils::nearest_centroid_samples_block_size;
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel
+#endif
+    {
+#if defined(_OPENMP) && THREADS_ENABLED == true
+        const std::size_t thread_index = omp_get_thread_num();
+#else
+        const std::size_t thread_index = 0;
+#endif
+        auto& cluster_sizes         = threads_cluster_sizes[thread_index];
+        auto& cluster_position_sums = threads_cluster_position_sums[thread_index];
+        auto  loss                  = static_cast<DataType>(0);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp for schedule(static)
+#endif
+        for (std::size_t samples_block_index = 0; samples_block_index < n_samples_blocks; ++samples_block_index) {
+            const std::size_t samples_block_begin =
+                samples_block_index * kmeans::utils::nearest_centroid_samples_block_size;
+            const std::size_t samples_block_end =
+                std::min(samples_block_begin + kmeans::utils::nearest_centroid_samples_block_size, n_samples_);
+
+            kmeans::utils::samples_block_to_nearest_centroid_indices_and_distances(
+                samples_first,
+                n_features,
+                samples_block_begin,
+                samples_block_end,
+                centroids_,
+                centroids_squared_norms,
+                samples_to_nearest_centroid_indices.begin(),
+                samples_to_nearest_centroid_distances.begin());
+
+            kmeans::utils::add_samples_block_to_cluster_position_sums(samples_first,
+                                                                      n_features,
+                                                                      samples_block_begin,
+                                                                      samples_block_end,
+                                                                      samples_to_nearest_centroid_indices.begin(),
+                                                                      cluster_position_sums.begin());
+
+            for (std::size_t sample_index = samples_block_begin; sample_index < samples_block_end; ++sample_index) {
+                ++cluster_sizes[samples_to_nearest_centroid_indices[sample_index]];
+
+                loss += samples_to_nearest_centroid_distances[sample_index];
+            }
+        }
+        threads_losses[thread_index] = loss;
+    }
+    auto& cluster_sizes         = buffers_ptr_->cluster_sizes_;
+    auto& cluster_position_sums = buffers_ptr_->cluster_position_sums_;
+
+    cluster_sizes.assign(n_centroids, 0);
+    cluster_position_sums.assign(n_centroids * n_features, static_cast<DataType>(0));
+
+    auto loss = static_cast<DataType>(0);
+
+    // merge the threads buffers in thread order so that the result doesnt depend on the scheduling
+    for (std::size_t thread_index = 0; thread_index < n_threads; ++thread_index) {
+        std::transform(cluster_sizes.begin(),
+                       cluster_sizes.end(),
+                       threads_cluster_sizes[thread_index].begin(),
+                       cluster_sizes.begin(),
+                       std::plus<>());
+
+        std::transform(cluster_position_sums.begin(),
+                       cluster_position_sums.end(),
+                       threads_cluster_position_sums[thread_index].begin(),
+                       cluster_position_sums.begin(),
+                       std::plus<>());
+
+        loss += threads_losses[thread_index];
+    }
+    return loss;
 }
 
 template <typename Iterator>
@@ -172,16 +283,12 @@ Lloyd<Iterator>::Buffers::Buffers(const Iterator&
                                   const Iterator&                                        samples_last,
                                   std::size_t                                            n_features,
                                   const std::vector<typename Lloyd<Iterator>::DataType>& centroids)
-  : samples_to_nearest_centroid_indices_{kmeans::utils::samples_to_nearest_centroid_indices(samples_first,
-                                                                                            samples_last,
-                                                                                            n_features,
-                                                                                            centroids)}
-  , samples_to_nearest_centroid_distances_{kmeans::utils::samples_to_nearest_centroid_distances(samples_first,
-                                                                                                samples_last,
-                                                                                                n_features,
-                                                                                                centroids)}
+  : samples_to_nearest_centroid_indices_{std::vector<std::size_t>(
+        common::utils::get_n_samples(samples_first, samples_last, n_features))}
+  , samples_to_nearest_centroid_distances_{std::vector<DataType>(samples_to_nearest_centroid_indices_.size())}
   , cluster_sizes_{std::vector<std::size_t>(centroids.size() / n_features)}
-  , cluster_position_sums_{std::vector<typename Lloyd<Iterator>::DataType>(centroids.size())} {}
+  , cluster_position_sums_{std::vector<typename Lloyd<Iterator>::DataType>(centroids.size())}
+  , centroids_squared_norms_{std::vector<typename Lloyd<Iterator>::DataType>(centroids.size() / n_features)} {}
 
 template <typename Iterator>
 Lloyd<Iterator>::Buffers::Buffers(const DatasetDescriptorType&                           dataset_descriptor,
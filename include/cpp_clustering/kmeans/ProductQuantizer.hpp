@@ -0,0 +1,402 @@
+#pragma once
+
+#include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/containers/FeatureMajorView.hpp"
+#include "cpp_clustering/heuristics/Heuristics.hpp"
+#include "cpp_clustering/kmeans/Hamerly.hpp"
+#include "cpp_clustering/kmeans/KMeans.hpp"
+#include "cpp_clustering/kmeans/KMeansUtils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
+namespace cpp_clustering {
+
+/**
+ * @brief Product quantization (https://ieeexplore.ieee.org/document/5432202). The features are split in n_subspaces
+ * contiguous subspaces of n_features / n_subspaces features and a KMeans<T> codebook of at most 256 centroids is
+ * trained in each of them. A sample is then encoded as n_subspaces bytes: the index of the nearest centroid of each of
+ * its subvectors. The distance from a query to an encoded sample is approximated with the distance to its decoded
+ * centroids (asymmetric distance computation) by summing n_subspaces values of a table computed once per query.
+ *
+ * @tparam T
+ */
+template <typename T>
+class ProductQuantizer {
+    static_assert(std::is_floating_point<T>::value, "ProductQuantizer only allows floating point types.");
+
+  public:
+    using Options  = typename KMeans<T>::Options;
+    using CodeType = std::uint8_t;
+
+    ProductQuantizer(std::size_t n_subspaces, std::size_t n_centroids, std::size_t n_features);
+
+    ProductQuantizer(std::size_t    n_subspaces,
+                     std::size_t    n_centroids,
+                     std::size_t    n_features,
+                     const Options& options);
+
+    ProductQuantizer(const ProductQuantizer&) = delete;
+
+    ProductQuantizer<T>& set_options(const Options& options);
+
+    template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
+    std::vector<T> fit(const SamplesIterator& data_first, const SamplesIterator& data_last);
+
+    template <typename SamplesIterator>
+    std::vector<T> fit(const SamplesIterator& data_first, const SamplesIterator& data_last);
+
+    template <typename SamplesIterator>
+    std::vector<CodeType> encode(const SamplesIterator& data_first, const SamplesIterator& data_last) const;
+
+    std::vector<T> decode(const std::vector<CodeType>& codes) const;
+
+    template <typename SamplesIterator>
+    std::vector<T> distance_table(const SamplesIterator& query_first, const SamplesIterator& query_last) const;
+
+    template <typename SamplesIterator>
+    std::vector<T> asymmetric_distances(const SamplesIterator&       query_first,
+                                        const SamplesIterator&       query_last,
+                                        const std::vector<CodeType>& codes) const;
+
+    std::size_t n_subspaces() const {
+        return n_subspaces_;
+    }
+
+    std::size_t n_subspace_features() const {
+        return n_subspace_features_;
+    }
+
+    // n_subspaces x n_centroids x n_subspace_features vectorized tensor of the centroids of each subspace
+    const std::vector<T>& codebooks() const {
+        return codebooks_;
+    }
+
+  private:
+    template <typename SamplesIterator>
+    void gather_subspace(const SamplesIterator& data_first,
+                         std::size_t            sample_index_begin,
+                         std::size_t            sample_index_end,
+                         std::size_t            subspace_index,
+                         std::vector<T>&        subvectors) const;
+
+    // same as gather_subspace but stored feature-major
+    template <typename SamplesIterator>
+    void gather_subspace_columns(const SamplesIterator& data_first,
+                                 std::size_t            sample_index_begin,
+                                 std::size_t            sample_index_end,
+                                 std::size_t            subspace_index,
+                                 std::vector<T>&        subvectors_columns) const;
+
+    // number of subspaces the features are split into, and thus of codes per sample
+    std::size_t n_subspaces_;
+    // number of centroids of the codebook of each subspace
+    std::size_t n_centroids_;
+    // number of features (dimensions) that a ProductQuantizer instance should handle
+    std::size_t n_features_;
+    // n_features_ / n_subspaces_
+    std::size_t n_subspace_features_;
+    // n_subspaces_ x n_centroids_ x n_subspace_features_ vectorized tensor of the centroids of each subspace
+    std::vector<T> codebooks_;
+
+    Options options_;
+};
+
+// number of samples encoded at once. Their subvectors stay in the cache while they are compared to each codebook
+inline constexpr std::size_t product_quantizer_samples_chunk_size = 1024;
+
+template <typename T>
+ProductQuantizer<T>::ProductQuantizer(std::size_t n_subspaces, std::size_t n_centroids, std::size_t n_features)
+  : ProductQuantizer<T>::ProductQuantizer(n_subspaces, n_centroids, n_features, Options()) {}
+
+template <typename T>
+ProductQuantizer<T>::ProductQuantizer(std::size_t    n_subspaces,
+                                      std::size_t    n_centroids,
+                                      std::size_t    n_features,
+                                      const Options& options)
+  : n_subspaces_{n_subspaces}
+  , n_centroids_{n_centroids}
+  , n_features_{n_features}
+  , n_subspace_features_{n_subspaces ? n_features / n_subspaces : 0}
+  , options_{options} {
+    if (!n_subspaces_ || n_features_ % n_subspaces_) {
+        throw std::invalid_argument("The number of features should be a multiple of the number of subspaces.");
+    }
+    if (!n_centroids_ || n_centroids_ > static_cast<std::size_t>(std::numeric_limits<CodeType>::max()) + 1) {
+        throw std::invalid_argument("The number of centroids per subspace should be between 1 and 256.");
+    }
+}
+
+template <typename T>
+ProductQuantizer<T>& ProductQuantizer<T>::set_options(const Options& options) {
+    options_ = options;
+    return *this;
+}
+
+template <typename T>
+template <typename SamplesIterator>
+void ProductQuantizer<T>::gather_subspace(const SamplesIterator& data_first,
+                                          std::size_t            sample_index_begin,
+                                          std::size_t            sample_index_end,
+                                          std::size_t            subspace_index,
+                                          std::vector<T>&        subvectors) const {
+    subvectors.resize((sample_index_end - sample_index_begin) * n_subspace_features_);
+
+    for (std::size_t sample_index = sample_index_begin; sample_index < sample_index_end; ++sample_index) {
+        const auto subvector_first = data_first + sample_index * n_features_ + subspace_index * n_subspace_features_;
+
+        std::copy(subvector_first,
+                  subvector_first + n_subspace_features_,
+                  subvectors.begin() + (sample_index - sample_index_begin) * n_subspace_features_);
+    }
+}
+
+template <typename T>
+template <typename SamplesIterator>
+void ProductQuantizer<T>::gather_subspace_columns(const SamplesIterator& data_first,
+                                                  std::size_t            sample_index_begin,
+                                                  std::size_t            sample_index_end,
+                                                  std::size_t            subspace_index,
+                                                  std::vector<T>&        subvectors_columns) const {
+    const std::size_t n_chunk_samples = sample_index_end - sample_index_begin;
+
+    subvectors_columns.resize(n_chunk_samples * n_subspace_features_);
+
+    for (std::size_t sample_index = sample_index_begin; sample_index < sample_index_end; ++sample_index) {
+        const auto subvector_first = data_first + sample_index * n_features_ + subspace_index * n_subspace_features_;
+
+        for (std::size_t feature_index = 0; feature_index < n_subspace_features_; ++feature_index) {
+            subvectors_columns[feature_index * n_chunk_samples + sample_index - sample_index_begin] =
+                *(subvector_first + feature_index);
+        }
+    }
+}
+
+/**
+ * @brief Trains the codebook of each subspace on the subvectors of all the samples. The subspaces are independent so
+ * their KMeans are fitted in parallel.
+ *
+ * @tparam KMeansAlgorithm
+ * @tparam SamplesIterator
+ * @param data_first
+ * @param data_last
+ * @return std::vector<T> the codebooks
+ */
+template <typename T>
+template <template <typename> class KMeansAlgorithm, typename SamplesIterator>
+std::vector<T> ProductQuantizer<T>::fit(const SamplesIterator& data_first, const SamplesIterator& data_last) {
+    const std::size_t n_samples = common::utils::get_n_samples(data_first, data_last, n_features_);
+
+    if (n_samples < n_centroids_) {
+        throw std::invalid_argument("The number of samples should be at least the number of centroids per subspace.");
+    }
+    codebooks_ = std::vector<T>(n_subspaces_ * n_centroids_ * n_subspace_features_);
+
+    // each fit has its own parallel regions that run on a single thread when nested
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for schedule(dynamic) if (n_subspaces_ > 1)
+#endif
+    for (std::size_t subspace_index = 0; subspace_index < n_subspaces_; ++subspace_index) {
+        auto subvectors = std::vector<T>();
+
+        gather_subspace(data_first, 0, n_samples, subspace_index, subvectors);
+
+        auto kmeans = KMeans<T>(n_centroids_, n_subspace_features_, options_);
+
+        const auto centroids = kmeans.template fit<KMeansAlgorithm>(subvectors.cbegin(), subvectors.cend());
+
+        std::copy(centroids.begin(),
+                  centroids.end(),
+                  codebooks_.begin() + subspace_index * n_centroids_ * n_subspace_features_);
+    }
+    return codebooks_;
+}
+
+template <typename T>
+template <typename SamplesIterator>
+std::vector<T> ProductQuantizer<T>::fit(const SamplesIterator& data_first, const SamplesIterator& data_last) {
+    return fit<cpp_clustering::Hamerly>(data_first, data_last);
+}
+
+/**
+ * @brief Codes of the samples. The samples are processed by chunks: the subvectors of a chunk are gathered
+ * feature-major for one subspace at a time and assigned with the feature-major nearest centroid kernel of KMeans, which
+ * computes the distances from a tile of subvectors to each centroid of the codebook across the vector lanes.
+ *
+ * @tparam SamplesIterator
+ * @param data_first
+ * @param data_last
+ * @return std::vector<CodeType> n_samples x n_subspaces row major codes
+ */
+template <typename T>
+template <typename SamplesIterator>
+std::vector<typename ProductQuantizer<T>::CodeType> ProductQuantizer<T>::encode(
+    const SamplesIterator& data_first,
+    const SamplesIterator& data_last) const {
+    if (codebooks_.empty()) {
+        throw std::invalid_argument("The ProductQuantizer instance should be fitted before encoding.");
+    }
+    const std::size_t n_samples = common::utils::get_n_samples(data_first, data_last, n_features_);
+    const std::size_t n_chunks =
+        (n_samples + product_quantizer_samples_chunk_size - 1) / product_quantizer_samples_chunk_size;
+
+    auto codes = std::vector<CodeType>(n_samples * n_subspaces_);
+
+    // the codebook of each subspace as the centroids of a KMeans
+    auto subspaces_centroids = std::vector<std::vector<T>>(n_subspaces_);
+
+    for (std::size_t subspace_index = 0; subspace_index < n_subspaces_; ++subspace_index) {
+        subspaces_centroids[subspace_index] =
+            std::vector<T>(codebooks_.begin() + subspace_index * n_centroids_ * n_subspace_features_,
+                           codebooks_.begin() + (subspace_index + 1) * n_centroids_ * n_subspace_features_);
+    }
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel
+#endif
+    {
+        auto subvectors_columns = std::vector<T>();
+        auto centroid_indices   = std::vector<std::size_t>(product_quantizer_samples_chunk_size);
+        auto centroid_distances = std::vector<T>(product_quantizer_samples_chunk_size);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp for schedule(static)
+#endif
+        for (std::size_t chunk_index = 0; chunk_index < n_chunks; ++chunk_index) {
+            const std::size_t sample_index_begin = chunk_index * product_quantizer_samples_chunk_size;
+            const std::size_t sample_index_end =
+                std::min(sample_index_begin + product_quantizer_samples_chunk_size, n_samples);
+
+            for (std::size_t subspace_index = 0; subspace_index < n_subspaces_; ++subspace_index) {
+                gather_subspace_columns(
+                    data_first, sample_index_begin, sample_index_end, subspace_index, subvectors_columns);
+
+                const std::size_t n_chunk_samples = sample_index_end - sample_index_begin;
+
+                const auto subvectors_first = containers::FeatureMajorIterator<T>(
+                    subvectors_columns.data(), n_chunk_samples, n_subspace_features_, 0, 0);
+                const auto subvectors_last = containers::FeatureMajorIterator<T>(
+                    subvectors_columns.data(), n_chunk_samples, n_subspace_features_, n_chunk_samples, 0);
+
+                kmeans::utils::samples_to_nearest_centroid_indices_and_distances(subvectors_first,
+                                                                                 subvectors_last,
+                                                                                 n_subspace_features_,
+                                                                                 subspaces_centroids[subspace_index],
+                                                                                 centroid_indices.begin(),
+                                                                                 centroid_distances.begin());
+
+                for (std::size_t sample_index = sample_index_begin; sample_index < sample_index_end; ++sample_index) {
+                    codes[sample_index * n_subspaces_ + subspace_index] =
+                        static_cast<CodeType>(centroid_indices[sample_index - sample_index_begin]);
+                }
+            }
+        }
+    }
+    return codes;
+}
+
+/**
+ * @brief Reconstructs the samples from their codes by concatenating the centroids they refer to.
+ *
+ * @param codes n_samples x n_subspaces row major codes
+ * @return std::vector<T> n_samples x n_features vectorized matrix
+ */
+template <typename T>
+std::vector<T> ProductQuantizer<T>::decode(const std::vector<CodeType>& codes) const {
+    const std::size_t n_samples = codes.size() / n_subspaces_;
+
+    auto samples = std::vector<T>(n_samples * n_features_);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        for (std::size_t subspace_index = 0; subspace_index < n_subspaces_; ++subspace_index) {
+            const auto centroid_first =
+                codebooks_.begin() +
+                (subspace_index * n_centroids_ + codes[sample_index * n_subspaces_ + subspace_index]) *
+                    n_subspace_features_;
+
+            std::copy(centroid_first,
+                      centroid_first + n_subspace_features_,
+                      samples.begin() + sample_index * n_features_ + subspace_index * n_subspace_features_);
+        }
+    }
+    return samples;
+}
+
+/**
+ * @brief Squared euclidean distances from each subvector of a query to the centroids of the codebook of its subspace.
+ *
+ * @tparam SamplesIterator
+ * @param query_first
+ * @param query_last
+ * @return std::vector<T> n_subspaces x n_centroids lookup table
+ */
+template <typename T>
+template <typename SamplesIterator>
+std::vector<T> ProductQuantizer<T>::distance_table(const SamplesIterator& query_first,
+                                                   const SamplesIterator& query_last) const {
+    if (static_cast<std::size_t>(std::distance(query_first, query_last)) != n_features_) {
+        throw std::invalid_argument("The query should have n_features features.");
+    }
+    auto table = std::vector<T>(n_subspaces_ * n_centroids_);
+
+    for (std::size_t subspace_index = 0; subspace_index < n_subspaces_; ++subspace_index) {
+        const auto subvector_first = query_first + subspace_index * n_subspace_features_;
+
+        for (std::size_t centroid_index = 0; centroid_index < n_centroids_; ++centroid_index) {
+            table[subspace_index * n_centroids_ + centroid_index] = heuristic::squared_euclidean_distance(
+                subvector_first,
+                subvector_first + n_subspace_features_,
+                codebooks_.begin() + (subspace_index * n_centroids_ + centroid_index) * n_subspace_features_);
+        }
+    }
+    return table;
+}
+
+/**
+ * @brief Asymmetric distance computation: approximate euclidean distances from a query to encoded samples. Each
+ * distance only costs n_subspaces lookups in the distance table of the query instead of n_features operations on the
+ * decoded sample.
+ *
+ * @tparam SamplesIterator
+ * @param query_first
+ * @param query_last
+ * @param codes n_samples x n_subspaces row major codes
+ * @return std::vector<T> n_samples distances from the query to the decoded samples
+ */
+template <typename T>
+template <typename SamplesIterator>
+std::vector<T> ProductQuantizer<T>::asymmetric_distances(const SamplesIterator&       query_first,
+                                                         const SamplesIterator&       query_last,
+                                                         const std::vector<CodeType>& codes) const {
+    const auto table = distance_table(query_first, query_last);
+
+    const std::size_t n_samples = codes.size() / n_subspaces_;
+
+    auto distances = std::vector<T>(n_samples);
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for schedule(static)
+#endif
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        const CodeType* sample_codes = codes.data() + sample_index * n_subspaces_;
+
+        T squared_distance = 0;
+
+        for (std::size_t subspace_index = 0; subspace_index < n_subspaces_; ++subspace_index) {
+            squared_distance += table[subspace_index * n_centroids_ + sample_codes[subspace_index]];
+        }
+        distances[sample_index] = std::sqrt(squared_distance);
+    }
+    return distances;
+}
+
+}  // namespace cpp_clustering
@@ -0,0 +1,516 @@
+#pragma once
+
+#include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/heuristics/Heuristics.hpp"
+#include "cpp_clustering/kmeans/KMeansPlusPlus.hpp"
+#include "cpp_clustering/kmeans/KMeansUtils.hpp"
+#include "cpp_clustering/kmeans/Lloyd.hpp"
+
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
+namespace cpp_clustering {
+
+/**
+ * @brief Yinyang k-means (group filtering) https://proceedings.mlr.press/v37/ding15.pdf
+ * The centroids are partitioned once into n_centroids / 10 groups with a small k-means over the centroids. Each sample
+ * keeps an upper bound to its assigned centroid and one lower bound per group. The memory is n_samples x n_groups
+ * instead of n_samples x n_centroids with Elkan, while still pruning most of the distances computations for large
+ * n_centroids.
+ *
+ * @tparam Iterator
+ */
+template <typename Iterator>
+class Yinyang {
+    static_assert(std::is_floating_point_v<typename Iterator::value_type>, "Yinyang allows floating point types.");
+
+  public:
+    using DataType = typename Iterator::value_type;
+
+    // {samples_first_, samples_last_, n_features_}
+    using DatasetDescriptorType = std::tuple<Iterator, Iterator, std::size_t>;
+
+    Yinyang(const DatasetDescriptorType& dataset_descriptor, const std::vector<DataType>& centroids);
+
+    Yinyang(const DatasetDescriptorType& dataset_descriptor,
+            const std::vector<DataType>& centroids,
+            const DataType&              loss);
+
+    Yinyang(const Yinyang&) = delete;
+
+    DataType total_deviation() const;
+
+    // total_deviation() is maintained from the upper bounds of the reassigned samples only. This recomputes the
+    // distances from all the samples to their assigned centroids
+    DataType exact_total_deviation() const;
+
+    const std::vector<DataType>& step();
+
+    DataType max_centroid_shift() const;
+
+  private:
+    struct Buffers {
+        Buffers(const Iterator&              samples_first,
+                const Iterator&              samples_last,
+                std::size_t                  n_features,
+                const std::vector<DataType>& centroids);
+
+        Buffers(const DatasetDescriptorType& dataset_descriptor, const std::vector<DataType>& centroids);
+
+        Buffers(const Buffers&) = delete;
+
+        void make_centroids_groups(const std::vector<DataType>& centroids, std::size_t n_features);
+
+        // the centroids indices sorted by group. The centroids of the group g are in the range
+        // [groups_offsets_[g], groups_offsets_[g + 1])
+        std::vector<std::size_t> groups_centroid_indices_;
+        std::vector<std::size_t> groups_offsets_;
+        std::vector<std::size_t> centroid_to_group_indices_;
+
+        std::vector<std::size_t> samples_to_nearest_centroid_indices_;
+        // upper bounds: distance from each sample to its assigned centroid
+        std::vector<DataType> samples_to_nearest_centroid_distances_;
+        // lower bounds: n_samples x n_groups distances from each sample to the nearest non assigned centroid of each
+        // group. They are stored w.r.t. the centroids before the last update and moved lazily in swap_bounds
+        std::vector<DataType> samples_to_groups_lower_bounds_;
+
+        std::vector<std::size_t> cluster_sizes_;
+        std::vector<DataType>    cluster_position_sums_;
+        // the centroids before the last update, overwritten at each step
+        std::vector<DataType> previous_centroids_;
+        std::vector<DataType> centroid_velocities_;
+        // the largest velocity of the centroids in each group
+        std::vector<DataType> group_velocities_;
+
+        // {sample_index, previous_assigned_centroid_index, previous_assigned_centroid_distance} for each sample that
+        // changed cluster during swap_bounds. One container per thread, filled in increasing sample_index order
+        std::vector<std::vector<std::tuple<std::size_t, std::size_t, DataType>>> samples_reassignments_;
+        // nearest and second nearest {distance or lower bound, centroid index} within each visited group of the sample
+        // being processed by swap_bounds. One container per thread
+        std::vector<std::vector<std::pair<DataType, std::size_t>>> groups_first_min_;
+        std::vector<std::vector<DataType>>                         groups_second_min_;
+        std::vector<std::vector<bool>>                             is_group_visited_;
+    };
+
+    void swap_bounds();
+
+    DataType update_bounds();
+
+    DatasetDescriptorType    dataset_descriptor_;
+    std::size_t              n_samples_;
+    std::vector<DataType>    centroids_;
+    std::unique_ptr<Buffers> buffers_ptr_;
+    DataType                 loss_;
+    // largest change of a centroid coordinate during the last step
+    DataType max_centroid_shift_;
+};
+
+template <typename Iterator>
+Yinyang<Iterator>::Yinyang(const DatasetDescriptorType& dataset_descriptor, const std::vector<DataType>& centroids)
+  : Yinyang<Iterator>::Yinyang(dataset_descriptor, centroids, common::utils::infinity<DataType>()) {
+    // compute initial loss
+    loss_ = std::reduce(buffers_ptr_->samples_to_nearest_centroid_distances_.begin(),
+                        buffers_ptr_->samples_to_nearest_centroid_distances_.end(),
+                        static_cast<typename Yinyang<Iterator>::DataType>(0),
+                        std::plus<>());
+}
+
+template <typename Iterator>
+Yinyang<Iterator>::Yinyang(const DatasetDescriptorType& dataset_descriptor,
+                           const std::vector<DataType>& centroids,
+                           const DataType&              loss)
+  : dataset_descriptor_{dataset_descriptor}
+  , n_samples_{common::utils::get_n_samples(std::get<0>(dataset_descriptor_),
+                                            std::get<1>(dataset_descriptor_),
+                                            std::get<2>(dataset_descriptor_))}
+  , centroids_{centroids}
+  , buffers_ptr_{std::make_unique<Buffers>(dataset_descriptor, centroids_)}
+  , loss_{loss}
+  , max_centroid_shift_{common::utils::infinity<DataType>()} {}
+
+template <typename Iterator>
+typename Yinyang<Iterator>::DataType Yinyang<Iterator>::total_deviation() const {
+    return loss_;
+}
+
+template <typename Iterator>
+typename Yinyang<Iterator>::DataType Yinyang<Iterator>::exact_total_deviation() const {
+    const auto [samples_first, samples_last, n_features] = dataset_descriptor_;
+
+    return kmeans::utils::assigned_centroids_distances_sum(samples_first,
+                                                           samples_last,
+                                                           n_features,
+                                                           centroids_,
+                                                           buffers_ptr_->samples_to_nearest_centroid_indices_.begin());
+}
+
+template <typename Iterator>
+const std::vector<typename Yinyang<Iterator>::DataType>& Yinyang<Iterator>::step() {
+    // iterate over all the samples and swap the lower and upper bounds only if necessary
+    swap_bounds();
+
+    // keep a copy of the current non updated centroids in a buffer that is reused from one step to the next
+    std::copy(centroids_.begin(), centroids_.end(), buffers_ptr_->previous_centroids_.begin());
+
+    // update all the centroids with the new intra-cluster positions sum and cluster sizes
+    kmeans::utils::update_centroids(buffers_ptr_->cluster_sizes_,
+                                    buffers_ptr_->cluster_position_sums_,
+                                    std::get<2>(dataset_descriptor_),
+                                    centroids_);
+
+    // upate the centroids velocities based on the previous centroids and the updated centroids
+    max_centroid_shift_ = kmeans::utils::update_centroids_velocities(buffers_ptr_->previous_centroids_,
+                                                                     centroids_,
+                                                                     std::get<2>(dataset_descriptor_),
+                                                                     buffers_ptr_->centroid_velocities_);
+
+    // recompute the loss w.r.t. the updated buffers
+    loss_ = update_bounds();
+
+    return centroids_;
+}
+
+template <typename Iterator>
+typename Yinyang<Iterator>::DataType Yinyang<Iterator>::max_centroid_shift() const {
+    return max_centroid_shift_;
+}
+
+template <typename Iterator>
+void Yinyang<Iterator>::swap_bounds() {
+    auto& samples_to_nearest_centroid_indices   = buffers_ptr_->samples_to_nearest_centroid_indices_;
+    auto& samples_to_nearest_centroid_distances = buffers_ptr_->samples_to_nearest_centroid_distances_;
+    auto& samples_to_groups_lower_bounds        = buffers_ptr_->samples_to_groups_lower_bounds_;
+
+    const auto& groups_centroid_indices   = buffers_ptr_->groups_centroid_indices_;
+    const auto& groups_offsets            = buffers_ptr_->groups_offsets_;
+    const auto& centroid_to_group_indices = buffers_ptr_->centroid_to_group_indices_;
+    const auto& centroid_velocities       = buffers_ptr_->centroid_velocities_;
+    const auto& group_velocities          = buffers_ptr_->group_velocities_;
+
+    auto& samples_reassignments = buffers_ptr_->samples_reassignments_;
+
+    const auto [samples_first, samples_last, n_features] = dataset_descriptor_;
+
+    const std::size_t n_groups = group_velocities.size();
+
+    auto& threads_groups_first_min  = buffers_ptr_->groups_first_min_;
+    auto& threads_groups_second_min = buffers_ptr_->groups_second_min_;
+    auto& threads_is_group_visited  = buffers_ptr_->is_group_visited_;
+
+    kmeans::utils::reset_samples_reassignments(samples_reassignments);
+
+    // the buffers only need to grow if the number of threads has been raised since they were made
+    if (threads_groups_first_min.size() < samples_reassignments.size()) {
+        threads_groups_first_min.resize(samples_reassignments.size(),
+                                        std::vector<std::pair<DataType, std::size_t>>(n_groups));
+        threads_groups_second_min.resize(samples_reassignments.size(), std::vector<DataType>(n_groups));
+        threads_is_group_visited.resize(samples_reassignments.size(), std::vector<bool>(n_groups));
+    }
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel
+#endif
+    {
+#if defined(_OPENMP) && THREADS_ENABLED == true
+        const auto thread_index = omp_get_thread_num();
+#else
+        const auto thread_index = 0;
+#endif
+        auto& thread_samples_reassignments = samples_reassignments[thread_index];
+        // nearest and second nearest {distance or lower bound, centroid index} within each visited group
+        auto& groups_first_min  = threads_groups_first_min[thread_index];
+        auto& groups_second_min = threads_groups_second_min[thread_index];
+        auto& is_group_visited  = threads_is_group_visited[thread_index];
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp for schedule(static)
+#endif
+        for (std::size_t sample_index = 0; sample_index < n_samples_; ++sample_index) {
+            auto lower_bounds_first = samples_to_groups_lower_bounds.begin() + sample_index * n_groups;
+
+            // global filtering: compare the upper bound to the smallest of the moved groups lower bounds
+            auto global_lower_bound = common::utils::infinity<DataType>();
+
+            for (std::size_t group_index = 0; group_index < n_groups; ++group_index) {
+                global_lower_bound =
+                    std::min(global_lower_bound, lower_bounds_first[group_index] - group_velocities[group_index]);
+            }
+            const auto previous_assigned_centroid_index    = samples_to_nearest_centroid_indices[sample_index];
+            const auto previous_assigned_centroid_distance = samples_to_nearest_centroid_distances[sample_index];
+
+            auto upper_bound = samples_to_nearest_centroid_distances[sample_index];
+
+            if (upper_bound > global_lower_bound) {
+                // tighten upper bound
+                upper_bound = cpp_clustering::heuristic::heuristic(
+                    samples_first + sample_index * n_features,
+                    samples_first + sample_index * n_features + n_features,
+                    centroids_.begin() + previous_assigned_centroid_index * n_features);
+
+                samples_to_nearest_centroid_distances[sample_index] = upper_bound;
+            }
+            if (upper_bound <= global_lower_bound) {
+                // the sample keeps its centroid, only the lower bounds need to be moved
+                for (std::size_t group_index = 0; group_index < n_groups; ++group_index) {
+                    lower_bounds_first[group_index] -= group_velocities[group_index];
+                }
+                continue;
+            }
+            std::fill(is_group_visited.begin(), is_group_visited.end(), false);
+
+            auto assigned_centroid_index = previous_assigned_centroid_index;
+
+            for (std::size_t group_index = 0; group_index < n_groups; ++group_index) {
+                const auto previous_group_lower_bound = lower_bounds_first[group_index];
+                // group filtering
+                if (previous_group_lower_bound - group_velocities[group_index] >= upper_bound) {
+                    lower_bounds_first[group_index] = previous_group_lower_bound - group_velocities[group_index];
+                    continue;
+                }
+                is_group_visited[group_index] = true;
+
+                auto& [group_first_min_distance, group_first_min_index] = groups_first_min[group_index];
+                auto& group_second_min_distance                         = groups_second_min[group_index];
+
+                group_first_min_distance  = common::utils::infinity<DataType>();
+                group_first_min_index     = 0;
+                group_second_min_distance = common::utils::infinity<DataType>();
+
+                for (std::size_t group_centroid_index = groups_offsets[group_index];
+                     group_centroid_index < groups_offsets[group_index + 1];
+                     ++group_centroid_index) {
+                    const auto centroid_index = groups_centroid_indices[group_centroid_index];
+
+                    DataType nearest_candidate = 0;
+
+                    if (centroid_index == previous_assigned_centroid_index) {
+                        // the upper bound has been tightened to the exact distance already
+                        nearest_candidate = samples_to_nearest_centroid_distances[sample_index];
+
+                    } else if (previous_group_lower_bound - centroid_velocities[centroid_index] >= upper_bound) {
+                        // local filtering: the moved group lower bound of this centroid is still a valid lower bound
+                        nearest_candidate = previous_group_lower_bound - centroid_velocities[centroid_index];
+
+                    } else {
+                        nearest_candidate =
+                            cpp_clustering::heuristic::heuristic(samples_first + sample_index * n_features,
+                                                                 samples_first + sample_index * n_features + n_features,
+                                                                 centroids_.begin() + centroid_index * n_features);
+
+                        // if another center is closer than the current assignment
+                        if (nearest_candidate < upper_bound) {
+                            upper_bound             = nearest_candidate;
+                            assigned_centroid_index = centroid_index;
+                        }
+                    }
+                    if (nearest_candidate < group_first_min_distance) {
+                        group_second_min_distance = group_first_min_distance;
+                        group_first_min_distance  = nearest_candidate;
+                        group_first_min_index     = centroid_index;
+
+                    } else if (nearest_candidate < group_second_min_distance) {
+                        group_second_min_distance = nearest_candidate;
+                    }
+                }
+            }
+            // the new lower bound of a visited group is its nearest centroid unless it's the assigned centroid
+            for (std::size_t group_index = 0; group_index < n_groups; ++group_index) {
+                if (is_group_visited[group_index]) {
+                    const auto& [group_first_min_distance, group_first_min_index] = groups_first_min[group_index];
+
+                    lower_bounds_first[group_index] = (group_first_min_index == assigned_centroid_index)
+                                                          ? groups_second_min[group_index]
+                                                          : group_first_min_distance;
+                }
+            }
+            samples_to_nearest_centroid_distances[sample_index] = upper_bound;
+
+            // if the assignment for sample_index has changed
+            if (assigned_centroid_index != previous_assigned_centroid_index) {
+                const auto previous_group_index = centroid_to_group_indices[previous_assigned_centroid_index];
+                // the previous centroid was not accounted for in the lower bound of a group that was not visited
+                if (!is_group_visited[previous_group_index]) {
+                    lower_bounds_first[previous_group_index] = std::min(
+                        lower_bounds_first[previous_group_index], samples_to_nearest_centroid_distances[sample_index]);
+                }
+                thread_samples_reassignments.emplace_back(
+                    sample_index, previous_assigned_centroid_index, previous_assigned_centroid_distance);
+
+                samples_to_nearest_centroid_indices[sample_index] = assigned_centroid_index;
+            }
+        }
+    }
+    loss_ += kmeans::utils::merge_samples_reassignments(samples_first,
+                                                        n_features,
+                                                        samples_reassignments,
+                                                        samples_to_nearest_centroid_indices,
+                                                        samples_to_nearest_centroid_distances,
+                                                        buffers_ptr_->cluster_sizes_,
+                                                        buffers_ptr_->cluster_position_sums_);
+}
+
+template <typename Iterator>
+typename Iterator::value_type Yinyang<Iterator>::update_bounds() {
+    const auto& samples_to_nearest_centroid_indices   = buffers_ptr_->samples_to_nearest_centroid_indices_;
+    auto&       samples_to_nearest_centroid_distances = buffers_ptr_->samples_to_nearest_centroid_distances_;
+    const auto& centroid_velocities                   = buffers_ptr_->centroid_velocities_;
+    const auto& centroid_to_group_indices             = buffers_ptr_->centroid_to_group_indices_;
+    auto&       group_velocities                      = buffers_ptr_->group_velocities_;
+
+    // a group moves at most as much as its fastest centroid
+    std::fill(group_velocities.begin(), group_velocities.end(), static_cast<DataType>(0));
+
+    for (std::size_t centroid_index = 0; centroid_index < centroid_velocities.size(); ++centroid_index) {
+        auto& group_velocity = group_velocities[centroid_to_group_indices[centroid_index]];
+
+        group_velocity = std::max(group_velocity, centroid_velocities[centroid_index]);
+    }
+    // move the upper bound by the same distance its assigned centroid has moved. The lower bounds are moved in
+    // swap_bounds where the previous values are still needed for the local filtering
+    for (std::size_t sample_index = 0; sample_index < n_samples_; ++sample_index) {
+        samples_to_nearest_centroid_distances[sample_index] +=
+            centroid_velocities[samples_to_nearest_centroid_indices[sample_index]];
+    }
+    return loss_;
+}
+
+template <typename Iterator>
+void Yinyang<Iterator>::Buffers::make_centroids_groups(const std::vector<DataType>& centroids, std::size_t n_features) {
+    using CentroidsIterator = typename std::vector<DataType>::const_iterator;
+
+    const std::size_t n_centroids = centroids.size() / n_features;
+    // the number of groups recommended by the authors
+    const std::size_t n_groups = std::max(static_cast<std::size_t>(1), n_centroids / 10);
+
+    auto centroids_groups_labels = std::vector<std::size_t>(n_centroids);
+
+    if (n_groups > 1) {
+        // group the centroids with a few iterations of lloyd over the centroids
+        auto groups_centroids =
+            kmeansplusplus::make_centroids(centroids.cbegin(), centroids.cend(), n_groups, n_features);
+
+        auto lloyd = Lloyd<CentroidsIterator>({centroids.cbegin(), centroids.cend(), n_features}, groups_centroids);
+
+        for (std::size_t iter = 0; iter < 5; ++iter) {
+            groups_centroids = lloyd.step();
+        }
+        centroids_groups_labels = kmeans::utils::samples_to_nearest_centroid_indices(
+            centroids.cbegin(), centroids.cend(), n_features, groups_centroids);
+    }
+    // remove the empty groups by remapping the labels to a contiguous range
+    auto groups_sizes  = kmeans::utils::compute_cluster_sizes(centroids_groups_labels.begin(),
+                                                             centroids_groups_labels.end(),
+                                                             n_groups);
+    auto groups_remaps = std::vector<std::size_t>(n_groups);
+
+    std::size_t n_non_empty_groups = 0;
+    for (std::size_t group_index = 0; group_index < n_groups; ++group_index) {
+        groups_remaps[group_index] = n_non_empty_groups;
+
+        if (groups_sizes[group_index]) {
+            groups_sizes[n_non_empty_groups++] = groups_sizes[group_index];
+        }
+    }
+    groups_sizes.resize(n_non_empty_groups);
+
+    centroid_to_group_indices_ = std::vector<std::size_t>(n_centroids);
+    std::transform(centroids_groups_labels.begin(),
+                   centroids_groups_labels.end(),
+                   centroid_to_group_indices_.begin(),
+                   [&groups_remaps](const auto& group_label) { return groups_remaps[group_label]; });
+
+    groups_offsets_ = std::vector<std::size_t>(n_non_empty_groups + 1);
+    std::partial_sum(groups_sizes.begin(), groups_sizes.end(), groups_offsets_.begin() + 1);
+
+    // counting sort of the centroids indices w.r.t. their group
+    groups_centroid_indices_ = std::vector<std::size_t>(n_centroids);
+
+    auto groups_fill_positions = groups_offsets_;
+    for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+        groups_centroid_indices_[groups_fill_positions[centroid_to_group_indices_[centroid_index]]++] = centroid_index;
+    }
+    group_velocities_ = std::vector<DataType>(n_non_empty_groups);
+}
+
+template <typename Iterator>
+Yinyang<Iterator>::Buffers::Buffers(const Iterator&                                          samples_first,
+                                    const Iterator&                                          samples_last,
+                                    std::size_t                                              n_features,
+                                    const std::vector<typename Yinyang<Iterator>::DataType>& centroids)
+  : samples_to_nearest_centroid_indices_{std::vector<std::size_t>(
+        common::utils::get_n_samples(samples_first, samples_last, n_features))}
+  , samples_to_nearest_centroid_distances_{std::vector<DataType>(samples_to_nearest_centroid_indices_.size())}
+  , previous_centroids_{std::vector<DataType>(centroids.size())}
+  , centroid_velocities_{std::vector<DataType>(centroids.size() / n_features)}
+  , samples_reassignments_{std::vector<std::vector<std::tuple<std::size_t, std::size_t, DataType>>>(
+        kmeans::utils::max_n_threads())} {
+    make_centroids_groups(centroids, n_features);
+
+    const std::size_t n_samples   = samples_to_nearest_centroid_indices_.size();
+    const std::size_t n_centroids = centroids.size() / n_features;
+    const std::size_t n_groups    = group_velocities_.size();
+
+    groups_first_min_ = std::vector<std::vector<std::pair<DataType, std::size_t>>>(
+        samples_reassignments_.size(), std::vector<std::pair<DataType, std::size_t>>(n_groups));
+    groups_second_min_ =
+        std::vector<std::vector<DataType>>(samples_reassignments_.size(), std::vector<DataType>(n_groups));
+    is_group_visited_ = std::vector<std::vector<bool>>(samples_reassignments_.size(), std::vector<bool>(n_groups));
+
+    samples_to_groups_lower_bounds_ = std::vector<DataType>(n_samples * n_groups);
+
+    kmeans::utils::samples_to_nearest_centroid_indices_and_distances(samples_first,
+                                                                     samples_last,
+                                                                     n_features,
+                                                                     centroids,
+                                                                     samples_to_nearest_centroid_indices_.begin(),
+                                                                     samples_to_nearest_centroid_distances_.begin());
+
+    // the lower bounds start as the exact distances to the nearest non assigned centroid of each group
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for
+#endif
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        const auto assigned_centroid_index = samples_to_nearest_centroid_indices_[sample_index];
+
+        auto lower_bounds_first = samples_to_groups_lower_bounds_.begin() + sample_index * n_groups;
+
+        for (std::size_t group_index = 0; group_index < n_groups; ++group_index) {
+            auto group_min_distance = common::utils::infinity<DataType>();
+
+            for (std::size_t group_centroid_index = groups_offsets_[group_index];
+                 group_centroid_index < groups_offsets_[group_index + 1];
+                 ++group_centroid_index) {
+                const auto centroid_index = groups_centroid_indices_[group_centroid_index];
+
+                if (centroid_index != assigned_centroid_index) {
+                    group_min_distance = std::min(
+                        group_min_distance,
+                        cpp_clustering::heuristic::heuristic(samples_first + sample_index * n_features,
+                                                             samples_first + sample_index * n_features + n_features,
+                                                             centroids.begin() + centroid_index * n_features));
+                }
+            }
+            lower_bounds_first[group_index] = group_min_distance;
+        }
+    }
+    cluster_sizes_ = kmeans::utils::compute_cluster_sizes(
+        samples_to_nearest_centroid_indices_.begin(), samples_to_nearest_centroid_indices_.end(), n_centroids);
+
+    cluster_position_sums_ = kmeans::utils::compute_cluster_positions_sum(
+        samples_first, samples_last, samples_to_nearest_centroid_indices_.begin(), n_centroids, n_features);
+}
+
+template <typename Iterator>
+Yinyang<Iterator>::Buffers::Buffers(const DatasetDescriptorType&                             dataset_descriptor,
+                                    const std::vector<typename Yinyang<Iterator>::DataType>& centroids)
+  : Yinyang<Iterator>::Buffers::Buffers(std::get<0>(dataset_descriptor),
+                                        std::get<1>(dataset_descriptor),
+                                        std::get<2>(dataset_descriptor),
+                                        centroids) {}
+
+}  // namespace cpp_clustering
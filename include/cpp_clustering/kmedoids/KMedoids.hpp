@@ -1,6 +1,8 @@
 #pragma once
 
 #include "cpp_clustering/common/Utils.hpp"
+#include "cpp_clustering/containers/Dataset.hpp"
+#include "cpp_clustering/containers/DatasetHandle.hpp"
 #include "cpp_clustering/containers/LowerTriangleMatrix.hpp"
 #include "cpp_clustering/heuristics/Heuristics.hpp"
 #include "cpp_clustering/math/random/Distributions.hpp"
@@ -16,6 +18,7 @@
 #include <limits>
 #include <memory>
 #include <numeric>
+#include <stdexcept>
 #include <tuple>
 #include <vector>
 
@@ -45,11 +48,18 @@ class KMedoids {
             return *this;
         }
 
+        // run the n_init candidates in lockstep and stop the ones that cant reach the lowest loss anymore
+        Options& racing(bool racing) {
+            racing_ = racing;
+            return *this;
+        }
+
         Options& operator=(const Options& options) {
             max_iter_       = options.max_iter_;
             early_stopping_ = options.early_stopping_;
             patience_       = options.patience_;
             n_init_         = options.n_init_;
+            racing_         = options.racing_;
             return *this;
         }
 
@@ -57,6 +67,7 @@ class KMedoids {
         bool        early_stopping_ = true;
         std::size_t patience_       = 0;
         std::size_t n_init_         = 1;
+        bool        racing_         = false;
     };
 
     KMedoids(std::size_t n_medoids, std::size_t n_features);
@@ -80,6 +91,17 @@ class KMedoids {
     template <typename SamplesIterator>
     std::vector<std::size_t> fit(const SamplesIterator& data_first, const SamplesIterator& data_last);
 
+    template <template <typename> class KMedoidsAlgorithm, typename SamplesIterator>
+    std::vector<std::size_t> fit(const cpp_clustering::containers::DatasetHandle<SamplesIterator>& dataset);
+
+    template <typename SamplesIterator>
+    std::vector<std::size_t> fit(const cpp_clustering::containers::DatasetHandle<SamplesIterator>& dataset);
+
+    template <template <typename> class KMedoidsAlgorithm>
+    std::vector<std::size_t> fit(const cpp_clustering::containers::Dataset<T>& dataset);
+
+    std::vector<std::size_t> fit(const cpp_clustering::containers::Dataset<T>& dataset);
+
     template <template <typename> class KMedoidsAlgorithm, typename SamplesIterator>
     std::vector<std::size_t> fit(
         const cpp_clustering::containers::LowerTriangleMatrix<SamplesIterator>& pairwise_distance_matrix);
@@ -102,6 +124,12 @@ class KMedoids {
     std::vector<std::size_t> predict(
         const cpp_clustering::containers::LowerTriangleMatrix<SamplesIterator>& pairwise_distance_matrix) const;
 
+    template <typename SamplesIterator>
+    std::vector<std::size_t> predict(
+        const cpp_clustering::containers::DatasetHandle<SamplesIterator>& dataset) const;
+
+    std::vector<std::size_t> predict(const cpp_clustering::containers::Dataset<T>& dataset) const;
+
   private:
     // number of medoids that a KMedoids instance should handle (could vary)
     std::size_t n_medoids_;
@@ -191,6 +219,34 @@ std::vector<std::size_t> KMedoids<T, PrecomputePairwiseDistanceMatrix>::fit(cons
         pairwise_distance_matrix_ptr =
             std::make_unique<cpp_clustering::containers::LowerTriangleMatrix<SamplesIterator>>(dataset_descriptor);
     }
+    if (options_.racing_ && medoids_candidates.size() > 1) {
+        auto kmedoids_algorithms =
+            std::vector<std::unique_ptr<KMedoidsAlgorithm<SamplesIterator>>>(medoids_candidates.size());
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for
+#endif
+        for (std::size_t k = 0; k < medoids_candidates.size(); ++k) {
+            if constexpr (PrecomputePairwiseDistanceMatrix) {
+                kmedoids_algorithms[k] = std::make_unique<KMedoidsAlgorithm<SamplesIterator>>(
+                    *pairwise_distance_matrix_ptr, medoids_candidates[k]);
+            } else {
+                kmedoids_algorithms[k] =
+                    std::make_unique<KMedoidsAlgorithm<SamplesIterator>>(dataset_descriptor, medoids_candidates[k]);
+            }
+        }
+        const auto candidates_losses = common::utils::race_candidates(kmedoids_algorithms,
+                                                                      medoids_candidates,
+                                                                      options_.max_iter_,
+                                                                      options_.early_stopping_,
+                                                                      options_.patience_);
+
+        const std::size_t min_loss_index = common::utils::argmin(candidates_losses.begin(), candidates_losses.end());
+
+        medoids_ = medoids_candidates[min_loss_index];
+
+        return medoids_;
+    }
 #if defined(_OPENMP) && THREADS_ENABLED == true
 #pragma omp parallel for
 #endif
@@ -248,6 +304,50 @@ std::vector<std::size_t> KMedoids<T, PrecomputePairwiseDistanceMatrix>::fit(cons
     return fit<cpp_clustering::FasterPAM>(data_first, data_last);
 }
 
+template <typename T, bool PrecomputePairwiseDistanceMatrix>
+template <template <typename> class KMedoidsAlgorithm, typename SamplesIterator>
+std::vector<std::size_t> KMedoids<T, PrecomputePairwiseDistanceMatrix>::fit(
+    const cpp_clustering::containers::DatasetHandle<SamplesIterator>& dataset) {
+    if (dataset.n_features() != n_features_) {
+        throw std::invalid_argument("The dataset should have the same number of features as the KMedoids instance.");
+    }
+    return fit<KMedoidsAlgorithm>(dataset.samples_first(), dataset.samples_last());
+}
+
+template <typename T, bool PrecomputePairwiseDistanceMatrix>
+template <typename SamplesIterator>
+std::vector<std::size_t> KMedoids<T, PrecomputePairwiseDistanceMatrix>::fit(
+    const cpp_clustering::containers::DatasetHandle<SamplesIterator>& dataset) {
+    // execute fit function with a default PAM algorithm
+    return fit<cpp_clustering::FasterPAM>(dataset);
+}
+
+/**
+ * @brief Fits the medoids on the aligned and padded rows of a Dataset. The padding features are null for all the
+ * samples so the distances between the padded rows are the same as between the original ones.
+ */
+template <typename T, bool PrecomputePairwiseDistanceMatrix>
+template <template <typename> class KMedoidsAlgorithm>
+std::vector<std::size_t> KMedoids<T, PrecomputePairwiseDistanceMatrix>::fit(
+    const cpp_clustering::containers::Dataset<T>& dataset) {
+    if (dataset.n_features() != n_features_) {
+        throw std::invalid_argument("The dataset should have the same number of features as the KMedoids instance.");
+    }
+    auto padded_kmedoids =
+        KMedoids<T, PrecomputePairwiseDistanceMatrix>(n_medoids_, dataset.padded_n_features(), medoids_, options_);
+
+    medoids_ = padded_kmedoids.template fit<KMedoidsAlgorithm>(dataset.view());
+
+    return medoids_;
+}
+
+template <typename T, bool PrecomputePairwiseDistanceMatrix>
+std::vector<std::size_t> KMedoids<T, PrecomputePairwiseDistanceMatrix>::fit(
+    const cpp_clustering::containers::Dataset<T>& dataset) {
+    // execute fit function with a default PAM algorithm
+    return fit<cpp_clustering::FasterPAM>(dataset);
+}
+
 template <typename T, bool PrecomputePairwiseDistanceMatrix>
 template <template <typename> class KMedoidsAlgorithm, typename SamplesIterator>
 std::vector<std::size_t> KMedoids<T, PrecomputePairwiseDistanceMatrix>::fit(
@@ -278,6 +378,30 @@ std::vector<std::size_t> KMedoids<T, PrecomputePairwiseDistanceMatrix>::fit(
     // need to initialize with vectors of infinities because
     auto medoids_candidates_prev = std::vector<std::vector<std::size_t>>(medoids_candidates.size());
 
+    if (options_.racing_ && medoids_candidates.size() > 1) {
+        auto kmedoids_algorithms =
+            std::vector<std::unique_ptr<KMedoidsAlgorithm<SamplesIterator>>>(medoids_candidates.size());
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#pragma omp parallel for
+#endif
+        for (std::size_t k = 0; k < medoids_candidates.size(); ++k) {
+            kmedoids_algorithms[k] =
+                std::make_unique<KMedoidsAlgorithm<SamplesIterator>>(pairwise_distance_matrix, medoids_candidates[k]);
+        }
+        const auto candidates_losses = common::utils::race_candidates(kmedoids_algorithms,
+                                                                      medoids_candidates,
+                                                                      options_.max_iter_,
+                                                                      options_.early_stopping_,
+                                                                      options_.patience_);
+
+        const std::size_t min_loss_index = common::utils::argmin(candidates_losses.begin(), candidates_losses.end());
+
+        medoids_ = medoids_candidates[min_loss_index];
+
+        return medoids_;
+    }
+
 #if defined(_OPENMP) && THREADS_ENABLED == true
 #pragma omp parallel for
 #endif
@@ -361,4 +485,24 @@ std::vector<std::size_t> KMedoids<T, PrecomputePairwiseDistanceMatrix>::predict(
     return pam::utils::samples_to_nearest_medoid_indices(pairwise_distance_matrix, medoids_);
 }
 
+template <typename T, bool PrecomputePairwiseDistanceMatrix>
+template <typename SamplesIterator>
+std::vector<std::size_t> KMedoids<T, PrecomputePairwiseDistanceMatrix>::predict(
+    const cpp_clustering::containers::DatasetHandle<SamplesIterator>& dataset) const {
+    if (dataset.n_features() != n_features_) {
+        throw std::invalid_argument("The dataset should have the same number of features as the KMedoids instance.");
+    }
+    return predict(dataset.samples_first(), dataset.samples_last());
+}
+
+template <typename T, bool PrecomputePairwiseDistanceMatrix>
+std::vector<std::size_t> KMedoids<T, PrecomputePairwiseDistanceMatrix>::predict(
+    const cpp_clustering::containers::Dataset<T>& dataset) const {
+    if (dataset.n_features() != n_features_) {
+        throw std::invalid_argument("The dataset should have the same number of features as the KMedoids instance.");
+    }
+    return pam::utils::samples_to_nth_nearest_medoid_indices(
+        dataset.begin(), dataset.end(), dataset.padded_n_features(), medoids_);
+}
+
 }  // namespace cpp_clustering
@@ -37,6 +37,24 @@ auto division(const T& a, const U& b) {
     return a / b;
 };
 
+template <typename Iterator>
+std::vector<typename Iterator::value_type> medoids_to_centroids(const Iterator&                 data_first,
+                                                                const Iterator&                 data_last,
+                                                                std::size_t                     n_features,
+                                                                const std::vector<std::size_t>& medoids) {
+    const auto n_medoids = medoids.size();
+    auto       clusters  = std::vector<typename Iterator::value_type>(n_medoids * n_features);
+
+    for (std::size_t k = 0; k < n_medoids; ++k) {
+        const std::size_t data_index = medoids[k];
+
+        std::copy(data_first + data_index * n_features,
+                  data_first + data_index * n_features + n_features,
+                  clusters.begin() + k * n_features);
+    }
+    return clusters;
+}
+
 template <typename Iterator>
 std::vector<std::size_t> samples_to_nearest_medoid_indices(const Iterator&                 samples_first,
                                                            const Iterator&                 samples_last,
@@ -52,19 +70,24 @@ std::vector<std::size_t> samples_to_nearest_medoid_indices(const Iterator&
     // the vector that will contain the indices from each sample to the nearest medoid
     auto nearest_medoid_indices = std::vector<std::size_t>(n_samples);
 
-    auto compute_distance = [&](std::size_t left_idx, std::size_t right_idx) -> DataType {
-        return cpp_clustering::heuristic::heuristic(
-            /*first medoid begin=*/samples_first + left_idx * n_features,
-            /*first medoid end=*/samples_first + left_idx * n_features + n_features,
-            /*current sample begin=*/samples_first + right_idx * n_features);
-    };
+    // the medoids next to each other so that the distances from a sample to all of them are computed in one batch
+    const auto medoids_features = medoids_to_centroids(samples_first, samples_last, n_features, medoids);
+    // the distances from the current sample to each medoid
+    auto sample_to_medoids_distances = std::vector<DataType>(medoids.size());
     // iterate over all the samples
     for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        cpp_clustering::heuristic::heuristic_one_to_many(
+            /*current sample begin=*/samples_first + sample_index * n_features,
+            /*current sample end=*/samples_first + sample_index * n_features + n_features,
+            /*medoids begin=*/medoids_features.begin(),
+            /*medoids end=*/medoids_features.end(),
+            /*distances begin=*/sample_to_medoids_distances.begin());
+
         DataType    first_min_distance = std::numeric_limits<DataType>::max();
         std::size_t first_min_index    = 0;
 
         for (std::size_t idx = 0; idx < medoids.size(); ++idx) {
-            const auto nearest_candidate = compute_distance(medoids[idx], sample_index);
+            const auto nearest_candidate = sample_to_medoids_distances[idx];
 
             if (nearest_candidate < first_min_distance) {
                 first_min_distance = nearest_candidate;
@@ -124,21 +147,26 @@ std::vector<std::size_t> samples_to_second_nearest_medoid_indices(const Iterator
     // the vector that will contain the indices from each sample to the second nearest medoid
     auto second_nearest_medoid_indices = std::vector<std::size_t>(n_samples);
 
-    auto compute_distance = [&](std::size_t left_idx, std::size_t right_idx) -> DataType {
-        return cpp_clustering::heuristic::heuristic(
-            /*first medoid begin=*/samples_first + left_idx * n_features,
-            /*first medoid end=*/samples_first + left_idx * n_features + n_features,
-            /*current sample begin=*/samples_first + right_idx * n_features);
-    };
+    // the medoids next to each other so that the distances from a sample to all of them are computed in one batch
+    const auto medoids_features = medoids_to_centroids(samples_first, samples_last, n_features, medoids);
+    // the distances from the current sample to each medoid
+    auto sample_to_medoids_distances = std::vector<DataType>(medoids.size());
     // iterate over all the samples
     for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        cpp_clustering::heuristic::heuristic_one_to_many(
+            /*current sample begin=*/samples_first + sample_index * n_features,
+            /*current sample end=*/samples_first + sample_index * n_features + n_features,
+            /*medoids begin=*/medoids_features.begin(),
+            /*medoids end=*/medoids_features.end(),
+            /*distances begin=*/sample_to_medoids_distances.begin());
+
         DataType    first_min_distance  = std::numeric_limits<DataType>::max();
         DataType    second_min_distance = std::numeric_limits<DataType>::max();
         std::size_t first_min_index     = 0;
         std::size_t second_min_index    = 0;
 
         for (std::size_t idx = 0; idx < medoids.size(); ++idx) {
-            const auto second_nearest_candidate = compute_distance(medoids[idx], sample_index);
+            const auto second_nearest_candidate = sample_to_medoids_distances[idx];
 
             if (second_nearest_candidate < first_min_distance) {
                 second_min_distance = first_min_distance;
@@ -215,14 +243,19 @@ std::vector<std::size_t> samples_to_third_nearest_medoid_indices(const Iterator&
     // the vector that will contain the indices from each sample to the third nearest medoid
     auto third_nearest_medoid_indices = std::vector<std::size_t>(n_samples);
 
-    auto compute_distance = [&](std::size_t left_idx, std::size_t right_idx) -> DataType {
-        return cpp_clustering::heuristic::heuristic(
-            /*first medoid begin=*/samples_first + left_idx * n_features,
-            /*first medoid end=*/samples_first + left_idx * n_features + n_features,
-            /*current sample begin=*/samples_first + right_idx * n_features);
-    };
+    // the medoids next to each other so that the distances from a sample to all of them are computed in one batch
+    const auto medoids_features = medoids_to_centroids(samples_first, samples_last, n_features, medoids);
+    // the distances from the current sample to each medoid
+    auto sample_to_medoids_distances = std::vector<DataType>(medoids.size());
     // iterate over all the samples
     for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        cpp_clustering::heuristic::heuristic_one_to_many(
+            /*current sample begin=*/samples_first + sample_index * n_features,
+            /*current sample end=*/samples_first + sample_index * n_features + n_features,
+            /*medoids begin=*/medoids_features.begin(),
+            /*medoids end=*/medoids_features.end(),
+            /*distances begin=*/sample_to_medoids_distances.begin());
+
         DataType    first_min_distance  = std::numeric_limits<DataType>::max();
         DataType    second_min_distance = std::numeric_limits<DataType>::max();
         DataType    third_min_distance  = std::numeric_limits<DataType>::max();
@@ -231,7 +264,7 @@ std::vector<std::size_t> samples_to_third_nearest_medoid_indices(const Iterator&
         std::size_t third_min_index     = 0;
 
         for (std::size_t idx = 0; idx < medoids.size(); ++idx) {
-            const auto third_nearest_candidate = compute_distance(medoids[idx], sample_index);
+            const auto third_nearest_candidate = sample_to_medoids_distances[idx];
 
             if (third_nearest_candidate < first_min_distance) {
                 third_min_distance  = second_min_distance;
@@ -380,18 +413,22 @@ std::vector<typename Iterator::value_type> samples_to_nearest_medoid_distances(
     // the vector that will contain the distances from each sample to the nearest medoid
     auto nearest_medoid_distances = std::vector<DataType>(n_samples);
 
-    auto compute_distance = [&](std::size_t left_idx, std::size_t right_idx) -> DataType {
-        return cpp_clustering::heuristic::heuristic(
-            /*first medoid begin=*/samples_first + left_idx * n_features,
-            /*first medoid end=*/samples_first + left_idx * n_features + n_features,
-            /*current sample begin=*/samples_first + right_idx * n_features);
-    };
+    // the medoids next to each other so that the distances from a sample to all of them are computed in one batch
+    const auto medoids_features = medoids_to_centroids(samples_first, samples_last, n_features, medoids);
+    // the distances from the current sample to each medoid
+    auto sample_to_medoids_distances = std::vector<DataType>(medoids.size());
     // iterate over all the samples
     for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        cpp_clustering::heuristic::heuristic_one_to_many(
+            /*current sample begin=*/samples_first + sample_index * n_features,
+            /*current sample end=*/samples_first + sample_index * n_features + n_features,
+            /*medoids begin=*/medoids_features.begin(),
+            /*medoids end=*/medoids_features.end(),
+            /*distances begin=*/sample_to_medoids_distances.begin());
+
         auto first_min_distance = std::numeric_limits<DataType>::max();
         // iterate over the medoids indices
-        for (const auto& medoid : medoids) {
-            const auto nearest_candidate = compute_distance(medoid, sample_index);
+        for (const auto& nearest_candidate : sample_to_medoids_distances) {
 
             if (nearest_candidate < first_min_distance) {
                 first_min_distance = nearest_candidate;
@@ -450,19 +487,23 @@ std::vector<typename Iterator::value_type> samples_to_second_nearest_medoid_dist
     // the vector that will contain the distances from each sample to the nearest medoid
     auto second_nearest_medoid_distances = std::vector<DataType>(n_samples);
 
-    auto compute_distance = [&](std::size_t left_idx, std::size_t right_idx) -> DataType {
-        return cpp_clustering::heuristic::heuristic(
-            /*first medoid begin=*/samples_first + left_idx * n_features,
-            /*first medoid end=*/samples_first + left_idx * n_features + n_features,
-            /*current sample begin=*/samples_first + right_idx * n_features);
-    };
+    // the medoids next to each other so that the distances from a sample to all of them are computed in one batch
+    const auto medoids_features = medoids_to_centroids(samples_first, samples_last, n_features, medoids);
+    // the distances from the current sample to each medoid
+    auto sample_to_medoids_distances = std::vector<DataType>(medoids.size());
     // iterate over all the samples
     for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        cpp_clustering::heuristic::heuristic_one_to_many(
+            /*current sample begin=*/samples_first + sample_index * n_features,
+            /*current sample end=*/samples_first + sample_index * n_features + n_features,
+            /*medoids begin=*/medoids_features.begin(),
+            /*medoids end=*/medoids_features.end(),
+            /*distances begin=*/sample_to_medoids_distances.begin());
+
         auto first_min_distance  = std::numeric_limits<DataType>::max();
         auto second_min_distance = std::numeric_limits<DataType>::max();
         // iterate over the medoids indices
-        for (const auto& medoid : medoids) {
-            const auto second_nearest_candidate = compute_distance(medoid, sample_index);
+        for (const auto& second_nearest_candidate : sample_to_medoids_distances) {
 
             if (second_nearest_candidate < first_min_distance) {
                 second_min_distance = first_min_distance;
@@ -532,20 +573,24 @@ std::vector<typename Iterator::value_type> samples_to_third_nearest_medoid_dista
     // the vector that will contain the distances from each sample to the nearest medoid
     auto third_nearest_medoid_distances = std::vector<DataType>(n_samples);
 
-    auto compute_distance = [&](std::size_t left_idx, std::size_t right_idx) -> DataType {
-        return cpp_clustering::heuristic::heuristic(
-            /*first medoid begin=*/samples_first + left_idx * n_features,
-            /*first medoid end=*/samples_first + left_idx * n_features + n_features,
-            /*current sample begin=*/samples_first + right_idx * n_features);
-    };
+    // the medoids next to each other so that the distances from a sample to all of them are computed in one batch
+    const auto medoids_features = medoids_to_centroids(samples_first, samples_last, n_features, medoids);
+    // the distances from the current sample to each medoid
+    auto sample_to_medoids_distances = std::vector<DataType>(medoids.size());
     // iterate over all the samples
     for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        cpp_clustering::heuristic::heuristic_one_to_many(
+            /*current sample begin=*/samples_first + sample_index * n_features,
+            /*current sample end=*/samples_first + sample_index * n_features + n_features,
+            /*medoids begin=*/medoids_features.begin(),
+            /*medoids end=*/medoids_features.end(),
+            /*distances begin=*/sample_to_medoids_distances.begin());
+
         auto first_min_distance  = std::numeric_limits<DataType>::max();
         auto second_min_distance = std::numeric_limits<DataType>::max();
         auto third_min_distance  = std::numeric_limits<DataType>::max();
         // iterate over the medoids indices
-        for (const auto& medoid : medoids) {
-            const auto third_nearest_candidate = compute_distance(medoid, sample_index);
+        for (const auto& third_nearest_candidate : sample_to_medoids_distances) {
 
             if (third_nearest_candidate < first_min_distance) {
                 third_min_distance  = second_min_distance;
@@ -726,18 +771,20 @@ std::pair<typename Iterator::value_type, std::size_t> first_medoid_td_index_pair
 
     std::size_t selected_medoid = 0;
     auto        total_deviation = common::utils::infinity<DataType>();
+    // the distances from the current candidate medoid to all the samples
+    auto candidate_to_samples_distances = std::vector<DataType>(n_samples);
     // choose the first medoid
     for (std::size_t medoid_candidate_idx = 0; medoid_candidate_idx < n_samples; ++medoid_candidate_idx) {
+        // the distance to the candidate itself is included but it's 0 anyway
+        cpp_clustering::heuristic::heuristic_one_to_many(
+            /*candidate sample begin=*/data_first + medoid_candidate_idx * n_features,
+            /*candidate sample end=*/data_first + medoid_candidate_idx * n_features + n_features,
+            /*samples begin=*/data_first,
+            /*samples end=*/data_last,
+            /*distances begin=*/candidate_to_samples_distances.begin());
         // total deviation accumulator w.r.t. current candidate medoid and all the other points
-        DataType loss_acc = 0;
-        for (std::size_t other_sample_index = 0; other_sample_index < n_samples; ++other_sample_index) {
-            // the following should be done if other_sample_index != medoid_candidate_idx
-            // but the distance would be 0 anyway with dist(other_sample, medoid_candidate)
-            loss_acc += cpp_clustering::heuristic::heuristic(
-                /*first sample begin=*/data_first + medoid_candidate_idx * n_features,
-                /*first sample end=*/data_first + medoid_candidate_idx * n_features + n_features,
-                /*other sample begin=*/data_first + other_sample_index * n_features);
-        }
+        const DataType loss_acc = std::accumulate(
+            candidate_to_samples_distances.begin(), candidate_to_samples_distances.end(), static_cast<DataType>(0));
         // if the candidate total deviation is lower than the current total deviation
         if (loss_acc < total_deviation) {
             // update the current total deviation
@@ -778,22 +825,4 @@ std::pair<typename Iterator::value_type, std::size_t> first_medoid_td_index_pair
     return {total_deviation, selected_medoid};
 }
 
-template <typename Iterator>
-std::vector<typename Iterator::value_type> medoids_to_centroids(const Iterator&                 data_first,
-                                                                const Iterator&                 data_last,
-                                                                std::size_t                     n_features,
-                                                                const std::vector<std::size_t>& medoids) {
-    const auto n_medoids = medoids.size();
-    auto       clusters  = std::vector<typename Iterator::value_type>(n_medoids * n_features);
-
-    for (std::size_t k = 0; k < n_medoids; ++k) {
-        const std::size_t data_index = medoids[k];
-
-        std::copy(data_first + data_index * n_features,
-                  data_first + data_index * n_features + n_features,
-                  clusters.begin() + k * n_features);
-    }
-    return clusters;
-}
-
 }  // namespace pam::utils
\ No newline at end of file
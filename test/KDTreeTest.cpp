@@ -6,10 +6,16 @@
 #include <sys/types.h>  // std::ssize_t
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <iterator>
+#include <random>
 #include <vector>
 
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
 namespace fs = std::filesystem;
 
 class KDTreeErrorsTest : public ::testing::Test {
@@ -174,6 +180,153 @@ TEST_F(KDTreeErrorsTest, KDTreeTest) {
     // kdtree.print();
 }
 
+TEST_F(KDTreeErrorsTest, KDTreeLayoutTest) {
+    using Iterator = std::vector<dType>::iterator;
+
+    const std::size_t n_samples  = 10000;
+    const std::size_t n_features = 3;
+    // default bucket size of the KDTree
+    const std::size_t bucket_size = 10;
+
+    std::mt19937                          random_engine(0);
+    std::uniform_real_distribution<dType> distribution(-10, 10);
+
+    auto data = std::vector<dType>(n_samples * n_features);
+    std::generate(data.begin(), data.end(), [&]() { return distribution(random_engine); });
+
+    auto kdtree = cpp_clustering::containers::KDTree(data.begin(), data.end(), n_features);
+
+    const auto& nodes = kdtree.nodes();
+
+    std::size_t n_visited_nodes = 0, n_visited_samples = 0;
+
+    // the samples of the left (right) subtree of a cut are lower (greater) or equal to the cut value
+    std::function<bool(std::size_t, Iterator, Iterator)> is_subtree_valid =
+        [&](std::size_t node_index, Iterator samples_first, Iterator samples_last) {
+            const std::size_t subtree_n_samples = common::utils::get_n_samples(samples_first, samples_last, n_features);
+
+            ++n_visited_nodes;
+
+            if (nodes[node_index].is_leaf()) {
+                n_visited_samples += subtree_n_samples;
+                return subtree_n_samples <= bucket_size;
+            }
+            ++n_visited_samples;
+
+            const auto& node         = nodes[node_index];
+            const auto  median_first = samples_first + subtree_n_samples / 2 * n_features;
+
+            if (*(median_first + node.cut_feature_index_) != node.cut_value_) {
+                return false;
+            }
+            for (auto sample_first = samples_first; sample_first != samples_last; sample_first += n_features) {
+                const auto feature = *(sample_first + node.cut_feature_index_);
+
+                if ((sample_first < median_first && feature > node.cut_value_) ||
+                    (sample_first > median_first && feature < node.cut_value_)) {
+                    return false;
+                }
+            }
+            return is_subtree_valid(node_index + 1, samples_first, median_first) &&
+                   is_subtree_valid(node.right_index_, median_first + n_features, samples_last);
+        };
+    EXPECT_TRUE(is_subtree_valid(0, kdtree.samples_first(), kdtree.samples_last()));
+    // each node and each sample is reached once
+    EXPECT_EQ(n_visited_nodes, nodes.size());
+    EXPECT_EQ(n_visited_samples, n_samples);
+}
+
+TEST_F(KDTreeErrorsTest, KNNTest) {
+    const std::size_t n_samples   = 5000;
+    const std::size_t n_queries   = 200;
+    const std::size_t n_features  = 3;
+    const std::size_t n_neighbors = 7;
+
+    std::mt19937                          random_engine(0);
+    std::uniform_real_distribution<dType> distribution(-10, 10);
+    // some queries fall outside of the bounding box of the samples
+    std::uniform_real_distribution<dType> queries_distribution(-15, 15);
+
+    auto data    = std::vector<dType>(n_samples * n_features);
+    auto queries = std::vector<dType>(n_queries * n_features);
+    std::generate(data.begin(), data.end(), [&]() { return distribution(random_engine); });
+    std::generate(queries.begin(), queries.end(), [&]() { return queries_distribution(random_engine); });
+
+    auto kdtree = cpp_clustering::containers::KDTree(data.begin(), data.end(), n_features);
+
+    const auto [indices, distances] = kdtree.knn(queries.begin(), queries.end(), n_neighbors);
+
+    ASSERT_EQ(indices.size(), n_queries * n_neighbors);
+
+    for (std::size_t query_index = 0; query_index < n_queries; ++query_index) {
+        const auto query_first = queries.begin() + query_index * n_features;
+
+        // brute force neighbors with the same order as the tree: by distance and then by index
+        auto neighbors = std::vector<std::pair<dType, std::size_t>>(n_samples);
+        for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+            const auto sample_first = data.begin() + sample_index * n_features;
+
+            neighbors[sample_index] = {cpp_clustering::heuristic::squared_euclidean_distance(
+                                           sample_first, sample_first + n_features, query_first),
+                                       sample_index};
+        }
+        std::partial_sort(neighbors.begin(), neighbors.begin() + n_neighbors, neighbors.end());
+
+        const auto [query_indices, query_distances] = kdtree.knn(query_first, n_neighbors);
+
+        for (std::size_t neighbor_index = 0; neighbor_index < n_neighbors; ++neighbor_index) {
+            EXPECT_EQ(neighbors[neighbor_index].second, indices[query_index * n_neighbors + neighbor_index]);
+            EXPECT_FLOAT_EQ(std::sqrt(neighbors[neighbor_index].first),
+                            distances[query_index * n_neighbors + neighbor_index]);
+            // the single query matches the batched one
+            EXPECT_EQ(query_indices[neighbor_index], indices[query_index * n_neighbors + neighbor_index]);
+        }
+    }
+    EXPECT_THROW(kdtree.knn(queries.begin(), n_samples + 1), std::invalid_argument);
+}
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+TEST_F(KDTreeErrorsTest, KDTreeParallelBuildTest) {
+    // enough samples to build several levels of the tree in parallel
+    const std::size_t n_samples  = 200000;
+    const std::size_t n_features = 3;
+
+    std::mt19937                          random_engine(0);
+    std::uniform_real_distribution<dType> distribution(-10, 10);
+
+    auto data = std::vector<dType>(n_samples * n_features);
+    std::generate(data.begin(), data.end(), [&]() { return distribution(random_engine); });
+
+    auto data_serial   = data;
+    auto data_parallel = data;
+
+    const int n_threads_default = omp_get_max_threads();
+
+    omp_set_num_threads(1);
+    auto kdtree_serial = cpp_clustering::containers::KDTree(data_serial.begin(), data_serial.end(), n_features);
+
+    omp_set_num_threads(4);
+    auto kdtree_parallel = cpp_clustering::containers::KDTree(data_parallel.begin(), data_parallel.end(), n_features);
+
+    omp_set_num_threads(n_threads_default);
+
+    // the samples are reordered the same way
+    EXPECT_EQ(data_serial, data_parallel);
+
+    // the nodes have the same cuts and children
+    ASSERT_EQ(kdtree_serial.nodes().size(), kdtree_parallel.nodes().size());
+
+    for (std::size_t node_index = 0; node_index < kdtree_serial.nodes().size(); ++node_index) {
+        const auto& node_serial   = kdtree_serial.nodes()[node_index];
+        const auto& node_parallel = kdtree_parallel.nodes()[node_index];
+
+        EXPECT_EQ(node_serial.cut_value_, node_parallel.cut_value_);
+        EXPECT_EQ(node_serial.cut_feature_index_, node_parallel.cut_feature_index_);
+        EXPECT_EQ(node_serial.right_index_, node_parallel.right_index_);
+    }
+}
+#endif
+
 int main(int argc, char** argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -2,9 +2,15 @@
 #include <gtest/gtest.h>
 
 #include "cpp_clustering/heuristics/SilhouetteMethod.hpp"
+#include "cpp_clustering/kmeans/BisectingKMeans.hpp"
+#include "cpp_clustering/kmeans/Elkan.hpp"
 #include "cpp_clustering/kmeans/Hamerly.hpp"
+#include "cpp_clustering/kmeans/HierarchicalKMeans.hpp"
+#include "cpp_clustering/kmeans/KDTreeFiltering.hpp"
 #include "cpp_clustering/kmeans/KMeans.hpp"
 #include "cpp_clustering/kmeans/Lloyd.hpp"
+#include "cpp_clustering/kmeans/ProductQuantizer.hpp"
+#include "cpp_clustering/kmeans/Yinyang.hpp"
 #include "cpp_clustering/math/random/VosesAliasMethod.hpp"
 
 #include <sys/types.h>  // std::ssize_t
@@ -12,8 +18,13 @@
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <vector>
 
+#if defined(_OPENMP) && THREADS_ENABLED == true
+#include <omp.h>
+#endif
+
 namespace fs = std::filesystem;
 
 class KMeansErrorsTest : public ::testing::Test {
@@ -133,6 +144,20 @@ class KMeansErrorsTest : public ::testing::Test {
         return {predictions, centroids};
     }
 
+    template <typename DataType>
+    std::vector<DataType> generate_flattened_matrix(std::size_t n_samples,
+                                                    std::size_t n_features,
+                                                    DataType    lower_bound = 0,
+                                                    DataType    upper_bound = 10) {
+        math::random::uniform_distribution<DataType> random_uniform(lower_bound, upper_bound);
+
+        auto result = std::vector<DataType>(n_samples * n_features);
+
+        std::generate(result.begin(), result.end(), random_uniform);
+
+        return result;
+    }
+
     static constexpr std::size_t n_iterations_global = 100;
     static constexpr std::size_t n_centroids_global  = 4;
 
@@ -333,6 +358,993 @@ TEST_F(KMeansErrorsTest, MnistSimpleFitTest) {
     write_data<dType>(centroids, 1, centroids_folder / fs::path(filename));
 }
 
+TEST_F(KMeansErrorsTest, PartialFitSingleBatchTest) {
+    using KMeans = cpp_clustering::KMeans<dType>;
+
+    const std::size_t n_samples   = 2000;
+    const std::size_t n_features  = 8;
+    const std::size_t n_centroids = 10;
+
+    const auto data           = generate_flattened_matrix<dType>(n_samples, n_features, -10, 10);
+    const auto centroids_init = std::vector<dType>(data.begin(), data.begin() + n_centroids * n_features);
+
+    auto kmeans = KMeans(n_centroids, n_features, centroids_init);
+
+    const auto centroids_partial_fit = kmeans.partial_fit(data.begin(), data.end());
+
+    auto lloyd = cpp_clustering::Lloyd<typename std::vector<dType>::const_iterator>(
+        {data.cbegin(), data.cend(), n_features}, centroids_init);
+
+    // with fresh counts, the per centroid learning rates make a single batch update equal to the mean of the assigned
+    // samples, i.e. a single lloyd step
+    EXPECT_TRUE(common::utils::are_containers_equal(centroids_partial_fit, lloyd.step(), static_cast<dType>(1e-3)));
+
+    // well separated blobs with the samples of each blob spread over all the batches
+    const std::size_t n_blobs = 5;
+
+    auto blobs_data = generate_flattened_matrix<dType>(n_samples, n_features, -1, 1);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        for (std::size_t feature_index = 0; feature_index < n_features; ++feature_index) {
+            blobs_data[sample_index * n_features + feature_index] += static_cast<dType>(100 * (sample_index % n_blobs));
+        }
+    }
+    // one initial centroid in each blob
+    const auto blobs_centroids_init =
+        std::vector<dType>(blobs_data.begin(), blobs_data.begin() + n_blobs * n_features);
+
+    auto kmeans_partial_fit = KMeans(n_blobs, n_features, blobs_centroids_init);
+    auto kmeans_fit         = KMeans(n_blobs, n_features, blobs_centroids_init);
+
+    // a few epochs over the batches
+    const std::size_t batch_size = 200;
+    auto              blobs_centroids_partial_fit = blobs_centroids_init;
+    for (std::size_t epoch = 0; epoch < 3; ++epoch) {
+        for (std::size_t batch_index = 0; batch_index < n_samples / batch_size; ++batch_index) {
+            const auto batch_first = blobs_data.begin() + batch_index * batch_size * n_features;
+
+            blobs_centroids_partial_fit =
+                kmeans_partial_fit.partial_fit(batch_first, batch_first + batch_size * n_features);
+        }
+    }
+    const auto blobs_centroids_fit = kmeans_fit.fit<cpp_clustering::Lloyd>(blobs_data.begin(), blobs_data.end());
+
+    // the samples never change blob so the streamed centroids are the running means of the blobs, i.e. the fit ones
+    const auto predictions = kmeans_partial_fit.predict(blobs_data.begin(), blobs_data.end());
+
+    ASSERT_EQ(predictions.size(), n_samples);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        EXPECT_EQ(predictions[sample_index], sample_index % n_blobs);
+    }
+    EXPECT_TRUE(common::utils::are_containers_equal(
+        blobs_centroids_partial_fit, blobs_centroids_fit, static_cast<dType>(1e-2)));
+}
+
+TEST_F(KMeansErrorsTest, MaxCentroidShiftTest) {
+    const std::size_t n_samples   = 2000;
+    const std::size_t n_features  = 4;
+    const std::size_t n_centroids = 8;
+
+    const auto data           = generate_flattened_matrix<dType>(n_samples, n_features, -10, 10);
+    const auto centroids_init = std::vector<dType>(data.begin(), data.begin() + n_centroids * n_features);
+
+    using SamplesIterator = typename std::vector<dType>::const_iterator;
+
+    // the shift is the largest change of a centroid coordinate between two steps
+    auto check_max_centroid_shift = [&](auto&& kmeans_algorithm) {
+        auto previous_centroids = centroids_init;
+
+        for (std::size_t iter = 0; iter < 30; ++iter) {
+            const auto& centroids = kmeans_algorithm.step();
+
+            dType max_shift = 0;
+            for (std::size_t index = 0; index < centroids.size(); ++index) {
+                max_shift = std::max(max_shift, std::abs(centroids[index] - previous_centroids[index]));
+            }
+            EXPECT_FLOAT_EQ(kmeans_algorithm.max_centroid_shift(), max_shift);
+
+            previous_centroids = centroids;
+        }
+    };
+    check_max_centroid_shift(
+        cpp_clustering::Lloyd<SamplesIterator>({data.cbegin(), data.cend(), n_features}, centroids_init));
+    check_max_centroid_shift(
+        cpp_clustering::Hamerly<SamplesIterator>({data.cbegin(), data.cend(), n_features}, centroids_init));
+}
+
+TEST_F(KMeansErrorsTest, FixedNFeaturesKernelsTest) {
+    const std::size_t n_samples   = 1000;
+    const std::size_t n_centroids = 40;
+
+    // the dimensions with kernels specialized at compile time and one that falls back to the runtime kernels
+    for (const std::size_t n_features : {2, 3, 4, 5, 8, 16}) {
+        const auto data      = generate_flattened_matrix<dType>(n_samples, n_features, -10, 10);
+        const auto centroids = std::vector<dType>(data.begin(), data.begin() + n_centroids * n_features);
+
+        const auto nearest_centroid_distances =
+            kmeans::utils::samples_to_nearest_centroid_distances(data.begin(), data.end(), n_features, centroids);
+
+        for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+            auto min_distance = common::utils::infinity<dType>();
+
+            for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+                const auto distance = cpp_clustering::heuristic::heuristic(
+                    data.begin() + sample_index * n_features,
+                    data.begin() + sample_index * n_features + n_features,
+                    centroids.begin() + centroid_index * n_features);
+
+                common::utils::dispatch_n_features(n_features, [&](auto n_features_constant) {
+                    EXPECT_NEAR(cpp_clustering::heuristic::heuristic<decltype(n_features_constant)::value>(
+                                    data.begin() + sample_index * n_features,
+                                    data.begin() + sample_index * n_features + n_features,
+                                    centroids.begin() + centroid_index * n_features),
+                                distance,
+                                1e-4);
+                });
+                min_distance = std::min(min_distance, distance);
+            }
+            EXPECT_NEAR(nearest_centroid_distances[sample_index], min_distance, 1e-3);
+        }
+    }
+}
+
+TEST_F(KMeansErrorsTest, BlockedNearestCentroidTest) {
+    // the numbers of samples and centroids dont fill the last tiles (64 samples, chunks of 16 centroids and tiles of
+    // 256 centroids for the specialized kernels) and the numbers of features use both the specialized and the runtime
+    // kernels
+    for (const std::size_t n_samples : {37, 197}) {
+        for (const std::size_t n_centroids : {13, 37, 300}) {
+            for (const std::size_t n_features : {3, 7, 8, 33}) {
+                const auto data      = generate_flattened_matrix<dType>(n_samples, n_features, -10, 10);
+                const auto centroids = generate_flattened_matrix<dType>(n_centroids, n_features, -10, 10);
+
+                auto nearest_centroid_indices   = std::vector<std::size_t>(n_samples);
+                auto nearest_centroid_distances = std::vector<dType>(n_samples);
+
+                kmeans::utils::samples_to_nearest_centroid_indices_and_distances(data.begin(),
+                                                                                 data.end(),
+                                                                                 n_features,
+                                                                                 centroids,
+                                                                                 nearest_centroid_indices.begin(),
+                                                                                 nearest_centroid_distances.begin());
+
+                for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+                    const auto sample_first = data.begin() + sample_index * n_features;
+
+                    auto sample_to_centroids_distances = std::vector<dType>(n_centroids);
+
+                    for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+                        sample_to_centroids_distances[centroid_index] = cpp_clustering::heuristic::heuristic(
+                            sample_first, sample_first + n_features, centroids.begin() + centroid_index * n_features);
+                    }
+                    const auto [min_index, min_distance] = common::utils::get_min_index_value_pair(
+                        sample_to_centroids_distances.begin(), sample_to_centroids_distances.end());
+
+                    const auto nearest_centroid_index = nearest_centroid_indices[sample_index];
+
+                    ASSERT_LT(nearest_centroid_index, n_centroids);
+                    // the argmin can only differ on near ties
+                    if (nearest_centroid_index != min_index) {
+                        EXPECT_NEAR(sample_to_centroids_distances[nearest_centroid_index],
+                                    min_distance,
+                                    static_cast<dType>(1e-3) * min_distance);
+                    }
+                    // the returned distance is the exact distance to the returned centroid
+                    EXPECT_NEAR(nearest_centroid_distances[sample_index],
+                                sample_to_centroids_distances[nearest_centroid_index],
+                                static_cast<dType>(1e-5) * sample_to_centroids_distances[nearest_centroid_index]);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(KMeansErrorsTest, SimdDistancesTest) {
+    namespace simd = cpp_clustering::heuristic::simd;
+
+    // covers the lengths below the register width, the tails and the ones routed by heuristic
+    for (std::size_t n_features = 1; n_features <= 70; ++n_features) {
+        const auto features       = generate_flattened_matrix<dType>(1, n_features, -10, 10);
+        const auto other_features = generate_flattened_matrix<dType>(1, n_features, -10, 10);
+
+        const auto* feature_first       = features.data();
+        const auto* other_feature_first = other_features.data();
+
+        const dType squared_euclidean_distance =
+            simd::scalar::squared_euclidean_distance(feature_first, other_feature_first, n_features);
+        const dType manhattan_distance =
+            simd::scalar::manhattan_distance(feature_first, other_feature_first, n_features);
+        const dType cosine_similarity =
+            simd::scalar::cosine_similarity(feature_first, other_feature_first, n_features);
+
+        const auto tolerance = [](dType expected) { return 1e-5 * std::max<dType>(1, std::abs(expected)); };
+
+        // the dispatched kernels and the ones of every instruction set available on this host
+        std::vector<simd::DistanceKernels<dType>> kernels = {simd::distance_kernels<dType>()};
+        if (simd::instruction_set() >= simd::InstructionSet::avx2) {
+            kernels.emplace_back(simd::make_distance_kernels<dType>(simd::InstructionSet::avx2));
+        }
+        if (simd::instruction_set() >= simd::InstructionSet::avx512) {
+            kernels.emplace_back(simd::make_distance_kernels<dType>(simd::InstructionSet::avx512));
+        }
+        for (const auto& kernel : kernels) {
+            EXPECT_NEAR(kernel.squared_euclidean_distance(feature_first, other_feature_first, n_features),
+                        squared_euclidean_distance,
+                        tolerance(squared_euclidean_distance));
+            EXPECT_NEAR(kernel.manhattan_distance(feature_first, other_feature_first, n_features),
+                        manhattan_distance,
+                        tolerance(manhattan_distance));
+            EXPECT_NEAR(kernel.cosine_similarity(feature_first, other_feature_first, n_features),
+                        cosine_similarity,
+                        tolerance(cosine_similarity));
+        }
+        EXPECT_NEAR(cpp_clustering::heuristic::heuristic(features.begin(), features.end(), other_features.begin()),
+                    std::sqrt(squared_euclidean_distance),
+                    tolerance(std::sqrt(squared_euclidean_distance)));
+        EXPECT_NEAR(
+            cpp_clustering::heuristic::manhattan_distance(features.begin(), features.end(), other_features.begin()),
+            manhattan_distance,
+            tolerance(manhattan_distance));
+        EXPECT_NEAR(
+            cpp_clustering::heuristic::cosine_similarity(features.begin(), features.end(), other_features.begin()),
+            cosine_similarity,
+            tolerance(cosine_similarity));
+    }
+}
+
+TEST_F(KMeansErrorsTest, BatchedHeuristicTest) {
+    const std::size_t n_samples       = 50;
+    const std::size_t n_other_samples = 300;
+
+    // the dimensions specialized at compile time, a small one that isnt and one routed to the SIMD kernels
+    for (const std::size_t n_features : {2, 3, 5, 16, 33}) {
+        const auto samples       = generate_flattened_matrix<dType>(n_samples, n_features, -10, 10);
+        const auto other_samples = generate_flattened_matrix<dType>(n_other_samples, n_features, -10, 10);
+
+        auto distances = std::vector<dType>(n_samples * n_other_samples);
+
+        cpp_clustering::heuristic::heuristic_many_to_many(
+            samples.begin(), samples.end(), other_samples.begin(), other_samples.end(), n_features, distances.begin());
+
+        for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+            auto sample_to_other_samples_distances = std::vector<dType>(n_other_samples);
+
+            cpp_clustering::heuristic::heuristic_one_to_many(samples.begin() + sample_index * n_features,
+                                                             samples.begin() + sample_index * n_features + n_features,
+                                                             other_samples.begin(),
+                                                             other_samples.end(),
+                                                             sample_to_other_samples_distances.begin());
+
+            for (std::size_t other_sample_index = 0; other_sample_index < n_other_samples; ++other_sample_index) {
+                const auto distance =
+                    cpp_clustering::heuristic::heuristic(samples.begin() + sample_index * n_features,
+                                                         samples.begin() + sample_index * n_features + n_features,
+                                                         other_samples.begin() + other_sample_index * n_features);
+
+                EXPECT_NEAR(sample_to_other_samples_distances[other_sample_index], distance, 1e-4);
+                EXPECT_NEAR(distances[sample_index * n_other_samples + other_sample_index], distance, 1e-4);
+            }
+        }
+    }
+    // the silhouette compares the samples grouped by cluster
+    const std::size_t n_features  = 3;
+    const std::size_t n_centroids = 4;
+
+    const auto data   = generate_flattened_matrix<dType>(n_other_samples, n_features, -10, 10);
+    auto       labels = std::vector<std::size_t>(n_other_samples);
+    for (std::size_t sample_index = 0; sample_index < n_other_samples; ++sample_index) {
+        labels[sample_index] = (sample_index * 7) % n_centroids;
+    }
+    const auto cohesion_values = cpp_clustering::silhouette_method::cohesion(
+        data.begin(), data.end(), labels.begin(), labels.end(), n_features);
+    const auto separation_values = cpp_clustering::silhouette_method::separation(
+        data.begin(), data.end(), labels.begin(), labels.end(), n_features);
+
+    for (std::size_t sample_index = 0; sample_index < n_other_samples; ++sample_index) {
+        auto distances_sums = std::vector<dType>(n_centroids);
+        auto cluster_sizes  = std::vector<std::size_t>(n_centroids);
+
+        for (std::size_t other_sample_index = 0; other_sample_index < n_other_samples; ++other_sample_index) {
+            distances_sums[labels[other_sample_index]] +=
+                cpp_clustering::heuristic::heuristic(data.begin() + sample_index * n_features,
+                                                     data.begin() + sample_index * n_features + n_features,
+                                                     data.begin() + other_sample_index * n_features);
+            ++cluster_sizes[labels[other_sample_index]];
+        }
+        auto separation = common::utils::infinity<dType>();
+        for (std::size_t centroid_index = 0; centroid_index < n_centroids; ++centroid_index) {
+            if (centroid_index != labels[sample_index]) {
+                separation = std::min(separation, distances_sums[centroid_index] / cluster_sizes[centroid_index]);
+            }
+        }
+        EXPECT_NEAR(cohesion_values[sample_index],
+                    distances_sums[labels[sample_index]] / (cluster_sizes[labels[sample_index]] - 1),
+                    1e-3);
+        EXPECT_NEAR(separation_values[sample_index], separation, 1e-3);
+    }
+}
+
+// a kmeans++ variant that picks its centroids among the samples
+struct SeedingParams {
+    using SamplesIterator = std::vector<KMeansErrorsTest::dType>::const_iterator;
+    using SeedingFunction = std::vector<KMeansErrorsTest::dType> (*)(const SamplesIterator&,
+                                                                     const SamplesIterator&,
+                                                                     std::size_t,
+                                                                     std::size_t);
+
+    const char*     name;
+    SeedingFunction make_centroids;
+};
+
+class SeedingTest : public KMeansErrorsTest, public ::testing::WithParamInterface<SeedingParams> {};
+
+TEST_P(SeedingTest, OneCentroidPerBlobTest) {
+    using KMeans = cpp_clustering::KMeans<dType>;
+
+    const std::size_t n_samples  = 5000;
+    const std::size_t n_features = 4;
+    const std::size_t n_blobs    = 10;
+    // far enough apart for the variants that weight the samples by their distance rather than its square
+    const dType blobs_spacing = 1e4;
+
+    const auto& params = GetParam();
+
+    // well separated blobs along the first feature: sample_index % n_blobs is the blob of a sample
+    auto blobs_data = generate_flattened_matrix<dType>(n_samples, n_features, -1, 1);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        blobs_data[sample_index * n_features] += blobs_spacing * static_cast<dType>(sample_index % n_blobs);
+    }
+    const auto& data = blobs_data;
+
+    const auto loss = [&data, n_features](const std::vector<dType>& centroids) {
+        const auto nearest_centroid_distances =
+            kmeans::utils::samples_to_nearest_centroid_distances(data.begin(), data.end(), n_features, centroids);
+
+        return std::reduce(nearest_centroid_distances.begin(), nearest_centroid_distances.end(), static_cast<dType>(0));
+    };
+    // the approximations of kmeans++ can miss a blob once in a while so the best of a few seedings is kept, as with
+    // n_init. A uniform pick of the samples almost never gives one centroid per blob, even after a few tries
+    auto centroids = std::vector<dType>();
+
+    for (std::size_t seeding_index = 0; seeding_index < 3; ++seeding_index) {
+        const auto centroids_candidate = params.make_centroids(data.begin(), data.end(), n_blobs, n_features);
+
+        ASSERT_EQ(centroids_candidate.size(), n_blobs * n_features);
+
+        // the centroids are chosen among the samples
+        for (std::size_t centroid_index = 0; centroid_index < n_blobs; ++centroid_index) {
+            bool is_sample = false;
+
+            for (std::size_t sample_index = 0; sample_index < n_samples && !is_sample; ++sample_index) {
+                is_sample = std::equal(data.begin() + sample_index * n_features,
+                                       data.begin() + sample_index * n_features + n_features,
+                                       centroids_candidate.begin() + centroid_index * n_features);
+            }
+            EXPECT_TRUE(is_sample);
+        }
+        if (centroids.empty() || loss(centroids_candidate) < loss(centroids)) {
+            centroids = centroids_candidate;
+        }
+    }
+    // the far away samples are favoured so each blob gets its own centroid
+    auto centroids_blobs = std::vector<std::size_t>();
+
+    for (std::size_t centroid_index = 0; centroid_index < n_blobs; ++centroid_index) {
+        const auto first_feature = centroids[centroid_index * n_features];
+
+        centroids_blobs.emplace_back(static_cast<std::size_t>(std::round(first_feature / blobs_spacing)));
+    }
+    std::sort(centroids_blobs.begin(), centroids_blobs.end());
+
+    EXPECT_EQ(std::unique(centroids_blobs.begin(), centroids_blobs.end()) - centroids_blobs.begin(), n_blobs);
+
+    // the initial loss is of the same order as the one of the reference kmeans++
+    const auto reference_centroids =
+        cpp_clustering::kmeansplusplus::make_centroids(data.begin(), data.end(), n_blobs, n_features);
+
+    EXPECT_LE(loss(centroids), 2 * loss(reference_centroids));
+
+    // usable as a centroids initializer
+    auto kmeans = KMeans(n_blobs, n_features);
+
+    const auto fitted_centroids = kmeans.fit<cpp_clustering::Hamerly>(data.begin(), data.end(), params.make_centroids);
+
+    EXPECT_EQ(fitted_centroids.size(), n_blobs * n_features);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    KMeansPlusPlusVariants,
+    SeedingTest,
+    ::testing::Values(
+        SeedingParams{"Parallel",
+                      cpp_clustering::kmeansplusplus::make_centroids_parallel<SeedingParams::SamplesIterator>},
+        SeedingParams{"Afkmc2", cpp_clustering::kmeansplusplus::afkmc2<SeedingParams::SamplesIterator>},
+        SeedingParams{"Greedy", cpp_clustering::kmeansplusplus::make_centroids_greedy<SeedingParams::SamplesIterator>}),
+    [](const ::testing::TestParamInfo<SeedingParams>& info) { return std::string(info.param.name); });
+
+TEST_F(KMeansErrorsTest, DatasetHandleTest) {
+    using KMeans = cpp_clustering::KMeans<dType>;
+
+    const std::size_t n_samples   = 2000;
+    const std::size_t n_features  = 5;
+    const std::size_t n_centroids = 8;
+
+    const auto data = generate_flattened_matrix<dType>(n_samples, n_features, -10, 10);
+
+    auto dataset = cpp_clustering::containers::DatasetHandle(data.begin(), data.end(), n_features);
+
+    ASSERT_EQ(dataset.n_samples(), n_samples);
+
+    const auto& squared_norms = dataset.squared_norms();
+    // computed once
+    ASSERT_EQ(&squared_norms, &dataset.squared_norms());
+
+    EXPECT_TRUE(common::utils::are_containers_equal(
+        squared_norms,
+        kmeans::utils::samples_squared_norms(data.begin(), data.end(), n_features),
+        static_cast<dType>(1e-4)));
+
+    // same fit as with the iterators for the same initial centroids
+    const auto centroids_init = std::vector<dType>(data.begin(), data.begin() + n_centroids * n_features);
+
+    auto kmeans_iterators = KMeans(n_centroids, n_features, centroids_init);
+    auto kmeans_dataset   = KMeans(n_centroids, n_features, centroids_init);
+
+    EXPECT_TRUE(common::utils::are_containers_equal(kmeans_iterators.fit(data.begin(), data.end()),
+                                                    kmeans_dataset.fit(dataset)));
+
+    // the initializers that accept the handle share its squared norms between the n_init candidates
+    auto kmeans_greedy = KMeans(n_centroids, n_features, KMeans::Options().n_init(3));
+
+    const auto centroids = kmeans_greedy.fit<cpp_clustering::Lloyd>(
+        dataset, [](const auto& dataset, std::size_t n_centroids) {
+            return cpp_clustering::kmeansplusplus::make_centroids_greedy(dataset, n_centroids);
+        });
+
+    ASSERT_EQ(centroids.size(), n_centroids * n_features);
+
+    // the labels are used by the silhouette method
+    const auto labels = kmeans_greedy.predict(dataset);
+
+    EXPECT_THROW(cpp_clustering::silhouette_method::silhouette(dataset), std::invalid_argument);
+    EXPECT_THROW(dataset.set_labels(std::vector<std::size_t>(n_samples - 1)), std::invalid_argument);
+
+    dataset.set_labels(labels);
+
+    const auto silhouette_values = cpp_clustering::silhouette_method::silhouette(
+        data.begin(), data.end(), labels.begin(), labels.end(), n_features);
+
+    EXPECT_TRUE(common::utils::are_containers_equal(cpp_clustering::silhouette_method::silhouette(dataset),
+                                                    silhouette_values));
+
+    // a handle with another number of features is rejected
+    const auto mismatched_dataset = cpp_clustering::containers::DatasetHandle(data.begin(), data.end(), 1);
+
+    EXPECT_THROW(kmeans_greedy.predict(mismatched_dataset), std::invalid_argument);
+}
+
+TEST_F(KMeansErrorsTest, DatasetTest) {
+    using KMeans = cpp_clustering::KMeans<dType>;
+
+    const std::size_t n_samples   = 1000;
+    const std::size_t n_features  = 100;
+    const std::size_t n_centroids = 10;
+
+    const auto data = generate_flattened_matrix<dType>(n_samples, n_features, -10, 10);
+
+    const auto dataset = cpp_clustering::containers::Dataset<dType>(data.begin(), data.end(), n_features);
+
+    ASSERT_EQ(dataset.n_samples(), n_samples);
+    // 400 bytes rows padded to 448 bytes
+    ASSERT_EQ(dataset.padded_n_features(), 112);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        const auto* row = dataset.row(sample_index);
+
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(row) % cpp_clustering::containers::dataset_alignment, 0);
+        ASSERT_TRUE(std::equal(row, row + n_features, data.begin() + sample_index * n_features));
+        ASSERT_TRUE(std::all_of(row + n_features, row + dataset.padded_n_features(), [](const auto& padding) {
+            return padding == 0;
+        }));
+    }
+    // zero-copy view of a range of samples
+    const auto view = dataset.view(10, 20);
+
+    ASSERT_EQ(view.n_samples(), 10);
+    ASSERT_EQ(&*view.samples_first(), dataset.row(10));
+
+    // same fit as with the packed rows for the same initial centroids
+    const auto centroids_init = std::vector<dType>(data.begin(), data.begin() + n_centroids * n_features);
+
+    auto kmeans_packed = KMeans(n_centroids, n_features, centroids_init, KMeans::Options().max_iter(10));
+    auto kmeans_padded = KMeans(n_centroids, n_features, centroids_init, KMeans::Options().max_iter(10));
+
+    const auto centroids_packed = kmeans_packed.fit<cpp_clustering::Lloyd>(data.begin(), data.end());
+    const auto centroids_padded = kmeans_padded.fit<cpp_clustering::Lloyd>(dataset);
+
+    ASSERT_EQ(centroids_padded.size(), n_centroids * n_features);
+
+    EXPECT_TRUE(common::utils::are_containers_equal(centroids_packed, centroids_padded, static_cast<dType>(1e-3)));
+    EXPECT_TRUE(common::utils::are_containers_equal(kmeans_packed.predict(data.begin(), data.end()),
+                                                    kmeans_padded.predict(dataset)));
+
+    // a dataset with another number of features is rejected
+    const auto mismatched_dataset = cpp_clustering::containers::Dataset<dType>(data.begin(), data.end(), 1);
+
+    EXPECT_THROW(kmeans_padded.fit(mismatched_dataset), std::invalid_argument);
+    EXPECT_THROW(kmeans_padded.predict(mismatched_dataset), std::invalid_argument);
+}
+
+TEST_F(KMeansErrorsTest, FeatureMajorTest) {
+    using KMeans = cpp_clustering::KMeans<dType>;
+
+    const std::size_t n_samples   = 3000;
+    const std::size_t n_centroids = 12;
+
+    // a number of features specialized at compile time and one that isnt
+    for (const std::size_t n_features : {2, 5}) {
+        const auto data    = generate_flattened_matrix<dType>(n_samples, n_features, -10, 10);
+        const auto columns = cpp_clustering::containers::to_feature_major(data.begin(), data.end(), n_features);
+        const auto view    = cpp_clustering::containers::make_feature_major_view(columns.data(), n_samples, n_features);
+
+        ASSERT_EQ(view.n_samples(), n_samples);
+        // the view is visited in the same order as the sample-major data
+        ASSERT_TRUE(std::equal(data.begin(), data.end(), view.samples_first(), view.samples_last()));
+
+        const auto centroids = std::vector<dType>(data.begin(), data.begin() + n_centroids * n_features);
+
+        const auto indices = kmeans::utils::samples_to_nearest_centroid_indices(
+            view.samples_first(), view.samples_last(), n_features, centroids);
+        const auto distances = kmeans::utils::samples_to_nearest_centroid_distances(
+            view.samples_first(), view.samples_last(), n_features, centroids);
+
+        EXPECT_TRUE(common::utils::are_containers_equal(
+            indices,
+            kmeans::utils::samples_to_nearest_centroid_indices(data.begin(), data.end(), n_features, centroids)));
+        EXPECT_TRUE(common::utils::are_containers_equal(
+            distances,
+            kmeans::utils::samples_to_nearest_centroid_distances(data.begin(), data.end(), n_features, centroids),
+            static_cast<dType>(1e-4)));
+
+        // Lloyd and Hamerly run on the view directly
+        auto kmeans_lloyd   = KMeans(n_centroids, n_features, centroids, KMeans::Options().max_iter(20));
+        auto kmeans_hamerly = KMeans(n_centroids, n_features, centroids, KMeans::Options().max_iter(20));
+        auto kmeans         = KMeans(n_centroids, n_features, centroids, KMeans::Options().max_iter(20));
+
+        const auto centroids_sample_major = kmeans.fit<cpp_clustering::Lloyd>(data.begin(), data.end());
+
+        EXPECT_TRUE(common::utils::are_containers_equal(
+            kmeans_lloyd.fit<cpp_clustering::Lloyd>(view), centroids_sample_major, static_cast<dType>(1e-3)));
+        EXPECT_TRUE(common::utils::are_containers_equal(
+            kmeans_hamerly.fit<cpp_clustering::Hamerly>(view), centroids_sample_major, static_cast<dType>(1e-3)));
+    }
+}
+
+TEST_F(KMeansErrorsTest, BisectingKMeansTest) {
+    using BisectingKMeans = cpp_clustering::BisectingKMeans<dType>;
+
+    const std::size_t n_blobs            = 8;
+    const std::size_t n_samples_per_blob = 100;
+    const std::size_t n_features         = 3;
+
+    // well separated blobs along the first feature so that each leaf should end up with exactly one blob
+    auto data = generate_flattened_matrix<dType>(n_blobs * n_samples_per_blob, n_features, -1, 1);
+
+    for (std::size_t sample_index = 0; sample_index < n_blobs * n_samples_per_blob; ++sample_index) {
+        data[sample_index * n_features] += static_cast<dType>(100 * (sample_index / n_samples_per_blob));
+    }
+    auto bisecting_kmeans = BisectingKMeans(n_blobs, n_features);
+
+    const auto centroids = bisecting_kmeans.fit(data.begin(), data.end());
+
+    ASSERT_EQ(centroids.size(), n_blobs * n_features);
+    // the root, the n_blobs - 1 inner nodes and the n_blobs leaves
+    EXPECT_EQ(bisecting_kmeans.n_nodes(), 2 * n_blobs - 1);
+
+    const auto labels = bisecting_kmeans.predict(data.begin(), data.end());
+
+    auto blobs_labels = std::vector<std::size_t>();
+
+    for (std::size_t blob_index = 0; blob_index < n_blobs; ++blob_index) {
+        const auto blob_first = labels.begin() + blob_index * n_samples_per_blob;
+
+        EXPECT_TRUE(std::all_of(
+            blob_first, blob_first + n_samples_per_blob, [&](const auto& label) { return label == *blob_first; }));
+
+        blobs_labels.emplace_back(*blob_first);
+    }
+    std::sort(blobs_labels.begin(), blobs_labels.end());
+    // one leaf per blob
+    EXPECT_TRUE(std::adjacent_find(blobs_labels.begin(), blobs_labels.end()) == blobs_labels.end());
+
+    auto too_many_centroids = BisectingKMeans(n_blobs * n_samples_per_blob + 1, n_features);
+
+    EXPECT_THROW(too_many_centroids.fit(data.begin(), data.end()), std::invalid_argument);
+}
+
+TEST_F(KMeansErrorsTest, HierarchicalKMeansTest) {
+    using HierarchicalKMeans = cpp_clustering::HierarchicalKMeans<dType>;
+
+    const std::size_t branching_factor   = 4;
+    const std::size_t depth              = 2;
+    const std::size_t n_blobs            = branching_factor * branching_factor;
+    const std::size_t n_samples_per_blob = 50;
+    const std::size_t n_features         = 2;
+
+    // 4 well separated groups of 4 blobs so that each leaf should end up with exactly one blob
+    auto data = generate_flattened_matrix<dType>(n_blobs * n_samples_per_blob, n_features, -1, 1);
+
+    for (std::size_t sample_index = 0; sample_index < n_blobs * n_samples_per_blob; ++sample_index) {
+        const std::size_t blob_index = sample_index / n_samples_per_blob;
+
+        data[sample_index * n_features] += static_cast<dType>(10000 * (blob_index / branching_factor));
+        data[sample_index * n_features + 1] += static_cast<dType>(100 * (blob_index % branching_factor));
+    }
+    // several kmeans++ draws per node so that no fit stops in a local minimum that merges 2 groups or 2 blobs
+    auto hierarchical_kmeans =
+        HierarchicalKMeans(branching_factor, depth, n_features, HierarchicalKMeans::Options().n_init(5));
+
+    const auto centroids = hierarchical_kmeans.fit(data.begin(), data.end());
+
+    ASSERT_EQ(centroids.size(), n_blobs * n_features);
+    EXPECT_EQ(hierarchical_kmeans.n_nodes(), 1 + branching_factor + n_blobs);
+
+    const auto labels = hierarchical_kmeans.predict(data.begin(), data.end());
+
+    auto blobs_labels = std::vector<std::size_t>();
+
+    for (std::size_t blob_index = 0; blob_index < n_blobs; ++blob_index) {
+        const auto blob_first = labels.begin() + blob_index * n_samples_per_blob;
+
+        EXPECT_TRUE(std::all_of(
+            blob_first, blob_first + n_samples_per_blob, [&](const auto& label) { return label == *blob_first; }));
+
+        blobs_labels.emplace_back(*blob_first);
+    }
+    std::sort(blobs_labels.begin(), blobs_labels.end());
+    // one leaf per blob
+    EXPECT_TRUE(std::adjacent_find(blobs_labels.begin(), blobs_labels.end()) == blobs_labels.end());
+
+    // a beam as wide as the number of leaves visits all of them and finds the nearest one
+    hierarchical_kmeans.set_beam_width(n_blobs);
+
+    const std::size_t n_queries = 500;
+
+    const auto queries = generate_flattened_matrix<dType>(n_queries, n_features, -100, 30100);
+
+    const auto queries_labels    = hierarchical_kmeans.predict(queries.begin(), queries.end());
+    const auto queries_distances = hierarchical_kmeans.forward(queries.begin(), queries.end());
+
+    auto query_to_centroids_distances = std::vector<dType>(n_blobs);
+
+    for (std::size_t query_index = 0; query_index < n_queries; ++query_index) {
+        // exact distances as a reference since the coordinates are too large for the expanded form in float
+        cpp_clustering::heuristic::heuristic_one_to_many(queries.begin() + query_index * n_features,
+                                                         queries.begin() + query_index * n_features + n_features,
+                                                         centroids.begin(),
+                                                         centroids.end(),
+                                                         query_to_centroids_distances.begin());
+
+        EXPECT_EQ(queries_labels[query_index],
+                  common::utils::argmin(query_to_centroids_distances.begin(), query_to_centroids_distances.end()));
+        const auto min_distance =
+            *std::min_element(query_to_centroids_distances.begin(), query_to_centroids_distances.end());
+        // the distances are large so the tolerance is relative
+        EXPECT_NEAR(queries_distances[query_index], min_distance, static_cast<dType>(1e-5) * min_distance);
+    }
+}
+
+TEST_F(KMeansErrorsTest, ProductQuantizerTest) {
+    using ProductQuantizer = cpp_clustering::ProductQuantizer<dType>;
+
+    const std::size_t n_samples   = 3000;
+    const std::size_t n_features  = 12;
+    const std::size_t n_subspaces = 4;
+    const std::size_t n_centroids = 32;
+
+    const std::size_t n_subspace_features = n_features / n_subspaces;
+
+    const auto data = generate_flattened_matrix<dType>(n_samples, n_features, -10, 10);
+
+    auto product_quantizer =
+        ProductQuantizer(n_subspaces, n_centroids, n_features, ProductQuantizer::Options().max_iter(20));
+
+    const auto codebooks = product_quantizer.fit(data.begin(), data.end());
+
+    ASSERT_EQ(codebooks.size(), n_subspaces * n_centroids * n_subspace_features);
+
+    const auto codes = product_quantizer.encode(data.begin(), data.end());
+
+    ASSERT_EQ(codes.size(), n_samples * n_subspaces);
+
+    // each code is the nearest centroid of the codebook of its subspace
+    auto subvector_to_centroids_distances = std::vector<dType>(n_centroids);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        for (std::size_t subspace_index = 0; subspace_index < n_subspaces; ++subspace_index) {
+            const auto subvector_first =
+                data.begin() + sample_index * n_features + subspace_index * n_subspace_features;
+            const auto codebook_first = codebooks.begin() + subspace_index * n_centroids * n_subspace_features;
+
+            cpp_clustering::heuristic::heuristic_one_to_many(subvector_first,
+                                                             subvector_first + n_subspace_features,
+                                                             codebook_first,
+                                                             codebook_first + n_centroids * n_subspace_features,
+                                                             subvector_to_centroids_distances.begin());
+
+            const auto code = codes[sample_index * n_subspaces + subspace_index];
+
+            EXPECT_NEAR(subvector_to_centroids_distances[code],
+                        *std::min_element(subvector_to_centroids_distances.begin(),
+                                          subvector_to_centroids_distances.end()),
+                        1e-3);
+        }
+    }
+    // the asymmetric distances are the distances to the decoded samples
+    const auto decoded_data = product_quantizer.decode(codes);
+    const auto query        = generate_flattened_matrix<dType>(1, n_features, -10, 10);
+
+    const auto distances = product_quantizer.asymmetric_distances(query.begin(), query.end(), codes);
+
+    ASSERT_EQ(distances.size(), n_samples);
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        EXPECT_NEAR(distances[sample_index],
+                    cpp_clustering::heuristic::heuristic(
+                        query.begin(), query.end(), decoded_data.begin() + sample_index * n_features),
+                    1e-3);
+    }
+    EXPECT_THROW(ProductQuantizer(5, n_centroids, n_features), std::invalid_argument);
+    EXPECT_THROW(ProductQuantizer(n_subspaces, 257, n_features), std::invalid_argument);
+}
+
+TEST_F(KMeansErrorsTest, RacingTest) {
+    using KMeans = cpp_clustering::KMeans<dType>;
+    using Lloyd  = cpp_clustering::Lloyd<std::vector<dType>::const_iterator>;
+
+    // geometric decay of ratio 1/2 from 100: the trajectory converges towards 0
+    const auto losses = std::vector<dType>{100, 50, 25, 12.5};
+
+    EXPECT_FALSE(common::utils::is_loss_trajectory_dominated(losses.begin(), losses.end(), static_cast<dType>(0)));
+    EXPECT_TRUE(common::utils::is_loss_trajectory_dominated(losses.begin(), losses.end(), static_cast<dType>(-30)));
+    // not enough losses to extrapolate
+    EXPECT_FALSE(
+        common::utils::is_loss_trajectory_dominated(losses.begin(), losses.end() - 1, static_cast<dType>(-30)));
+    // a loss that went up doesnt mean that the candidate has converged
+    const auto non_monotone_losses = std::vector<dType>{100, 50, 25, 30};
+
+    EXPECT_FALSE(common::utils::is_loss_trajectory_dominated(
+        non_monotone_losses.begin(), non_monotone_losses.end(), static_cast<dType>(0)));
+    // a loss that stopped changing above the best loss can't win anymore
+    const auto converged_losses_trajectory = std::vector<dType>{100, 50, 25, 25};
+
+    EXPECT_TRUE(common::utils::is_loss_trajectory_dominated(
+        converged_losses_trajectory.begin(), converged_losses_trajectory.end(), static_cast<dType>(0)));
+
+    const std::size_t n_samples   = 3000;
+    const std::size_t n_features  = 4;
+    const std::size_t n_centroids = 10;
+    const std::size_t n_init      = 8;
+
+    const auto data = generate_flattened_matrix<dType>(n_samples, n_features, -10, 10);
+
+    // the same initial candidates with and without racing
+    auto centroids_candidates = std::vector<std::vector<dType>>();
+
+    for (std::size_t k = 0; k < n_init; ++k) {
+        centroids_candidates.emplace_back(
+            cpp_clustering::kmeansplusplus::make_centroids(data.begin(), data.end(), n_centroids, n_features));
+    }
+    std::size_t candidate_index = 0;
+
+    const auto centroids_initializer = [&](const auto&, const auto&, std::size_t, std::size_t) {
+        return centroids_candidates[candidate_index++ % n_init];
+    };
+    const auto loss = [&data, n_features](const std::vector<dType>& centroids) {
+        const auto nearest_centroid_distances =
+            kmeans::utils::samples_to_nearest_centroid_distances(data.begin(), data.end(), n_features, centroids);
+
+        return std::reduce(nearest_centroid_distances.begin(), nearest_centroid_distances.end(), static_cast<dType>(0));
+    };
+    auto kmeans_racing = KMeans(n_centroids, n_features, KMeans::Options().max_iter(100).n_init(n_init).racing(true));
+    auto kmeans        = KMeans(n_centroids, n_features, KMeans::Options().max_iter(100).n_init(n_init));
+
+    const auto centroids_racing =
+        kmeans_racing.fit<cpp_clustering::Lloyd>(data.begin(), data.end(), centroids_initializer);
+    const auto centroids = kmeans.fit<cpp_clustering::Lloyd>(data.begin(), data.end(), centroids_initializer);
+
+    ASSERT_EQ(centroids_racing.size(), n_centroids * n_features);
+
+    // racing only stops the candidates whose extrapolated loss cant win anymore so it ends close to the best converged
+    // candidate
+    EXPECT_LE(loss(centroids_racing), (1 + static_cast<dType>(2e-2)) * loss(centroids));
+
+    // each candidate run alone until convergence against the same candidate in the race
+    auto kmeans_algorithms = std::vector<std::unique_ptr<Lloyd>>();
+    auto converged_losses  = std::vector<dType>();
+
+    for (const auto& centroids_candidate : centroids_candidates) {
+        kmeans_algorithms.emplace_back(
+            std::make_unique<Lloyd>(std::make_tuple(data.cbegin(), data.cend(), n_features), centroids_candidate));
+
+        auto kmeans_algorithm = Lloyd({data.cbegin(), data.cend(), n_features}, centroids_candidate);
+
+        for (std::size_t iter = 0; iter < 100; ++iter) {
+            kmeans_algorithm.step();
+
+            if (kmeans_algorithm.max_centroid_shift() <= 0) {
+                break;
+            }
+        }
+        converged_losses.emplace_back(kmeans_algorithm.total_deviation());
+    }
+    auto race_centroids_candidates = centroids_candidates;
+
+    const auto race_losses =
+        common::utils::race_candidates(kmeans_algorithms, race_centroids_candidates, 100, true, 0);
+
+    // at least one candidate was stopped before it converged
+    bool has_stopped_early = false;
+
+    for (std::size_t k = 0; k < n_init; ++k) {
+        has_stopped_early |= race_losses[k] > converged_losses[k] * (1 + static_cast<dType>(1e-3));
+    }
+    EXPECT_TRUE(has_stopped_early);
+}
+
+TEST_F(KMeansErrorsTest, HamerlyRacingTest) {
+    using KMeans  = cpp_clustering::KMeans<dType>;
+    using Hamerly = cpp_clustering::Hamerly<std::vector<dType>::const_iterator>;
+
+    const std::size_t n_samples   = 3000;
+    const std::size_t n_features  = 4;
+    const std::size_t n_centroids = 10;
+    const std::size_t n_init      = 8;
+
+    const auto data = generate_flattened_matrix<dType>(n_samples, n_features, -10, 10);
+
+    auto centroids_candidates = std::vector<std::vector<dType>>();
+
+    for (std::size_t k = 0; k < n_init; ++k) {
+        centroids_candidates.emplace_back(
+            cpp_clustering::kmeansplusplus::make_centroids(data.begin(), data.end(), n_centroids, n_features));
+    }
+    std::size_t candidate_index = 0;
+
+    const auto centroids_initializer = [&](const auto&, const auto&, std::size_t, std::size_t) {
+        return centroids_candidates[candidate_index++ % n_init];
+    };
+    const auto loss = [&data, n_features](const std::vector<dType>& centroids) {
+        const auto nearest_centroid_distances =
+            kmeans::utils::samples_to_nearest_centroid_distances(data.begin(), data.end(), n_features, centroids);
+
+        return std::reduce(nearest_centroid_distances.begin(), nearest_centroid_distances.end(), static_cast<dType>(0));
+    };
+    auto kmeans_racing = KMeans(n_centroids, n_features, KMeans::Options().max_iter(100).n_init(n_init).racing(true));
+    auto kmeans        = KMeans(n_centroids, n_features, KMeans::Options().max_iter(100).n_init(n_init));
+
+    const auto centroids_racing =
+        kmeans_racing.fit<cpp_clustering::Hamerly>(data.begin(), data.end(), centroids_initializer);
+    const auto centroids = kmeans.fit<cpp_clustering::Hamerly>(data.begin(), data.end(), centroids_initializer);
+
+    ASSERT_EQ(centroids_racing.size(), n_centroids * n_features);
+
+    EXPECT_LE(loss(centroids_racing), (1 + static_cast<dType>(2e-2)) * loss(centroids));
+
+    // the race compares the exact losses, not the ones maintained from the upper bounds
+    auto kmeans_algorithms = std::vector<std::unique_ptr<Hamerly>>();
+
+    for (const auto& centroids_candidate : centroids_candidates) {
+        kmeans_algorithms.emplace_back(
+            std::make_unique<Hamerly>(std::make_tuple(data.cbegin(), data.cend(), n_features), centroids_candidate));
+    }
+    auto race_centroids_candidates = centroids_candidates;
+
+    const auto race_losses =
+        common::utils::race_candidates(kmeans_algorithms, race_centroids_candidates, 100, true, 0);
+
+    // the best candidate is never stopped before it converges so its loss is the one of its final centroids
+    const std::size_t min_loss_index = common::utils::argmin(race_losses.begin(), race_losses.end());
+
+    EXPECT_NEAR(race_losses[min_loss_index],
+                loss(race_centroids_candidates[min_loss_index]),
+                static_cast<dType>(1e-3) * race_losses[min_loss_index]);
+}
+
+template <template <typename> class KMeansAlgorithm>
+std::vector<KMeansErrorsTest::dType> fit_with(cpp_clustering::KMeans<KMeansErrorsTest::dType>& kmeans,
+                                              const std::vector<KMeansErrorsTest::dType>&     data) {
+    return kmeans.fit<KMeansAlgorithm>(data.begin(), data.end());
+}
+
+// an algorithm that only prunes computations of a reference algorithm, so that both converge to the same centroids from
+// the same initial centroids
+struct KMeansConsistencyParams {
+    using FitFunction = std::vector<KMeansErrorsTest::dType> (*)(cpp_clustering::KMeans<KMeansErrorsTest::dType>&,
+                                                                 const std::vector<KMeansErrorsTest::dType>&);
+
+    const char* name;
+    std::size_t n_samples;
+    std::size_t n_features;
+    std::size_t n_centroids;
+    FitFunction fit_reference;
+    FitFunction fit_accelerated;
+};
+
+class KMeansConsistencyTest : public KMeansErrorsTest,
+                              public ::testing::WithParamInterface<KMeansConsistencyParams> {};
+
+TEST_P(KMeansConsistencyTest, SameCentroidsAsReferenceTest) {
+    using KMeans = cpp_clustering::KMeans<dType>;
+
+    const auto& params = GetParam();
+
+    const auto data = generate_flattened_matrix<dType>(params.n_samples, params.n_features, -10, 10);
+    // same initial centroids for each algorithm
+    const auto centroids_init =
+        std::vector<dType>(data.begin(), data.begin() + params.n_centroids * params.n_features);
+
+    const auto options = KMeans::Options().max_iter(30);
+
+    auto kmeans_reference   = KMeans(params.n_centroids, params.n_features, centroids_init, options);
+    auto kmeans_accelerated = KMeans(params.n_centroids, params.n_features, centroids_init, options);
+
+    const auto centroids_reference   = params.fit_reference(kmeans_reference, data);
+    const auto centroids_accelerated = params.fit_accelerated(kmeans_accelerated, data);
+
+    EXPECT_TRUE(
+        common::utils::are_containers_equal(centroids_reference, centroids_accelerated, static_cast<dType>(1e-3)));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    KMeansAlgorithms,
+    KMeansConsistencyTest,
+    ::testing::Values(
+        KMeansConsistencyParams{
+            "ElkanHamerly", 3000, 32, 24, fit_with<cpp_clustering::Hamerly>, fit_with<cpp_clustering::Elkan>},
+        // enough centroids to make several groups
+        KMeansConsistencyParams{
+            "YinyangHamerly", 3000, 16, 64, fit_with<cpp_clustering::Hamerly>, fit_with<cpp_clustering::Yinyang>},
+        KMeansConsistencyParams{"KDTreeFilteringLloyd",
+                                2000,
+                                3,
+                                16,
+                                fit_with<cpp_clustering::Lloyd>,
+                                fit_with<cpp_clustering::KDTreeFiltering>}),
+    [](const ::testing::TestParamInfo<KMeansConsistencyParams>& info) { return std::string(info.param.name); });
+
+#if defined(_OPENMP) && THREADS_ENABLED == true
+TEST_F(KMeansErrorsTest, HamerlyThreadsConsistencyTest) {
+    using KMeans = cpp_clustering::KMeans<dType>;
+
+    const std::size_t n_samples   = 5000;
+    const std::size_t n_features  = 8;
+    const std::size_t n_centroids = 16;
+
+    const auto data = generate_flattened_matrix<dType>(n_samples, n_features, -10, 10);
+    // same initial centroids for each run
+    const auto centroids_init = std::vector<dType>(data.begin(), data.begin() + n_centroids * n_features);
+
+    const int n_threads_default = omp_get_max_threads();
+
+    auto fit_with_n_threads = [&](int n_threads) {
+        omp_set_num_threads(n_threads);
+
+        auto kmeans = KMeans(n_centroids, n_features, centroids_init, KMeans::Options().max_iter(30));
+
+        return kmeans.fit<cpp_clustering::Hamerly>(data.begin(), data.end());
+    };
+    const auto centroids_single_thread = fit_with_n_threads(1);
+    const auto centroids_multi_thread  = fit_with_n_threads(4);
+
+    omp_set_num_threads(n_threads_default);
+
+    EXPECT_EQ(centroids_single_thread, centroids_multi_thread);
+}
+#endif
+
 int main(int argc, char** argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
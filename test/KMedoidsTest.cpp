@@ -337,6 +337,138 @@ TEST_F(KMedoidsErrorsTest, PairwiseDistanceMatrixTest) {
         cpp_clustering::containers::LowerTriangleMatrix<decltype(data.begin())>(data.begin(), data.end(), n_features);
 }
 
+TEST_F(KMedoidsErrorsTest, DatasetHandleTest) {
+    fs::path filename = "iris.txt";
+
+    const auto        data       = load_data<dType>(inputs_folder / filename, ' ');
+    const std::size_t n_features = get_num_features_in_file(inputs_folder / filename);
+    const std::size_t n_medoids  = 3;
+
+    const auto dataset = cpp_clustering::containers::DatasetHandle(data.begin(), data.end(), n_features);
+
+    using LowerTriangleMatrix = cpp_clustering::containers::LowerTriangleMatrix<std::vector<dType>::const_iterator>;
+
+    const auto pairwise_distance_matrix = LowerTriangleMatrix::from_handle(dataset);
+
+    ASSERT_EQ(pairwise_distance_matrix.n_samples(), dataset.n_samples());
+
+    // the dataset descriptor constructor still accepts a braced descriptor
+    const auto descriptor_pairwise_distance_matrix = LowerTriangleMatrix{{data.begin(), data.end(), n_features}};
+
+    EXPECT_EQ(descriptor_pairwise_distance_matrix(1, 0), pairwise_distance_matrix(1, 0));
+
+    // same medoids as with the iterators for the same initial medoids
+    const auto medoids_init = std::vector<std::size_t>{0, 1, 2};
+
+    auto kmedoids_iterators = cpp_clustering::KMedoids<dType>(n_medoids, n_features, medoids_init);
+    auto kmedoids_dataset   = cpp_clustering::KMedoids<dType>(n_medoids, n_features, medoids_init);
+
+    EXPECT_TRUE(common::utils::are_containers_equal(kmedoids_iterators.fit(data.begin(), data.end()),
+                                                    kmedoids_dataset.fit(dataset)));
+
+    EXPECT_TRUE(common::utils::are_containers_equal(kmedoids_iterators.predict(data.begin(), data.end()),
+                                                    kmedoids_dataset.predict(dataset)));
+
+    // a handle with another number of features is rejected
+    const auto mismatched_dataset = cpp_clustering::containers::DatasetHandle(data.begin(), data.end(), 1);
+
+    EXPECT_THROW(kmedoids_dataset.fit(mismatched_dataset), std::invalid_argument);
+    EXPECT_THROW(kmedoids_dataset.predict(mismatched_dataset), std::invalid_argument);
+}
+
+TEST_F(KMedoidsErrorsTest, DatasetTest) {
+    fs::path filename = "iris.txt";
+
+    const auto        iris_data       = load_data<dType>(inputs_folder / filename, ' ');
+    const std::size_t iris_n_features = get_num_features_in_file(inputs_folder / filename);
+    const std::size_t n_samples       = iris_data.size() / iris_n_features;
+    const std::size_t n_medoids       = 3;
+
+    // the features are repeated so that the rows are wide enough to be padded
+    const std::size_t n_features = 5 * iris_n_features;
+
+    auto data = std::vector<dType>();
+
+    for (std::size_t sample_index = 0; sample_index < n_samples; ++sample_index) {
+        for (std::size_t repeat = 0; repeat < 5; ++repeat) {
+            data.insert(data.end(),
+                        iris_data.begin() + sample_index * iris_n_features,
+                        iris_data.begin() + sample_index * iris_n_features + iris_n_features);
+        }
+    }
+    const auto dataset = cpp_clustering::containers::Dataset<dType>(data.begin(), data.end(), n_features);
+
+    ASSERT_GT(dataset.padded_n_features(), n_features);
+
+    // same medoids as with the packed rows for the same initial medoids
+    const auto medoids_init = std::vector<std::size_t>{0, 1, 2};
+
+    auto kmedoids_packed = cpp_clustering::KMedoids<dType>(n_medoids, n_features, medoids_init);
+    auto kmedoids_padded = cpp_clustering::KMedoids<dType>(n_medoids, n_features, medoids_init);
+
+    EXPECT_TRUE(common::utils::are_containers_equal(kmedoids_packed.fit(data.begin(), data.end()),
+                                                    kmedoids_padded.fit(dataset)));
+
+    EXPECT_TRUE(common::utils::are_containers_equal(kmedoids_packed.predict(data.begin(), data.end()),
+                                                    kmedoids_padded.predict(dataset)));
+
+    // a dataset with another number of features is rejected
+    const auto mismatched_dataset = cpp_clustering::containers::Dataset<dType>(data.begin(), data.end(), 1);
+
+    EXPECT_THROW(kmedoids_padded.fit(mismatched_dataset), std::invalid_argument);
+    EXPECT_THROW(kmedoids_padded.predict(mismatched_dataset), std::invalid_argument);
+}
+
+TEST_F(KMedoidsErrorsTest, RacingTest) {
+    fs::path filename = "iris.txt";
+
+    const auto        data       = load_data<dType>(inputs_folder / filename, ' ');
+    const std::size_t n_features = get_num_features_in_file(inputs_folder / filename);
+    const std::size_t n_samples  = data.size() / n_features;
+    const std::size_t n_medoids  = 3;
+    const std::size_t n_init     = 8;
+
+    using FasterPAM           = cpp_clustering::FasterPAM<std::vector<dType>::const_iterator>;
+    using LowerTriangleMatrix = cpp_clustering::containers::LowerTriangleMatrix<std::vector<dType>::const_iterator>;
+
+    const auto pairwise_distance_matrix = LowerTriangleMatrix{{data.cbegin(), data.cend(), n_features}};
+
+    // the winner of a race is never stopped before it converges so one more step from its medoids cant improve it
+    const auto expect_converged_medoids = [&](const std::vector<std::size_t>& medoids) {
+        ASSERT_EQ(medoids.size(), n_medoids);
+
+        auto sorted_medoids = medoids;
+        std::sort(sorted_medoids.begin(), sorted_medoids.end());
+
+        EXPECT_EQ(std::adjacent_find(sorted_medoids.begin(), sorted_medoids.end()), sorted_medoids.end());
+        EXPECT_LT(sorted_medoids.back(), n_samples);
+
+        auto       kmedoids_algorithm = FasterPAM(pairwise_distance_matrix, medoids);
+        const auto loss               = kmedoids_algorithm.total_deviation();
+
+        kmedoids_algorithm.step();
+
+        EXPECT_NEAR(kmedoids_algorithm.total_deviation(), loss, static_cast<dType>(1e-5) * loss);
+    };
+    using KMedoids         = cpp_clustering::KMedoids<dType>;
+    using KMedoidsNoMatrix = cpp_clustering::KMedoids<dType, false>;
+
+    // the iterators overload with and without the precomputed pairwise distance matrix
+    auto kmedoids_iterators =
+        KMedoids(n_medoids, n_features, KMedoids::Options().max_iter(100).n_init(n_init).racing(true));
+    auto kmedoids_no_matrix =
+        KMedoidsNoMatrix(n_medoids, n_features, KMedoidsNoMatrix::Options().max_iter(100).n_init(n_init).racing(true));
+
+    expect_converged_medoids(kmedoids_iterators.fit(data.cbegin(), data.cend()));
+    expect_converged_medoids(kmedoids_no_matrix.fit(data.cbegin(), data.cend()));
+
+    // the pairwise distance matrix overload
+    auto kmedoids_matrix =
+        KMedoids(n_medoids, n_features, KMedoids::Options().max_iter(100).n_init(n_init).racing(true));
+
+    expect_converged_medoids(kmedoids_matrix.fit(pairwise_distance_matrix));
+}
+
 /*
 TEST_F(KMedoidsErrorsTest, MnistTrainTest) {
     fs::path filename = "mnist_train.txt";